@@ -26,6 +26,7 @@ OTHER_FILES+= shaders/PhongFragment.glsl \
 CONFIG += console
 CONFIG -= app_bundle
 CONFIG+=c++11
+CONFIG += thread
 
 # use this to suppress some warning from boost
 QMAKE_CXXFLAGS_WARN_ON += "-Wno-unused-parameter"
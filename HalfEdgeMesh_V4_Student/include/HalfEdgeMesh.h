@@ -11,6 +11,12 @@
 #include <list>
 #include <string>
 #include <memory>
+#include <unordered_map>
+#include <utility>
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <functional>
 #include <ngl/Vec3.h>
 #include <ngl/Vec4.h>
 #include <ngl/BBox.h>
@@ -26,32 +32,36 @@
 /// @version 1.0
 /// @date 11/01/13
 //----------------------------------------------------------------------------------------------------------------------
-struct HE_FACE;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the half edges, faces and vertices refer to each other by 32 bit indices into the contiguous lists of
+/// HalfEdgeMesh, HE_NULL is the index of nothing (the dual of a boundary half edge)
+//----------------------------------------------------------------------------------------------------------------------
+const unsigned int HE_NULL = 0xffffffff;
 
 typedef struct HALFEDGE {
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief reference to the vertex this halfedge pointed to, index into the vert list
     //----------------------------------------------------------------------------------------------------------------------
-    unsigned            m_toVertex;
+    unsigned int        m_toVertex;
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief reference to the face it belongs to
+    /// @brief reference to the face it belongs to, index into the face list
     //----------------------------------------------------------------------------------------------------------------------
-    struct HE_FACE      *m_face;
+    unsigned int        m_face;
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief reference to the next halfedge in the same face
+    /// @brief reference to the next halfedge in the same face, index into the halfedge list
     //----------------------------------------------------------------------------------------------------------------------
-    struct HALFEDGE     *m_next;
+    unsigned int        m_next;
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief reference to opposite halfedgem_verts[oneRingNeigh[next]].m_vert - itr->m_vert)
+    /// @brief reference to opposite halfedge, index into the halfedge list
     //----------------------------------------------------------------------------------------------------------------------
-    struct HALFEDGE     *m_dual;
+    unsigned int        m_dual;
 } HalfEdge;
 
 typedef struct HE_VERTEX{
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief reference one outgoing halfedge
+    /// @brief reference one outgoing halfedge, index into the halfedge list
     //----------------------------------------------------------------------------------------------------------------------
-    HalfEdge    *m_outHalfEdge;
+    unsigned int m_outHalfEdge;
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief vertex coordinate
     //----------------------------------------------------------------------------------------------------------------------
@@ -70,13 +80,99 @@ typedef struct HE_VERTEX{
 
 typedef struct HE_FACE {
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief reference one halfedge bounding it
+    /// @brief reference the first halfedge bounding it, the halfedges of a face are next to each other in the list
     //----------------------------------------------------------------------------------------------------------------------
-    HalfEdge    *m_halfEdge;
-    /// @brief flag for parsing
-    bool        flag;
+    unsigned int m_halfEdge;
 } HE_Face;
 
+//----------------------------------------------------------------------------------------------------------------------
+/// @class OneRingCirculator "include/HalfEdgeMesh.h"
+/// @brief walks round a vertex over its outgoing halfedges, one for each face of its one ring, straight out of the
+/// halfedge list so nothing is copied or allocated. On a boundary the walk starts at the halfedge next to the gap
+/// and stops at the other side of it, so every face is still visited once, an isolated vertex has nothing to visit
+//----------------------------------------------------------------------------------------------------------------------
+class OneRingCirculator
+{
+public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief start at _outHalfEdge, the m_outHalfEdge of the vertex, or at the start of the ring if it is open
+    //----------------------------------------------------------------------------------------------------------------------
+    OneRingCirculator(const std::vector<HalfEdge> &_halfEdges, unsigned int _outHalfEdge) :
+        m_halfEdges(&_halfEdges), m_first(_outHalfEdge), m_current(_outHalfEdge), m_open(false)
+    {
+        if(m_first == HE_NULL)
+            return;
+        // go back round until the start again, or until the halfedge coming in has no dual
+        unsigned int dual;
+        do
+        {
+            dual = (*m_halfEdges)[previous(m_current)].m_dual;
+            if(dual == HE_NULL)
+            {
+                m_open = true;
+                break;
+            }
+            m_current = dual;
+        } while(m_current != m_first);
+        m_first = m_current;
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief false once the walk has been all the way round
+    //----------------------------------------------------------------------------------------------------------------------
+    inline bool valid() const {return m_current != HE_NULL;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief true if the vertex is on a boundary, there is a gap in the ring between the last face and the first
+    //----------------------------------------------------------------------------------------------------------------------
+    inline bool isOpen() const {return m_open;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the current outgoing halfedge
+    //----------------------------------------------------------------------------------------------------------------------
+    inline unsigned int halfEdge() const {return m_current;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the neighbour the current halfedge points to
+    //----------------------------------------------------------------------------------------------------------------------
+    inline unsigned int vertex() const {return (*m_halfEdges)[m_current].m_toVertex;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the neighbour before it round the vertex, the one the halfedge coming into the vertex in the same face
+    /// starts from. For a triangle that and vertex() are the other two corners of the face
+    //----------------------------------------------------------------------------------------------------------------------
+    inline unsigned int previousVertex() const
+    {
+        unsigned int he = m_current;
+        while((*m_halfEdges)[(*m_halfEdges)[he].m_next].m_next != m_current)
+            he = (*m_halfEdges)[he].m_next;
+        return (*m_halfEdges)[he].m_toVertex;
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief on to the outgoing halfedge of the next face, across the dual of the current one
+    //----------------------------------------------------------------------------------------------------------------------
+    inline OneRingCirculator &operator++()
+    {
+        const unsigned int dual = (*m_halfEdges)[m_current].m_dual;
+        m_current = dual == HE_NULL ? HE_NULL : (*m_halfEdges)[dual].m_next;
+        if(m_current == m_first)
+            m_current = HE_NULL;
+        return *this;
+    }
+
+private :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the halfedge before _he in its face
+    //----------------------------------------------------------------------------------------------------------------------
+    inline unsigned int previous(unsigned int _he) const
+    {
+        unsigned int he = _he;
+        while((*m_halfEdges)[he].m_next != _he)
+            he = (*m_halfEdges)[he].m_next;
+        return he;
+    }
+
+    const std::vector<HalfEdge> *m_halfEdges;
+    unsigned int m_first;
+    unsigned int m_current;
+    bool m_open;
+};
+
 
 
 // a simple structure to hold our vertex data
@@ -102,7 +198,7 @@ public :
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief default constructor
     //----------------------------------------------------------------------------------------------------------------------
-    HalfEdgeMesh(): m_vao(false){;}
+    HalfEdgeMesh(): m_vao(false){setNumThreads(0);}
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief  constructor to load an objMesh as a parameter
     /// @param[in]  &_objMesh obj mesh
@@ -137,7 +233,17 @@ public :
     //----------------------------------------------------------------------------------------------------------------------
     inline ngl::Vec3 getCenter() const {return m_center;}
 
-    /// @brief free all the memory allocated for Maintaining the HalfEdge Data Structure
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set the number of worker threads the per vertex passes (normals, curvature and its colours) are split
+    /// over, 1 runs them on the calling thread. Every vertex is worked out on its own so the results are the same
+    /// for any number
+    /// @param[in] _n number of threads, 0 uses the number of hardware threads
+    //----------------------------------------------------------------------------------------------------------------------
+    void setNumThreads(unsigned int _n);
+    unsigned int getNumThreads() const {return m_numThreads;}
+
+    /// @brief free all the memory allocated for Maintaining the HalfEdge Data Structure, it is all in the three
+    /// lists so there is nothing to walk
     void deleteHalfEdgeDataStructure();
 
     /// @brief compute the normal of each vertex
@@ -153,10 +259,24 @@ public :
     /// @brief Mapping curvature to color
     void mapCurvaturetoColor();
 
-    /// @brief find one ring neighbour
+    /// @brief find one ring neighbour, in order round the vertex. The compute methods walk the ring with a
+    /// OneRingCirculator instead so they don't make a list for every vertex
     std::vector<unsigned int> findOneRingNeighbours(unsigned int _indexOfVertex);
 
 protected :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the number of blocks parallelFor splits _n vertices into, so there aren't threads for tiny meshes
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int numBlocks(size_t _n) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief call _work(block, begin, end) for numBlocks(_n) runs of vertices in [0,_n), one on each thread and the
+    /// first on the calling one, and wait for them all
+    //----------------------------------------------------------------------------------------------------------------------
+    void parallelFor(size_t _n, const std::function<void(unsigned int, size_t, size_t)> &_work) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief worker threads used by the per vertex passes
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_numThreads;
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief The number of vertices in the object
     //----------------------------------------------------------------------------------------------------------------------
@@ -166,6 +286,11 @@ protected :
     //----------------------------------------------------------------------------------------------------------------------
     std::vector<HE_Vertex> m_verts;
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief all the halfedges, the ones of each face in order, and all the faces
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<HalfEdge> m_halfEdges;
+    std::vector<HE_Face> m_faces;
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief Center of the object
     //----------------------------------------------------------------------------------------------------------------------
     ngl::Vec3 m_center;
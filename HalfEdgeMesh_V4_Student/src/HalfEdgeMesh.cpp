@@ -13,10 +13,11 @@
 
 HalfEdgeMesh::HalfEdgeMesh(ngl::Obj* _objMesh)
 {
-    unsigned int i, j;
+    unsigned int i;
 
     m_vbo=false;
     m_vao=false;
+    setNumThreads(0);
     m_ext=new ngl::BBox(_objMesh->getBBox());
     m_nVerts=_objMesh->getNumVerts();
     m_center = _objMesh->getCenter();
@@ -26,78 +27,72 @@ HalfEdgeMesh::HalfEdgeMesh(ngl::Obj* _objMesh)
     HE_Vertex tVertex;
     std::vector<ngl::Vec3> verts = _objMesh->getVertexList();
 
+    m_verts.reserve(m_nVerts);
     for(i=0; i< m_nVerts; i++)
     {
         tVertex.m_vert = verts[i];
-        tVertex.m_outHalfEdge = NULL;
+        tVertex.m_outHalfEdge = HE_NULL;
         m_verts.push_back(tVertex);
     }
 
-    // parsing through face list to create HE_Face, HalfEdge structure, set m_outHalfEdge in Vertex
-    unsigned int numVertexInFace;
-    // keep a temporary record of all HE_Face
-    std::vector<HE_Face *> tFaceList;
+    // parsing through face list to create HE_Face, HalfEdge structure, set m_outHalfEdge in Vertex. The halfedges
+    // of a face go into the list one after the other and everything is linked by index, so the whole structure
+    // is three allocations however big the mesh is
+    unsigned int numVertexInFace, first;
     std::vector<ngl::Face> objFaceList = _objMesh->getFaceList();
+    size_t numHalfEdges = 0;
     for(std::vector<ngl::Face>::iterator itr=objFaceList.begin(); itr!=objFaceList.end(); ++itr)
+        numHalfEdges += itr->m_vert.size();
+    m_faces.resize(objFaceList.size());
+    m_halfEdges.resize(numHalfEdges);
+    HE_Face *newFace = m_faces.empty() ? 0 : &m_faces[0];
+    first = 0;
+    for(std::vector<ngl::Face>::iterator itr=objFaceList.begin(); itr!=objFaceList.end(); ++itr, ++newFace)
     {
         numVertexInFace = itr->m_vert.size();
-        HE_Face *newFace = new HE_FACE;
-        HalfEdge *newHEList = new HalfEdge[numVertexInFace];
+        HalfEdge *newHEList = &m_halfEdges[first];
         for(i=0;i<numVertexInFace;i++)
         {
-            newHEList[i].m_face = newFace;
-            newHEList[i].m_next = &newHEList[(i==numVertexInFace-1)?0:i+1];
-            newHEList[i].m_dual = NULL;
+            newHEList[i].m_face = newFace-&m_faces[0];
+            newHEList[i].m_next = first+((i==numVertexInFace-1)?0:i+1);
+            newHEList[i].m_dual = HE_NULL;
             newHEList[i].m_toVertex = itr->m_vert[(i==numVertexInFace-1)?0:i+1];
-            if(m_verts[itr->m_vert[i]].m_outHalfEdge==NULL)
-                m_verts[itr->m_vert[i]].m_outHalfEdge = &newHEList[i];
+            if(m_verts[itr->m_vert[i]].m_outHalfEdge==HE_NULL)
+                m_verts[itr->m_vert[i]].m_outHalfEdge = first+i;
         }
-        newFace->m_halfEdge = &newHEList[0];
-        newFace->flag = false;
-        tFaceList.push_back(newFace);
+        newFace->m_halfEdge = first;
+        first += numVertexInFace;
     }
 
-    // create the dual halfedge
+    // create the dual halfedge, an edge is keyed on its two vertices (the lower index first) so both halves of it
+    // land in the same slot of the map, the first half waits there until its dual comes along and takes it out
     unsigned long int startV, endV;
-    unsigned int numVertexInFace1;
-    std::vector<HE_Face*>::iterator itrHE= tFaceList.begin();
+    unsigned long long key;
+    std::unordered_map<unsigned long long, unsigned int> openEdges;
+    openEdges.reserve(numHalfEdges/2+1);
+    unsigned int tHE = 0;
     for(std::vector<ngl::Face>::iterator itr=objFaceList.begin(); itr!=objFaceList.end(); ++itr)
     {
         numVertexInFace = itr->m_vert.size();
-        HalfEdge *tHE = (*itrHE)->m_halfEdge;
-        for(i=0;i<numVertexInFace;i++)
+        for(i=0;i<numVertexInFace;i++, tHE++)
         {
-            if(tHE->m_dual!= NULL)
-            {
-                tHE = tHE->m_next;
-                continue;
-            }
             startV = itr->m_vert[i];
             endV = itr->m_vert[(i==numVertexInFace-1)?0:i+1];
-            std::vector<HE_Face*>::iterator itrHE1= tFaceList.begin();
-            for(std::vector<ngl::Face>::iterator itr1=objFaceList.begin(); itr1!=objFaceList.end(); ++itr1)
+            key = (unsigned long long)std::min(startV, endV)<<32 | std::max(startV, endV);
+            std::pair<std::unordered_map<unsigned long long, unsigned int>::iterator, bool> open =
+                    openEdges.insert(std::make_pair(key, tHE));
+            // only the half going the other way is the dual, the same way twice is a badly oriented face
+            if(!open.second && m_halfEdges[open.first->second].m_toVertex == startV)
             {
-                numVertexInFace1 = itr1->m_vert.size();
-                HalfEdge *tHE1 = (*itrHE1)->m_halfEdge;
-                for(j=0;j<numVertexInFace1;j++)
-                {
-                    if(endV == itr1->m_vert[j] && startV == itr1->m_vert[(j==numVertexInFace1-1)?0:j+1])
-                    {
-                        tHE->m_dual = tHE1;
-                        tHE1->m_dual = tHE;
-                    }
-                    tHE1 = tHE1->m_next;
-                }
-                itrHE1++;
+                m_halfEdges[tHE].m_dual = open.first->second;
+                m_halfEdges[open.first->second].m_dual = tHE;
+                openEdges.erase(open.first);
             }
-            tHE = tHE->m_next;
         }
-        itrHE++;
     }
 
     // loading data finished
     m_loaded=true;
-    tFaceList.erase(tFaceList.begin(), tFaceList.end());
     objFaceList.erase(objFaceList.begin(), objFaceList.end());
 
     // compute the vertex normal
@@ -140,281 +135,215 @@ HalfEdgeMesh::~HalfEdgeMesh()
 
 void HalfEdgeMesh::deleteHalfEdgeDataStructure()
 {
-    unsigned int i;
-
-    std::vector<bool> vertexVisited(m_nVerts, false);
-    unsigned int numVertexVisited = 0;
-    while(numVertexVisited< m_nVerts)
-    {
-        // find the first vertex not visited yet
-        std::vector<bool>::iterator itrVV = vertexVisited.begin();
-        i=0;
-        while(*itrVV)
-        {
-            itrVV++; // it must stop before m_nVerts
-            i++;
-        }
-        HE_Face *tFace = m_verts[i].m_outHalfEdge->m_face;
-        bool oldFlag = tFace->flag;
-        bool newFlag = oldFlag?false:true;
-
-        std::vector<HE_Face *> faceList;
-        std::vector<HalfEdge *> HElist;
+    // swapping with empty lists gives the memory back, clear would keep it
+    std::vector<HalfEdge>().swap(m_halfEdges);
+    std::vector<HE_Face>().swap(m_faces);
+    m_verts.erase(m_verts.begin(), m_verts.end());
+}
 
-        std::queue<HE_Face *> workingList;
-        workingList.push(tFace);
-        tFace->flag = newFlag;
+void HalfEdgeMesh::setNumThreads(unsigned int _n)
+{
+    if(_n == 0)
+        _n = std::thread::hardware_concurrency();
+    // hardware_concurrency is allowed to return 0 if it can't tell
+    m_numThreads = _n > 0 ? _n : 1;
+}
 
-        HE_Face *front;
-        HalfEdge    *tHE, *startHE;
-        while(!workingList.empty())
-        {
-            front = workingList.front();
-            startHE = front->m_halfEdge;
-            HElist.push_back(startHE);
-            if(startHE->m_dual->m_face->flag==oldFlag)
-            {
-                workingList.push(startHE->m_dual->m_face);
-                startHE->m_dual->m_face->flag = newFlag;
-            }
-            printf("%d (%d)", startHE->m_toVertex, startHE->m_dual->m_toVertex);// debug purpose
-            if(!vertexVisited[startHE->m_toVertex])
-            {
-                vertexVisited[startHE->m_toVertex]=true;
-                numVertexVisited++;
-            }
-            tHE = startHE->m_next;
-            while(tHE!=startHE)
-            {
-                if(tHE->m_dual->m_face->flag==oldFlag)
-                {
-                    workingList.push(tHE->m_dual->m_face);
-                    tHE->m_dual->m_face->flag = newFlag;
-                }
-                printf("%d (%d)", tHE->m_toVertex, tHE->m_dual->m_toVertex); // debug purpose
-                if(!vertexVisited[tHE->m_toVertex])
-                {
-                    vertexVisited[tHE->m_toVertex]=true;
-                    numVertexVisited++;
-                }
-                HElist.push_back(tHE);
-                tHE=tHE->m_next;
-            }
-            printf("\n");
-            workingList.pop();
-            faceList.push_back(front);
-        }
+unsigned int HalfEdgeMesh::numBlocks(size_t _n) const
+{
+    // a thread costs about as much as working out a thousand vertices
+    return (unsigned int)std::max<size_t>(1, std::min<size_t>(m_numThreads, _n/1024));
+}
 
-        for(std::vector<HE_Face *>::iterator itr= faceList.begin(); itr!=faceList.end(); itr++)
-            delete (*itr);
-        for(std::vector<HalfEdge *>::iterator itr1 = HElist.begin(); itr1!=HElist.end(); itr1++)
-            delete (*itr1);
-        faceList.erase(faceList.begin(), faceList.end());
-        HElist.erase(HElist.begin(),HElist.end());
+void HalfEdgeMesh::parallelFor(size_t _n, const std::function<void(unsigned int, size_t, size_t)> &_work) const
+{
+    const unsigned int nBlocks = numBlocks(_n);
+    // runs of neighbouring vertices rather than every nth one, so the threads don't write to the same cache lines
+    std::vector<std::thread> workers;
+    for(unsigned int b=1;b<nBlocks;b++)
+    {
+        workers.push_back(std::thread(_work, b, _n*b/nBlocks, _n*(b+1)/nBlocks));
+    }
+    _work(0, 0, _n/nBlocks);
+    for(size_t w=0;w<workers.size();w++)
+    {
+        workers[w].join();
     }
-
-    vertexVisited.erase(vertexVisited.begin(), vertexVisited.end());
-    m_verts.erase(m_verts.begin(), m_verts.end());
 }
 
 void HalfEdgeMesh::computeVertexNormal()
 {
-    unsigned int j=0;
-    for(std::vector<HE_Vertex>::iterator itr = m_verts.begin(); itr!=m_verts.end(); ++itr)
+    parallelFor(m_verts.size(), [this](unsigned int, size_t _begin, size_t _end)
     {
-        // find all the one ring neighbours
-        std::vector<unsigned int> oneRingNeigh=findOneRingNeighbours(j);
-
-        // compute the equally weighted normal
-        unsigned int numNeigh = oneRingNeigh.size();
-        ngl::Vec3 norm(0.0,0.0,0.0), tmpN;
-
-        // Task 1
-        int x, next;
-        for(x=0; x<numNeigh; x++)
+        for(std::vector<HE_Vertex>::iterator itr = m_verts.begin()+_begin; itr!=m_verts.begin()+_end; ++itr)
         {
-          next=((x==numNeigh-1)?0:x+1);
-
-          tmpN.cross(m_verts[oneRingNeigh[x]].m_vert - itr->m_vert,
-                     m_verts[oneRingNeigh[next]].m_vert - itr->m_vert);
-          tmpN.normalize();
+            // compute the equally weighted normal from the faces round the vertex
+            ngl::Vec3 norm(0.0,0.0,0.0), tmpN;
 
-          norm+=tmpN;
-        }
+            // Task 1
+            for(OneRingCirculator ring(m_halfEdges, itr->m_outHalfEdge); ring.valid(); ++ring)
+            {
+              tmpN.cross(m_verts[ring.previousVertex()].m_vert - itr->m_vert,
+                         m_verts[ring.vertex()].m_vert - itr->m_vert);
+              tmpN.normalize();
 
+              norm+=tmpN;
+            }
 
-        itr->m_norm = -norm;
 
-        // free the memory
-        oneRingNeigh.erase(oneRingNeigh.begin(), oneRingNeigh.end());
-        j++;
-    }
+            itr->m_norm = -norm;
+        }
+    });
 }
 
 void HalfEdgeMesh::mapCurvaturetoColor()
 {
-    float maxCurv, minCurv, tmpCurv;
-    float r, g, b;
-    std::vector<HE_Vertex>::iterator itr = m_verts.begin();
-    maxCurv = minCurv = itr->m_curvature;
-    itr++;
-    for(; itr!=m_verts.end(); ++itr)
-    {
-        if(maxCurv<itr->m_curvature) maxCurv = itr->m_curvature;
-        if(minCurv>itr->m_curvature) minCurv = itr->m_curvature;
-    }
-    if(fabs(maxCurv-minCurv)<0.0001) // all curvature are same for all vertices
+    if(m_verts.empty())
+        return;
+    // the range is reduced in two steps, each block finds its own and then the blocks are compared
+    const unsigned int nBlocks = numBlocks(m_verts.size());
+    std::vector<float> blockMax(nBlocks), blockMin(nBlocks);
+    parallelFor(m_verts.size(), [&](unsigned int _block, size_t _begin, size_t _end)
     {
-        for(itr=m_verts.begin(); itr!=m_verts.end(); ++itr)
+        float maxCurv = m_verts[_begin].m_curvature, minCurv = maxCurv;
+        for(size_t v=_begin+1; v<_end; ++v)
         {
-            itr->m_color = ngl::Vec3(0.5, 0.5, 0.5);
+            if(maxCurv<m_verts[v].m_curvature) maxCurv = m_verts[v].m_curvature;
+            if(minCurv>m_verts[v].m_curvature) minCurv = m_verts[v].m_curvature;
         }
-    }
-    else
+        blockMax[_block] = maxCurv;
+        blockMin[_block] = minCurv;
+    });
+    const float maxCurv = *std::max_element(blockMax.begin(), blockMax.end());
+    const float minCurv = *std::min_element(blockMin.begin(), blockMin.end());
+
+    parallelFor(m_verts.size(), [&](unsigned int, size_t _begin, size_t _end)
     {
-        for(itr=m_verts.begin(); itr!=m_verts.end(); ++itr)
+        float r, g, b, tmpCurv;
+        for(std::vector<HE_Vertex>::iterator itr = m_verts.begin()+_begin; itr!=m_verts.begin()+_end; ++itr)
         {
+            if(fabs(maxCurv-minCurv)<0.0001) // all curvature are same for all vertices
+            {
+                itr->m_color = ngl::Vec3(0.5, 0.5, 0.5);
+                continue;
+            }
             tmpCurv = (itr->m_curvature-minCurv)/(maxCurv-minCurv);
             r = tmpCurv<0.333?1.0:(tmpCurv>0.666?0.0:(0.666-tmpCurv)/0.333);
             g = tmpCurv<0.333?tmpCurv/0.333:(tmpCurv<0.666?1.0:(1.0-tmpCurv)/0.334);
             b = tmpCurv<0.333?0.0:(tmpCurv<0.666?(tmpCurv-0.333)/0.333:1.0);
             itr->m_color = ngl::Vec3(0.5*r, 0.5*g, 0.5*b);
         }
-    }
+    });
 }
 
 std::vector<unsigned int> HalfEdgeMesh::findOneRingNeighbours(unsigned int _indexOfVertex)
 {
-    HE_Vertex   centreVertex = m_verts[_indexOfVertex];
-
     // find all the one ring neighbours
     std::vector<unsigned int> oneRingNeigh;
 
     // Task 2:
-    HalfEdge *startHE = centreVertex.m_outHalfEdge;
-    oneRingNeigh.push_back(startHE->m_toVertex);
-    HalfEdge *nextHE = startHE->m_dual->m_next;
-
-    while(nextHE!=startHE)
+    OneRingCirculator ring(m_halfEdges, m_verts[_indexOfVertex].m_outHalfEdge);
+    // an open ring has one more neighbour than faces, the one across the gap from the last
+    if(ring.isOpen())
+        oneRingNeigh.push_back(ring.previousVertex());
+    for(; ring.valid(); ++ring)
     {
-      oneRingNeigh.push_back(nextHE->m_toVertex);
-      nextHE=nextHE->m_dual->m_next;
+      oneRingNeigh.push_back(ring.vertex());
     }
 
-
-
     return oneRingNeigh;
 }
 
 float HalfEdgeMesh::computeFirstRingArea(unsigned int _indexOfVertex)
 {
-    HE_Vertex   centreVertex = m_verts[_indexOfVertex];
-
-    // find all the one ring neighbours
-    std::vector<unsigned int> oneRingNeigh=findOneRingNeighbours(_indexOfVertex);
-
-    // compute the equally weighted normal
-    unsigned int numNeigh = oneRingNeigh.size();
+    const ngl::Vec3 &centre = m_verts[_indexOfVertex].m_vert;
     float area = 0.0;
     ngl::Vec3 a, b, c;
 
     // Task 3
-    unsigned int i, next;
-    for(i=0;i<numNeigh;i++)
+    for(OneRingCirculator ring(m_halfEdges, m_verts[_indexOfVertex].m_outHalfEdge); ring.valid(); ++ring)
     {
-
-      next=((i==numNeigh-1)?0:i+1);
-      a = (m_verts[oneRingNeigh[i]].m_vert - centreVertex.m_vert);
-      b = (m_verts[oneRingNeigh[next]].m_vert - centreVertex.m_vert);
+      a = (m_verts[ring.previousVertex()].m_vert - centre);
+      b = (m_verts[ring.vertex()].m_vert - centre);
       c.cross(a,b);
       area += 0.5 * c.length();
     }
 
-
-
-
-
-    // free the memory
-    oneRingNeigh.erase(oneRingNeigh.begin(), oneRingNeigh.end());
     return area;
 }
 
 void HalfEdgeMesh::computeGaussianCurvature()
 {
-    unsigned int j=0;
-    for(std::vector<HE_Vertex>::iterator itr = m_verts.begin(); itr!=m_verts.end(); ++itr)
+    parallelFor(m_verts.size(), [this](unsigned int, size_t _begin, size_t _end)
     {
-        // find all the one ring neighbours
-        std::vector<unsigned int> oneRingNeigh=findOneRingNeighbours(j);
-        float area = computeFirstRingArea(j);
-
-        // compute the equally weighted normal
-        unsigned int numNeigh = oneRingNeigh.size();
-        float alpha=0.0;
-        ngl::Vec3 v1, v2, tmpA;
-        unsigned int i, next;
-        for(i=0;i<numNeigh;i++)
+        for(std::vector<HE_Vertex>::iterator itr = m_verts.begin()+_begin; itr!=m_verts.begin()+_end; ++itr)
         {
-            next=((i==numNeigh-1)?0:i+1);
-            v1=m_verts[oneRingNeigh[i]].m_vert - itr->m_vert;
-            v2=m_verts[oneRingNeigh[next]].m_vert - itr->m_vert;
-            v1.normalize();
-            v2.normalize();
-            tmpA.cross(v1,v2);
-            alpha += asin(tmpA.length());
+            // the angles and the area come from the same walk round the faces
+            float alpha=0.0, area=0.0;
+            ngl::Vec3 v1, v2, tmpA;
+            OneRingCirculator ring(m_halfEdges, itr->m_outHalfEdge);
+            for(; ring.valid(); ++ring)
+            {
+                v1=m_verts[ring.previousVertex()].m_vert - itr->m_vert;
+                v2=m_verts[ring.vertex()].m_vert - itr->m_vert;
+                tmpA.cross(v1,v2);
+                area += 0.5 * tmpA.length();
+                v1.normalize();
+                v2.normalize();
+                tmpA.cross(v1,v2);
+                alpha += asin(std::min(tmpA.length(), 1.0f));
+            }
+            // the angles round a vertex on a boundary add up to pi when it is flat
+            const float flat = ring.isOpen() ? pi : 2*pi;
+            itr->m_curvature = area > 0.0 ? (flat-alpha)*3.0/area : 0.0;
         }
-        itr->m_curvature = (2*pi-alpha)*3.0/area;
-
-        // free the memory
-        oneRingNeigh.erase(oneRingNeigh.begin(), oneRingNeigh.end());
-        j++;
-    }
+    });
 }
 
 void HalfEdgeMesh::computeMeanCurvature()
 {
-    unsigned int j=0;
-    for(std::vector<HE_Vertex>::iterator itr = m_verts.begin(); itr!=m_verts.end(); ++itr)
+    parallelFor(m_verts.size(), [this](unsigned int, size_t _begin, size_t _end)
     {
-        // find all the one ring neighbours
-        std::vector<unsigned int> oneRingNeigh=findOneRingNeighbours(j);
-        float area = computeFirstRingArea(j);
-
-        // compute the equally weighted normal
-        unsigned int numNeigh = oneRingNeigh.size();
-        std::vector<ngl::Vec3> norm(numNeigh);
-        std::vector<float> edgeLen(numNeigh);
-        float curv = 0.0;
-
-        // Task 4
-        ngl::Vec3 a, b, tmpN;
-        unsigned int i, next;
-        for(i=0; i<numNeigh; i++)
+        for(std::vector<HE_Vertex>::iterator itr = m_verts.begin()+_begin; itr!=m_verts.begin()+_end; ++itr)
         {
-          next=((i==numNeigh-1)?0:i+1);
-          a = (m_verts[oneRingNeigh[i]].m_vert - itr->m_vert);
-          b = (m_verts[oneRingNeigh[next]].m_vert - itr->m_vert);
-          tmpN.cross(a, b);
-          tmpN.normalize();
-          norm[i]=tmpN;
-          edgeLen[i]=b.length();
-
-        }
+            // each edge out of the vertex adds its length times the angle between the normals of the faces either
+            // side, so only the normal of the face before is kept, and the first one to close the ring with
+            float curv = 0.0, area = 0.0, firstLen = 0.0;
+            bool first = true;
+
+            // Task 4
+            ngl::Vec3 a, b, tmpN, prevN, firstN, dihedral;
+            OneRingCirculator ring(m_halfEdges, itr->m_outHalfEdge);
+            for(; ring.valid(); ++ring)
+            {
+              a = (m_verts[ring.previousVertex()].m_vert - itr->m_vert);
+              b = (m_verts[ring.vertex()].m_vert - itr->m_vert);
+              tmpN.cross(a, b);
+              area += 0.5 * tmpN.length();
+              tmpN.normalize();
+              if(first)
+              {
+                firstN = tmpN;
+                firstLen = a.length();
+                first = false;
+              }
+              else
+              {
+                // a is the edge this face shares with the one before
+                dihedral.cross(prevN, tmpN);
+                curv+=a.length()*asin(std::min(dihedral.length(), 1.0f));
+              }
+              prevN = tmpN;
+            }
+            if(!first && !ring.isOpen())
+            {
+              dihedral.cross(prevN, firstN);
+              curv+=firstLen*asin(std::min(dihedral.length(), 1.0f));
+            }
 
-        for(i=0;i<numNeigh;i++)
-        {
-          next=((i==numNeigh-1)?0:i+1);
-          tmpN.cross(norm[i], norm[next]);
-          curv+=edgeLen[i]*asin(tmpN.length());
+            itr->m_curvature = area > 0.0 ? 0.75*curv/area : 0.0;
         }
-
-
-        itr->m_curvature = 0.75*curv/area;
-
-        // free the memory
-        oneRingNeigh.erase(oneRingNeigh.begin(), oneRingNeigh.end());
-        j++;
-    }
+    });
 }
 
 void HalfEdgeMesh::createVAO()
@@ -433,89 +362,35 @@ void HalfEdgeMesh::createVAO()
     VertData d;
     unsigned int    i;
 
-    std::vector<bool> vertexVisited(m_nVerts, false);
-    unsigned int numVertexVisited = 0;
-    while(numVertexVisited< m_nVerts)
+    // the faces are all in one list so they are packed in order, each one as a fan of triangles around its
+    // first vertex, which is the one its last halfedge points to
+    unsigned int first, last, tHE, fan[3];
+    vboMesh.reserve(3*(m_halfEdges.size()-2*m_faces.size()));
+    for(std::vector<HE_Face>::iterator itr=m_faces.begin(); itr!=m_faces.end(); ++itr)
     {
-        // find the first vertex not visited yet
-        std::vector<bool>::iterator itrVV = vertexVisited.begin();
-        i=0;
-        while(*itrVV)
+        first = itr->m_halfEdge;
+        last = first;
+        while(m_halfEdges[last].m_next != first)
+            last = m_halfEdges[last].m_next;
+        fan[0] = m_halfEdges[last].m_toVertex;
+        for(tHE=first; m_halfEdges[tHE].m_next!=last; tHE=m_halfEdges[tHE].m_next)
         {
-            itrVV++; // it must stop before m_nVerts
-            i++;
-        }
-        // find the first face not visited yet
-        HE_Face *tFace = m_verts[i].m_outHalfEdge->m_face;
-        bool oldFlag = tFace->flag;
-        bool newFlag = oldFlag?false:true;
-
-        std::queue<HE_Face *> workingList;
-        workingList.push(tFace);
-        tFace->flag = newFlag;
-
-        HE_Face     *front;
-        HalfEdge    *tHE, *startHE;
-        while(!workingList.empty())
-        {
-            front = workingList.front();
-            startHE = front->m_halfEdge;
-            if(startHE->m_dual->m_face->flag==oldFlag)
-            {
-                workingList.push(startHE->m_dual->m_face);
-                startHE->m_dual->m_face->flag = newFlag;
-            }
-            if(!vertexVisited[startHE->m_toVertex])
-            {
-                vertexVisited[startHE->m_toVertex]=true;
-                numVertexVisited++;
-            }
-            tHE = startHE->m_next;
-            while(tHE!=startHE)
+            fan[1] = m_halfEdges[tHE].m_toVertex;
+            fan[2] = m_halfEdges[m_halfEdges[tHE].m_next].m_toVertex;
+            for(i=0;i<3;i++)
             {
-                d.x=m_verts[startHE->m_dual->m_toVertex].m_vert.m_x;
-                d.y=m_verts[startHE->m_dual->m_toVertex].m_vert.m_y;
-                d.z=m_verts[startHE->m_dual->m_toVertex].m_vert.m_z;
-                d.nx=m_verts[startHE->m_dual->m_toVertex].m_norm.m_x;
-                d.ny=m_verts[startHE->m_dual->m_toVertex].m_norm.m_y;
-                d.nz=m_verts[startHE->m_dual->m_toVertex].m_norm.m_z;
-                d.r=m_verts[startHE->m_dual->m_toVertex].m_color.m_x;
-                d.g=m_verts[startHE->m_dual->m_toVertex].m_color.m_y;
-                d.b=m_verts[startHE->m_dual->m_toVertex].m_color.m_z;
-                vboMesh.push_back(d);
-                d.x=m_verts[tHE->m_dual->m_toVertex].m_vert.m_x;
-                d.y=m_verts[tHE->m_dual->m_toVertex].m_vert.m_y;
-                d.z=m_verts[tHE->m_dual->m_toVertex].m_vert.m_z;
-                d.nx=m_verts[tHE->m_dual->m_toVertex].m_norm.m_x;
-                d.ny=m_verts[tHE->m_dual->m_toVertex].m_norm.m_y;
-                d.nz=m_verts[tHE->m_dual->m_toVertex].m_norm.m_z;
-                d.r=m_verts[tHE->m_dual->m_toVertex].m_color.m_x;
-                d.g=m_verts[tHE->m_dual->m_toVertex].m_color.m_y;
-                d.b=m_verts[tHE->m_dual->m_toVertex].m_color.m_z;
-                vboMesh.push_back(d);
-                d.x=m_verts[tHE->m_toVertex].m_vert.m_x;
-                d.y=m_verts[tHE->m_toVertex].m_vert.m_y;
-                d.z=m_verts[tHE->m_toVertex].m_vert.m_z;
-                d.nx=m_verts[tHE->m_toVertex].m_norm.m_x;
-                d.ny=m_verts[tHE->m_toVertex].m_norm.m_y;
-                d.nz=m_verts[tHE->m_toVertex].m_norm.m_z;
-                d.r=m_verts[tHE->m_toVertex].m_color.m_x;
-                d.g=m_verts[tHE->m_toVertex].m_color.m_y;
-                d.b=m_verts[tHE->m_toVertex].m_color.m_z;
+                const HE_Vertex &v = m_verts[fan[i]];
+                d.x=v.m_vert.m_x;
+                d.y=v.m_vert.m_y;
+                d.z=v.m_vert.m_z;
+                d.nx=v.m_norm.m_x;
+                d.ny=v.m_norm.m_y;
+                d.nz=v.m_norm.m_z;
+                d.r=v.m_color.m_x;
+                d.g=v.m_color.m_y;
+                d.b=v.m_color.m_z;
                 vboMesh.push_back(d);
-                if(tHE->m_dual->m_face->flag==oldFlag)
-                {
-                    workingList.push(tHE->m_dual->m_face);
-                    tHE->m_dual->m_face->flag = newFlag;
-                }
-                if(!vertexVisited[tHE->m_toVertex])
-                {
-                    vertexVisited[tHE->m_toVertex]=true;
-                    numVertexVisited++;
-                }
-                tHE=tHE->m_next;
             }
-            workingList.pop();
         }
     }
 
@@ -14,18 +14,41 @@ CONFIG-=app_bundle
 QT+=gui opengl core
 SOURCES+= src/main.cpp \
         src/MachingCube.cpp \
-        src/NGLScene.cpp
+        src/NGLScene.cpp \
+        src/RawVolume.cpp \
+        src/MinMaxPyramid.cpp \
+        src/AdaptiveOctree.cpp \
+        src/RowClassifier.cpp \
+        src/ScalarField.cpp \
+        src/MeshCache.cpp \
+        src/MeshDecimator.cpp \
+        src/GpuMarchingCubes.cpp
 
 HEADERS+= include/NGLScene.h \
-        include/MachingCube.h
+        include/MachingCube.h \
+        include/RawVolume.h \
+        include/VolumeView.h \
+        include/MinMaxPyramid.h \
+        include/AdaptiveOctree.h \
+        include/RowClassifier.h \
+        include/ScalarField.h \
+        include/MeshCache.h \
+        include/IndexedMesh.h \
+        include/MeshDecimator.h \
+        include/GpuMarchingCubes.h
 INCLUDEPATH +=./include
 
 DESTDIR=./
 OTHER_FILES+= shaders/PhongFragment.glsl \
-                shaders/PhongVertex.glsl
+                shaders/PhongVertex.glsl \
+                shaders/MCCommon.glsl \
+                shaders/MCClassify.glsl \
+                shaders/MCScan.glsl \
+                shaders/MCGenerate.glsl
 CONFIG += console
 CONFIG -= app_bundle
 CONFIG += c++11
+CONFIG += thread
 
 # use this to suppress some warning from boost
 QMAKE_CXXFLAGS_WARN_ON += "-Wno-unused-parameter"
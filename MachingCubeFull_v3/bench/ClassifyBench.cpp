@@ -0,0 +1,117 @@
+#include "RowClassifier.h"
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file ClassifyBench.cpp
+/// @brief times the scalar and SIMD cube index classification over every row of a synthetic volume
+/// usage ClassifyBench [size] [repeats]
+//----------------------------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief classify every row of the volume, returns the number of active cells found
+//----------------------------------------------------------------------------------------------------------------------
+template <typename T>
+unsigned long long sweep(RowClassifier &_classifier, const std::vector<T> &_volume, unsigned int _size, float _iso,
+                         std::vector<unsigned int> *_record)
+{
+    unsigned long long active = 0;
+    const size_t sliceSize = (size_t)_size*_size;
+    for(unsigned int i=0; i<_size-1; i++)
+    {
+        const T *s0 = &_volume[i*sliceSize];
+        const T *s1 = s0+sliceSize;
+        for(unsigned int j=0; j<_size-1; j++)
+        {
+            const T *s0j = s0+j*_size;
+            const T *s1j = s1+j*_size;
+            unsigned int n = _classifier.classify(s0j, s0j+_size, s1j, s1j+_size, _size-1, _iso);
+            active += n;
+            if(_record != 0)
+            {
+                for(unsigned int a=0; a<n; a++)
+                {
+                    _record->push_back(_classifier.getActive()[a]);
+                    _record->push_back(_classifier.getCubeIndex(_classifier.getActive()[a]));
+                }
+            }
+        }
+    }
+    return active;
+}
+
+template <typename T>
+bool bench(const char *_name, const std::vector<T> &_volume, unsigned int _size, float _iso, unsigned int _repeats)
+{
+    RowClassifier classifier;
+    std::vector<unsigned int> scalarCells, simdCells;
+    classifier.setPath(RowClassifier::Path::SCALAR);
+    sweep(classifier, _volume, _size, _iso, &scalarCells);
+    classifier.setPath(RowClassifier::Path::SIMD);
+    sweep(classifier, _volume, _size, _iso, &simdCells);
+    if(scalarCells != simdCells)
+    {
+        std::cout<<_name<<" the SIMD classification differs from the scalar one\n";
+        return false;
+    }
+
+    const double cells = (double)(_size-1)*(_size-1)*(_size-1)*_repeats;
+    double seconds[2];
+    unsigned long long active = 0;
+    RowClassifier::Path paths[2] = {RowClassifier::Path::SCALAR, RowClassifier::Path::SIMD};
+    for(int p=0; p<2; p++)
+    {
+        classifier.setPath(paths[p]);
+        auto start = std::chrono::steady_clock::now();
+        for(unsigned int r=0; r<_repeats; r++)
+            active = sweep(classifier, _volume, _size, _iso, (std::vector<unsigned int> *)0);
+        seconds[p] = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    }
+    std::cout<<_name<<" "<<active<<" active cells, scalar "<<cells/seconds[0]*1e-6<<" Mcells/s, "
+             <<RowClassifier::instructionSet()<<" "<<cells/seconds[1]*1e-6<<" Mcells/s, speed up "
+             <<seconds[0]/seconds[1]<<"\n";
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int size = argc > 1 ? std::atoi(argv[1]) : 256;
+    unsigned int repeats = argc > 2 ? std::atoi(argv[2]) : 4;
+    if(size < 2 || repeats < 1)
+    {
+        std::cout<<"usage ClassifyBench [size] [repeats]\n";
+        return EXIT_FAILURE;
+    }
+    // a few blobs in [0,1] so the surface is spread through the volume like a scan
+    std::vector<float> volume((size_t)size*size*size);
+    std::vector<unsigned char> volume8(volume.size());
+    std::vector<unsigned short> volume16(volume.size());
+    const float centres[4][3] = {{0.3f,0.3f,0.3f}, {0.7f,0.4f,0.6f}, {0.5f,0.7f,0.3f}, {0.4f,0.5f,0.75f}};
+    size_t v = 0;
+    for(unsigned int i=0; i<size; i++)
+        for(unsigned int j=0; j<size; j++)
+            for(unsigned int k=0; k<size; k++, v++)
+            {
+                float value = 0.0f;
+                for(int b=0; b<4; b++)
+                {
+                    float dx = (float)i/size-centres[b][0];
+                    float dy = (float)j/size-centres[b][1];
+                    float dz = (float)k/size-centres[b][2];
+                    value += 0.01f/(dx*dx+dy*dy+dz*dz+0.01f);
+                }
+                value = std::min(value*0.5f, 1.0f);
+                volume[v] = value;
+                volume8[v] = (unsigned char)(value*255.0f);
+                volume16[v] = (unsigned short)(value*65535.0f);
+            }
+
+    std::cout<<size<<"^3 volume, "<<repeats<<" repeats\n";
+    bool ok = bench("float ", volume, size, 0.25f, repeats);
+    ok = bench("8 bit ", volume8, size, 0.25f*255.0f, repeats) && ok;
+    ok = bench("16 bit", volume16, size, 0.25f*65535.0f, repeats) && ok;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
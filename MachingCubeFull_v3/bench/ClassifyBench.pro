@@ -0,0 +1,15 @@
+# micro benchmark of the cube index classification, no Qt or NGL needed
+TARGET=ClassifyBench
+OBJECTS_DIR=obj
+CONFIG-=app_bundle
+CONFIG-=qt
+CONFIG += console
+CONFIG += c++11
+SOURCES+= ClassifyBench.cpp \
+        ../src/RowClassifier.cpp
+HEADERS+= ../include/RowClassifier.h
+INCLUDEPATH +=../include
+DESTDIR=./
+QMAKE_CXXFLAGS+= -msse -msse2 -msse3
+macx:QMAKE_CXXFLAGS+= -arch x86_64
+linux-*:QMAKE_CXXFLAGS +=  -march=native
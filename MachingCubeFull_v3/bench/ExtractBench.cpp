@@ -0,0 +1,243 @@
+#include "MachingCube.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#if !defined(WIN32)
+  #include <unistd.h>
+  #include <sys/wait.h>
+  #include <sys/resource.h>
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file ExtractBench.cpp
+/// @brief times the whole extraction (load, normalise, classify, interpolate, post-pass and pack) of MachingCube
+/// without a window or a GL context, over synthetic volumes at a few resolutions, an 8 bit volume file laid out
+/// like mri.raw (200 x 160 x 160) and any volume files given. Writes one CSV row per run to stdout for tracking
+/// regressions, the chatter of MachingCube goes nowhere. Each run is done in its own process (on unix) so the peak
+/// RSS is its own
+/// usage ExtractBench [-r repeats] [-t threads] [-i isolevel] [volume.raw ...]
+//----------------------------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief one row of the results, a volume extracted with one set of options
+//----------------------------------------------------------------------------------------------------------------------
+struct Run
+{
+    std::string volume;     // a file, or empty for the synthetic volume
+    unsigned int size;      // edge of the synthetic volume
+    float isolevel;
+    MachingCube::Mesher mesher;
+    bool indexed;
+    unsigned int threads;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief a few dozen overlapping blobs so the surface winds through the whole volume the way a scan does,
+/// placed with a fixed LCG so every machine benchmarks the same field
+//----------------------------------------------------------------------------------------------------------------------
+static ScalarField blobs()
+{
+    ScalarField field;
+    unsigned int seed = 12345;
+    for(int b=0; b<48; b++)
+    {
+        float v[4];
+        for(int c=0; c<4; c++)
+        {
+            seed = seed*1664525u+1013904223u;
+            v[c] = (seed>>8)/16777216.0f;
+        }
+        field.addMetaball(0.15f+0.7f*v[0], 0.15f+0.7f*v[1], 0.15f+0.7f*v[2], 0.1f+0.15f*v[3]);
+    }
+    return field;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief write the blobs as an 8 bit volume file plus its .info, the values are clamped to [0,1] first so the
+/// normalised isolevel of the file is the same as the one of the float volume
+//----------------------------------------------------------------------------------------------------------------------
+static bool writeVolume(const std::string &_file, unsigned int _width, unsigned int _height, unsigned int _depth)
+{
+    std::vector<float> samples((size_t)_width*_height*_depth);
+    blobs().sample(&samples[0], _width, _height, _depth, std::thread::hardware_concurrency());
+    std::vector<unsigned char> voxels(samples.size());
+    for(size_t v=0; v<samples.size(); v++)
+        voxels[v] = (unsigned char)(std::min(std::max(samples[v], 0.0f), 1.0f)*255.0f+0.5f);
+    std::ofstream raw(_file.c_str(), std::ios::binary);
+    raw.write(reinterpret_cast<const char *>(&voxels[0]), voxels.size());
+    std::ofstream info((_file.substr(0, _file.find_last_of('.'))+".info").c_str());
+    info<<"Volume is "<<_width<<" x "<<_height<<" x "<<_depth<<"\n1 byte per voxel\n";
+    return raw.good() && info.good();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief peak resident set size of the process in KB, -1 where we can't tell
+//----------------------------------------------------------------------------------------------------------------------
+static long peakRSS()
+{
+#if defined(WIN32)
+    return -1;
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+  #if defined(DARWIN)
+    return usage.ru_maxrss/1024;
+  #else
+    return usage.ru_maxrss;
+  #endif
+#endif
+}
+
+static const char *s_header = "volume,voxel,width,height,depth,mesher,output,threads,cells,visited,triangles,vertices,"
+                              "load_ms,normalise_ms,classify_ms,interpolate_ms,post_ms,pack_ms,extract_ms,"
+                              "cells_per_s,tris_per_s,peak_rss_kb";
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief load the volume and extract it _repeats times, returns the CSV row of the fastest extraction
+//----------------------------------------------------------------------------------------------------------------------
+static std::string bench(const Run &_run, unsigned int _repeats)
+{
+    // MachingCube is quiet unless it is made verbose so std::cout only gets the results
+    MachingCube mc;
+    mc.setNumThreads(_run.threads);
+    mc.setMesher(_run.mesher);
+    mc.setIndexed(_run.indexed);
+    mc.setIsolevel(_run.isolevel);
+    bool loaded = true;
+    if(_run.volume.empty())
+        mc.generateVolume(blobs(), _run.size, _run.size, _run.size);
+    else
+        loaded = mc.LoadVolumeFromFile(_run.volume);
+    const MachingCube::PhaseTimes loading = mc.getPhaseTimes();
+
+    MachingCube::PhaseTimes best = loading;
+    double bestTime = 0.0;
+    unsigned long long visited = 0;
+    std::vector<VertData> verts;
+    std::vector<GLuint> indices;
+    for(unsigned int r=0; loaded && r<_repeats; r++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        mc.extractMesh(verts, indices);
+        double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+        if(r == 0 || time < bestTime)
+        {
+            bestTime = time;
+            best = mc.getPhaseTimes();
+            visited = mc.getCellsVisited();
+        }
+    }
+    if(!loaded)
+    {
+        std::cerr<<"can't load "<<_run.volume<<"\n";
+        return "";
+    }
+
+    const char *voxel[] = {"uint8", "uint16", "float"};
+    const unsigned int depth = mc.getVolumeDepth(), height = mc.getVolumeHeight(), width = mc.getVolumeWidth();
+    const double cells = (double)(depth-1)*(height-1)*(width-1);
+    const size_t triangles = indices.empty() ? verts.size()/3 : indices.size()/3;
+    std::ostringstream row;
+    row<<(_run.volume.empty() ? "blobs" : _run.volume)<<","<<voxel[(int)mc.voxelType()]<<","<<width<<","<<height<<","
+       <<depth<<","<<(_run.mesher == MachingCube::Mesher::SURFACE_NETS ? "nets" : "mc")<<","
+       <<(_run.indexed || _run.mesher == MachingCube::Mesher::SURFACE_NETS ? "indexed" : "triangles")<<","
+       <<mc.getNumThreads()<<","<<(unsigned long long)cells<<","<<visited<<","<<triangles<<","<<verts.size()<<","
+       <<best.load<<","<<best.normalise<<","<<best.classify<<","<<best.interpolate<<","<<best.post<<","<<best.pack<<","
+       <<bestTime<<","<<cells/bestTime*1e3<<","<<triangles/bestTime*1e3<<","<<peakRSS();
+    return row.str();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief run one benchmark in a child process so the peak RSS only covers that run
+//----------------------------------------------------------------------------------------------------------------------
+static bool benchIsolated(const Run &_run, unsigned int _repeats)
+{
+#if defined(WIN32)
+    std::string row = bench(_run, _repeats);
+    if(!row.empty())
+        std::cout<<row<<std::endl;
+    return !row.empty();
+#else
+    std::cout.flush();
+    pid_t child = fork();
+    if(child == 0)
+    {
+        std::string row = bench(_run, _repeats);
+        if(!row.empty())
+            std::cout<<row<<std::endl;
+        std::_Exit(row.empty() ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+    int status = 0;
+    if(child < 0 || waitpid(child, &status, 0) != child)
+        return false;
+    return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int repeats = 3;
+    unsigned int threads = std::thread::hardware_concurrency();
+    float isolevel = 0.5f;
+    std::vector<std::string> files;
+    for(int a=1; a<argc; a++)
+    {
+        if(std::strcmp(argv[a], "-r") == 0 && a+1 < argc)
+            repeats = std::atoi(argv[++a]);
+        else if(std::strcmp(argv[a], "-t") == 0 && a+1 < argc)
+            threads = std::atoi(argv[++a]);
+        else if(std::strcmp(argv[a], "-i") == 0 && a+1 < argc)
+            isolevel = std::atof(argv[++a]);
+        else if(argv[a][0] != '-')
+            files.push_back(argv[a]);
+        else
+            repeats = 0;
+    }
+    if(repeats < 1)
+    {
+        std::cerr<<"usage ExtractBench [-r repeats] [-t threads] [-i isolevel] [volume.raw ...]\n";
+        return EXIT_FAILURE;
+    }
+
+    // the synthetic volumes are sampled in memory, the one laid out like mri.raw goes through a file like a scan
+    // would, and isn't a cube either so the slabs and the pyramid blocks split it the way they split the scan
+    std::vector<Run> volumes;
+    const unsigned int sizes[] = {64, 128, 256};
+    for(unsigned int size : sizes)
+        volumes.push_back(Run{"", size, isolevel, MachingCube::Mesher::MARCHING_CUBES, false, 1});
+    const std::string mri = "ExtractBench_mri.raw";
+    if(writeVolume(mri, 200, 160, 160))
+        volumes.push_back(Run{mri, 0, isolevel, MachingCube::Mesher::MARCHING_CUBES, false, 1});
+    else
+        std::cerr<<"can't write "<<mri<<"\n";
+    for(const std::string &file : files)
+        volumes.push_back(Run{file, 0, isolevel, MachingCube::Mesher::MARCHING_CUBES, false, 1});
+
+    std::vector<unsigned int> threadCounts(1, 1);
+    if(threads > 1)
+        threadCounts.push_back(threads);
+    std::cout<<s_header<<"\n";
+    bool ok = true;
+    for(const Run &volume : volumes)
+    {
+        for(unsigned int t : threadCounts)
+        {
+            Run run = volume;
+            run.threads = t;
+            ok = benchIsolated(run, repeats) && ok;
+            run.indexed = true;
+            ok = benchIsolated(run, repeats) && ok;
+            run.mesher = MachingCube::Mesher::SURFACE_NETS;
+            ok = benchIsolated(run, repeats) && ok;
+        }
+    }
+    std::remove(mri.c_str());
+    std::remove("ExtractBench_mri.info");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
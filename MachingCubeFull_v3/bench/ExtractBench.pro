@@ -0,0 +1,49 @@
+# headless benchmark of the whole extraction, needs NGL (and so Qt) for the maths types but never opens a window
+TARGET=ExtractBench
+OBJECTS_DIR=obj
+CONFIG-=app_bundle
+QT+=gui opengl core
+CONFIG += console
+CONFIG += c++11
+CONFIG += thread
+SOURCES+= ExtractBench.cpp \
+        ../src/MachingCube.cpp \
+        ../src/RawVolume.cpp \
+        ../src/MinMaxPyramid.cpp \
+        ../src/RowClassifier.cpp \
+        ../src/ScalarField.cpp \
+        ../src/MeshCache.cpp \
+        ../src/MeshDecimator.cpp \
+        ../src/GpuMarchingCubes.cpp
+HEADERS+= ../include/MachingCube.h \
+        ../include/RawVolume.h \
+        ../include/VolumeView.h \
+        ../include/MinMaxPyramid.h \
+        ../include/RowClassifier.h \
+        ../include/ScalarField.h \
+        ../include/MeshCache.h \
+        ../include/IndexedMesh.h \
+        ../include/MeshDecimator.h \
+        ../include/GpuMarchingCubes.h
+INCLUDEPATH +=../include
+DESTDIR=./
+QMAKE_CXXFLAGS+= -msse -msse2 -msse3
+macx:QMAKE_CXXFLAGS+= -arch x86_64
+macx:INCLUDEPATH+=/usr/local/include/
+macx:DEFINES += DARWIN
+linux-*:QMAKE_CXXFLAGS +=  -march=native
+linux-*:DEFINES+=GL42 LINUX
+
+unix:LIBS += -L/usr/local/lib
+unix:LIBS +=  -L/$(HOME)/NGL/lib -l NGL
+INCLUDEPATH += $$(HOME)/NGL/include/
+
+win32: {
+                                PRE_TARGETDEPS+=C:/NGL/lib/NGL.lib
+                                DEFINES+=GL42
+                                DEFINES += WIN32
+                                DEFINES+=_WIN32
+                                DEFINES+=_USE_MATH_DEFINES
+                                LIBS += -LC:/NGL/lib/ -lNGL
+                                DEFINES+=NO_DLL
+}
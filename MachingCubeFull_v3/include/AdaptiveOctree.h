@@ -0,0 +1,332 @@
+#ifndef ADAPTIVEOCTREE_H_
+#define ADAPTIVEOCTREE_H_
+//----------------------------------------------------------------------------------------------------------------------
+/// @file AdaptiveOctree.h
+/// @brief octree choosing the sample spacing of each part of the volume for the adaptive extraction
+//----------------------------------------------------------------------------------------------------------------------
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include "VolumeView.h"
+#include "MinMaxPyramid.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class AdaptiveOctree "include/AdaptiveOctree.h"
+/// @brief splits the volume into leaves of LeafCells^3 cells, the cells of a leaf of level l are 2^l samples long
+/// (the last one of each axis may be shorter, as with the levels of detail). A node is split while the surface can
+/// go through it and the volume inside it is further from the trilinear interpolation of its own samples than the
+/// error allowed, so the flat parts of the surface get coarse cells and the sharply curved parts fine ones. Leaves
+/// that touch, even at a corner, are never more than one level apart.
+///
+/// Where a leaf meets a coarser one, the samples it has on their shared face are interpolated from the corners of the
+/// coarse cells instead of read from the volume. An edge of the fine leaf that runs along an edge of a coarse cell is
+/// then cut in the same place as that edge and gets the same key, and the gaps left between the two sides only lie in
+/// the plane of the face, where MachingCube patches them
+//----------------------------------------------------------------------------------------------------------------------
+class AdaptiveOctree
+{
+public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of cells along each side of a leaf, a leaf of level 0 is one block of the pyramid
+    //----------------------------------------------------------------------------------------------------------------------
+    static const unsigned int LeafCells = MinMaxPyramid::BlockSize;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a leaf, the origin is its first sample along the depth, height and width of the volume
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Leaf
+    {
+        unsigned int level;
+        unsigned int origin[3];
+    };
+
+    AdaptiveOctree() : m_levels(0) {std::fill(m_size, m_size+3, 0); std::fill(m_nodes, m_nodes+3, 0);}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief forget the leaves and the errors worked out so far, for a new or changed volume
+    //----------------------------------------------------------------------------------------------------------------------
+    void clear();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief split the volume into leaves for a set of isolevels. The error of a node is worked out the first time
+    /// it is needed and kept, so after the first build of a volume this only walks the nodes
+    /// @param[in] _volume the volume
+    /// @param[in] _pyramid its min/max pyramid, the nodes of level l are the blocks of its level l
+    /// @param[in] _levels the number of levels, a leaf is at most of level _levels-1
+    /// @param[in] _isos the isolevels in the value range of the voxels
+    /// @param[in] _error the largest difference between the volume and the trilinear interpolation of the samples of
+    /// a leaf, as a fraction of the value range of the volume. 0 makes every leaf the surface goes through level 0
+    /// @returns true if the leaves are not the same as before
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T>
+    bool build(const VolumeView<T> &_volume, const MinMaxPyramid &_pyramid, unsigned int _levels,
+               const std::vector<float> &_isos, float _error);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the leaves, ordered by depth then height then width
+    //----------------------------------------------------------------------------------------------------------------------
+    const std::vector<Leaf> &getLeaves() const {return m_leaves;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of leaves of level _level
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t countLeaves(unsigned int _level) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the level of the leaf holding the level 0 node (_ni,_nj,_nk)
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int leafLevel(unsigned int _ni, unsigned int _nj, unsigned int _nk) const
+    {
+        return m_grid[((size_t)_ni*m_nodes[1] + _nj)*m_nodes[2] + _nk];
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief true if sample _p along _axis is a sample of the leaves of level _level, the last sample always is
+    //----------------------------------------------------------------------------------------------------------------------
+    bool onLattice(unsigned int _p, unsigned int _axis, unsigned int _level) const
+    {
+        return _p%(1u<<_level) == 0 || _p == m_size[_axis]-1;
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the far end of the cell of level _level starting at sample _p along _axis
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int cellEnd(unsigned int _p, unsigned int _axis, unsigned int _level) const
+    {
+        return std::min(_p+(1u<<_level), m_size[_axis]-1);
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the highest level of the leaves touching sample _p, or touching the edge running from _p along _axis
+    /// when _axis is 0 to 2 (the edge is never longer than a level 0 node)
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int maxLevelAt(const unsigned int _p[3], int _axis=-1) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the key of the cell edge running from io_p along _axis, io_level is the level of the cell. An edge lying
+    /// along an edge of a coarser leaf is replaced by that edge (its start and level are written back) so both sides
+    /// make one vertex for it
+    //----------------------------------------------------------------------------------------------------------------------
+    uint64_t edgeKey(unsigned int io_p[3], unsigned int _axis, unsigned int &io_level) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the value the leaves touching sample _p use for it. That is the voxel unless a coarser leaf touches it
+    /// and it is not one of its samples, then it is interpolated from the corners of the coarse cell face (or edge)
+    /// it lies on, which are looked up the same way
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T>
+    float value(const VolumeView<T> &_volume, const unsigned int _p[3]) const;
+
+private :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the number of nodes of level _level along _axis
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int nodesAt(unsigned int _level, unsigned int _axis) const
+    {
+        return (m_nodes[_axis]+(1u<<_level)-1)>>_level;
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief size the grids for a volume, the errors are only dropped if its size has changed
+    //----------------------------------------------------------------------------------------------------------------------
+    void resize(unsigned int _depth, unsigned int _height, unsigned int _width, unsigned int _levels);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief split node _n of level _level down to its leaves and write their levels into io_grid
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T>
+    void refine(const VolumeView<T> &_volume, const MinMaxPyramid &_pyramid, unsigned int _level, const unsigned int _n[3],
+                const std::vector<float> &_isos, float _error, std::vector<unsigned char> &io_grid);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the largest difference between the samples of level _level-1 in node _n of level _level and the
+    /// trilinear interpolation of its own samples, as a fraction of the value range
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T>
+    float nodeError(const VolumeView<T> &_volume, unsigned int _level, const unsigned int _n[3]);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief give every level 0 node of the box [_begin,_end) of level 0 nodes the level _level
+    //----------------------------------------------------------------------------------------------------------------------
+    void setLevel(const unsigned int _begin[3], const unsigned int _end[3], unsigned int _level, std::vector<unsigned char> &io_grid) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief split the leaves touching a leaf more than one level finer until there are none left
+    //----------------------------------------------------------------------------------------------------------------------
+    void balance(std::vector<unsigned char> &io_grid) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief make the list of leaves from the grid
+    //----------------------------------------------------------------------------------------------------------------------
+    void collectLeaves();
+
+    unsigned int    m_size[3];      // samples along the depth, height and width
+    unsigned int    m_nodes[3];     // level 0 nodes along each axis
+    unsigned int    m_levels;
+    float           m_range;        // the value range of the volume
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the level of the leaf holding each level 0 node, and the errors of the nodes of each level (NaN until
+    /// they are needed)
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<unsigned char> m_grid;
+    std::vector<std::vector<float> > m_errors;
+    std::vector<Leaf> m_leaves;
+};
+
+template <typename T>
+bool AdaptiveOctree::build(const VolumeView<T> &_volume, const MinMaxPyramid &_pyramid, unsigned int _levels,
+                           const std::vector<float> &_isos, float _error)
+{
+    resize(_volume.getDepth(), _volume.getHeight(), _volume.getWidth(), _levels);
+    m_range = _pyramid.getMaxValue()-_pyramid.getMinValue();
+    std::vector<unsigned char> grid(m_grid.size(), 0);
+    const unsigned int top = m_levels-1;
+    unsigned int n[3];
+    for(n[0]=0; n[0]<nodesAt(top, 0); n[0]++)
+    {
+        for(n[1]=0; n[1]<nodesAt(top, 1); n[1]++)
+        {
+            for(n[2]=0; n[2]<nodesAt(top, 2); n[2]++)
+            {
+                refine(_volume, _pyramid, top, n, _isos, _error, grid);
+            }
+        }
+    }
+    balance(grid);
+    if(grid == m_grid && !m_leaves.empty())
+        return false;
+    m_grid.swap(grid);
+    collectLeaves();
+    return true;
+}
+
+template <typename T>
+void AdaptiveOctree::refine(const VolumeView<T> &_volume, const MinMaxPyramid &_pyramid, unsigned int _level,
+                            const unsigned int _n[3], const std::vector<float> &_isos, float _error,
+                            std::vector<unsigned char> &io_grid)
+{
+    // a node the surface doesn't go through stays as coarse as it can, whatever its error
+    bool split = false;
+    for(size_t l=0; l<_isos.size() && _level > 0 && !split; l++)
+    {
+        split = _pyramid.isActive(_level, _n[0], _n[1], _n[2], _isos[l]);
+    }
+    if(split)
+        split = nodeError(_volume, _level, _n) > _error;
+    if(!split)
+    {
+        unsigned int begin[3], end[3];
+        for(int a=0; a<3; a++)
+        {
+            begin[a] = _n[a]<<_level;
+            end[a] = std::min((_n[a]+1)<<_level, m_nodes[a]);
+        }
+        setLevel(begin, end, _level, io_grid);
+        return;
+    }
+    unsigned int c[3];
+    for(unsigned int child=0; child<8; child++)
+    {
+        c[0] = _n[0]*2+(child&1);
+        c[1] = _n[1]*2+((child>>1)&1);
+        c[2] = _n[2]*2+((child>>2)&1);
+        if(c[0] < nodesAt(_level-1, 0) && c[1] < nodesAt(_level-1, 1) && c[2] < nodesAt(_level-1, 2))
+            refine(_volume, _pyramid, _level-1, c, _isos, _error, io_grid);
+    }
+}
+
+template <typename T>
+float AdaptiveOctree::nodeError(const VolumeView<T> &_volume, unsigned int _level, const unsigned int _n[3])
+{
+    float &error = m_errors[_level][((size_t)_n[0]*nodesAt(_level, 1) + _n[1])*nodesAt(_level, 2) + _n[2]];
+    if(!std::isnan(error))
+        return error;
+    // the samples of the next level down, each compared with the trilinear interpolation of the corners of the
+    // cell of this level it is in
+    const unsigned int step = 1u<<(_level-1);
+    std::vector<unsigned int> samples[3];
+    for(unsigned int a=0; a<3; a++)
+    {
+        const unsigned int begin = _n[a]*(LeafCells<<_level);
+        const unsigned int end = std::min(begin+(LeafCells<<_level), m_size[a]-1);
+        for(unsigned int p=begin; p<end; p+=step)
+            samples[a].push_back(p);
+        samples[a].push_back(end);
+    }
+    float worst = 0.0f;
+    unsigned int p[3], lo[3], hi[3];
+    float t[3];
+    for(size_t i=0; i<samples[0].size(); i++)
+    {
+        for(size_t j=0; j<samples[1].size(); j++)
+        {
+            for(size_t k=0; k<samples[2].size(); k++)
+            {
+                p[0] = samples[0][i];
+                p[1] = samples[1][j];
+                p[2] = samples[2][k];
+                bool corner = true;
+                for(unsigned int a=0; a<3; a++)
+                {
+                    lo[a] = hi[a] = p[a];
+                    t[a] = 0.0f;
+                    if(!onLattice(p[a], a, _level))
+                    {
+                        lo[a] = p[a]-p[a]%(1u<<_level);
+                        hi[a] = cellEnd(lo[a], a, _level);
+                        t[a] = float(p[a]-lo[a])/(hi[a]-lo[a]);
+                        corner = false;
+                    }
+                }
+                if(corner)
+                    continue;
+                float v[8];
+                for(unsigned int c=0; c<8; c++)
+                {
+                    v[c] = _volume(c&1 ? hi[0] : lo[0], c&2 ? hi[1] : lo[1], c&4 ? hi[2] : lo[2]);
+                }
+                for(unsigned int c=0; c<4; c++)
+                    v[c] += t[2]*(v[c|4]-v[c]);
+                for(unsigned int c=0; c<2; c++)
+                    v[c] += t[1]*(v[c|2]-v[c]);
+                v[0] += t[0]*(v[1]-v[0]);
+                worst = std::max(worst, std::fabs(v[0]-(float)_volume(p[0], p[1], p[2])));
+            }
+        }
+    }
+    error = m_range > 0.0f ? worst/m_range : 0.0f;
+    return error;
+}
+
+template <typename T>
+float AdaptiveOctree::value(const VolumeView<T> &_volume, const unsigned int _p[3]) const
+{
+    const unsigned int level = maxLevelAt(_p);
+    unsigned int lo[3], hi[3];
+    float t[3];
+    bool sample = true;
+    for(unsigned int a=0; a<3; a++)
+    {
+        lo[a] = hi[a] = _p[a];
+        t[a] = 0.0f;
+        if(!onLattice(_p[a], a, level))
+        {
+            lo[a] = _p[a]-_p[a]%(1u<<level);
+            hi[a] = cellEnd(lo[a], a, level);
+            t[a] = float(_p[a]-lo[a])/(hi[a]-lo[a]);
+            sample = false;
+        }
+    }
+    if(sample)
+        return _volume(_p[0], _p[1], _p[2]);
+    // always blended in the same order so every leaf gets exactly the same value
+    float v[8];
+    unsigned int q[3];
+    for(unsigned int c=0; c<8; c++)
+    {
+        if(((c&1) && t[0] == 0.0f) || ((c&2) && t[1] == 0.0f) || ((c&4) && t[2] == 0.0f))
+            continue;
+        q[0] = c&1 ? hi[0] : lo[0];
+        q[1] = c&2 ? hi[1] : lo[1];
+        q[2] = c&4 ? hi[2] : lo[2];
+        v[c] = value(_volume, q);
+    }
+    if(t[2] > 0.0f)
+        for(unsigned int c=0; c<4; c++)
+            if(!((c&1) && t[0] == 0.0f) && !((c&2) && t[1] == 0.0f))
+                v[c] += t[2]*(v[c|4]-v[c]);
+    if(t[1] > 0.0f)
+        for(unsigned int c=0; c<2; c++)
+            if(!((c&1) && t[0] == 0.0f))
+                v[c] += t[1]*(v[c|2]-v[c]);
+    if(t[0] > 0.0f)
+        v[0] += t[0]*(v[1]-v[0]);
+    return v[0];
+}
+
+#endif
+//----------------------------------------------------------------------------------------------------------------------
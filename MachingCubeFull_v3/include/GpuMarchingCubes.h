@@ -0,0 +1,106 @@
+#ifndef GPUMARCHINGCUBES_H_
+#define GPUMARCHINGCUBES_H_
+//----------------------------------------------------------------------------------------------------------------------
+/// @file GpuMarchingCubes.h
+/// @brief marching cubes in GL 4.3 compute shaders
+//----------------------------------------------------------------------------------------------------------------------
+// must include types.h first for ngl::Real and GLEW if required
+#include <ngl/Types.h>
+#include <string>
+#include <cstddef>
+#include "RawVolume.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class GpuMarchingCubes "include/GpuMarchingCubes.h"
+/// @brief the GPU backend of MachingCube for the unindexed output. The volume is kept in a 3D texture and the
+/// extraction runs in three compute passes: MCClassify works out the cube index of every cell and sums the
+/// triangles of each work group of 256 cells, MCScan turns the sums into the offset of each group (a prefix sum)
+/// and writes the draw command, and MCGenerate makes the triangles of each cell at the offset of its group plus
+/// the prefix sum of the cells before it in the group. The cells are numbered the way the CPU sweeps them so the
+/// vertices come out in the same order, in the VertData layout, and are drawn with glDrawArraysIndirect
+//----------------------------------------------------------------------------------------------------------------------
+class GpuMarchingCubes
+{
+public :
+    GpuMarchingCubes();
+    ~GpuMarchingCubes();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief compile the shaders and upload the tables, needs a current GL context
+    /// @param[in] _edgeTable,_triTable the marching cubes tables
+    /// @returns false if the context can't run compute shaders (or they don't compile), the CPU is used then
+    //----------------------------------------------------------------------------------------------------------------------
+    bool init(const int _edgeTable[256], const int _triTable[256][16]);
+    bool isReady() const {return m_ready;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief true if a volume of this size fits in a 3D texture and its cells can be numbered in the 32 bits the
+    /// shaders count them in
+    //----------------------------------------------------------------------------------------------------------------------
+    bool canHold(unsigned int _width, unsigned int _height, unsigned int _depth) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief make the texture for a volume, the voxels keep their type so they compare with the isolevel exactly
+    /// as on the CPU. Fill it with uploadSlice
+    /// @returns false if the volume can't be held (see canHold)
+    //----------------------------------------------------------------------------------------------------------------------
+    bool setVolume(VoxelType _type, unsigned int _width, unsigned int _height, unsigned int _depth);
+    void uploadSlice(unsigned int _s, const void *_voxels);
+    bool hasVolume() const {return m_texture != 0;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief map a level of detail back onto the full volume like MachingCube::unitCoordinate does
+    /// @param[in] _stride the stride of the level, 1 for a full volume
+    /// @param[in] _fineSize the size of the full volume along the depth, height and width
+    //----------------------------------------------------------------------------------------------------------------------
+    void setStride(unsigned int _stride, const unsigned int _fineSize[3]);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief extract the surface at _iso into a vertex buffer and write the draw command for it. Nothing is read
+    /// back so this never waits on the GPU, the triangles that don't fit in _vbo are left out (and the draw command
+    /// stops at the last one that fits) and vertexCount tells how big it should have been
+    /// @param[in] _iso the isolevel in the value range of the voxels
+    /// @param[in] _smoothNormals gradient normals instead of one normal per triangle
+    /// @param[in] _vbo the vertex buffer
+    /// @param[in] _capacity the size in bytes of _vbo
+    /// @param[in] _indirect the buffer for the glDrawArraysIndirect command, followed by the vertices of the whole
+    /// surface
+    //----------------------------------------------------------------------------------------------------------------------
+    void extract(float _iso, bool _smoothNormals, GLuint _vbo, size_t _capacity, GLuint _indirect);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the vertices of the whole surface the last extract into _indirect found, waits for the passes
+    /// to finish so check a fence first where that matters
+    //----------------------------------------------------------------------------------------------------------------------
+    static size_t vertexCount(GLuint _indirect);
+
+private :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief build a program from MCCommon.glsl and the pass _file, prints the log if it fails
+    //----------------------------------------------------------------------------------------------------------------------
+    static GLuint loadProgram(const std::string &_common, const std::string &_file);
+    static std::string readFile(const std::string &_file);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set the uniforms every pass shares and dispatch one invocation per cell (or one group for the scan)
+    //----------------------------------------------------------------------------------------------------------------------
+    void dispatch(GLuint _program, float _iso, bool _perCell);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the cells of the volume, canHold makes sure there are fewer than 2^32
+    //----------------------------------------------------------------------------------------------------------------------
+    GLuint numCells() const;
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the cells handled by a work group of the classify and generate passes, as in the shaders
+    //----------------------------------------------------------------------------------------------------------------------
+    static const unsigned int GroupCells = 256;
+
+    bool            m_ready;
+    GLuint          m_classify;
+    GLuint          m_scan;
+    GLuint          m_generate;
+    GLuint          m_tables;       // edgeTable, the triangle count of each cube index and triTable
+    GLuint          m_groups;       // the triangles of each work group, then its offset
+    size_t          m_groupsCapacity;
+    GLuint          m_texture;
+    VoxelType       m_type;
+    unsigned int    m_size[3];      // depth, height, width
+    unsigned int    m_stride;
+    unsigned int    m_fineSize[3];
+};
+
+#endif
+//----------------------------------------------------------------------------------------------------------------------
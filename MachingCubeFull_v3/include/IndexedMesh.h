@@ -0,0 +1,21 @@
+#ifndef INDEXEDMESH_H_
+#define INDEXEDMESH_H_
+//----------------------------------------------------------------------------------------------------------------------
+/// @file IndexedMesh.h
+/// @brief shared vertex mesh made by the indexed extraction
+//----------------------------------------------------------------------------------------------------------------------
+// must include types.h first for ngl::Real and GLEW if required
+#include <ngl/Types.h>
+#include <ngl/Vec3.h>
+#include <vector>
+
+// shared vertex output of the indexed extraction, every three indices make a triangle
+struct IndexedMesh
+{
+    std::vector<ngl::Vec3> verts;
+    std::vector<ngl::Vec3> normals; // gradient normals, only filled for smooth normals
+    std::vector<GLuint>    indices;
+};
+
+#endif
+//----------------------------------------------------------------------------------------------------------------------
@@ -12,10 +12,27 @@
 #include <fstream>
 #include <string>
 #include <memory>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <iterator>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
 #include <ngl/Vec3.h>
 #include <ngl/Vec4.h>
 #include <ngl/VertexArrayObject.h>
 #include <cmath>
+#include "RawVolume.h"
+#include "VolumeView.h"
+#include "MinMaxPyramid.h"
+#include "RowClassifier.h"
+#include "ScalarField.h"
+#include "MeshCache.h"
+#include "IndexedMesh.h"
+#include "MeshDecimator.h"
+#include "GpuMarchingCubes.h"
+#include "AdaptiveOctree.h"
 
 //----------------------------------------------------------------------------------------------------------------------
 /// @class MachingCube "include/MachingCube.h"
@@ -38,6 +55,17 @@ struct VertData
   GLfloat z;
 };
 
+// the vertex of the packed vertex format, 10 bytes to the 24 of VertData. The normal comes first as the
+// offsets of the attribute pointers are counted in floats
+struct PackedVertData
+{
+  GLshort nu; // octahedral normal, signed normalised
+  GLshort nv;
+  GLshort x;  // position, signed normalised over the same [-1,1] box as VertData
+  GLshort y;
+  GLshort z;
+};
+
 // code from http://paulbourke.net/geometry/polygonise/
 
 typedef struct {
@@ -60,49 +88,738 @@ public :
     //----------------------------------------------------------------------------------------------------------------------
     MachingCube();
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief  load an volume data from a file
+    /// @brief  load an volume data from a file, the size and voxel type are read from the .info sidecar and the
+    /// file is memory mapped so it is streamed during the extraction instead of being read into memory
     /// @param[in]  &_vol Volume Data File name
     //----------------------------------------------------------------------------------------------------------------------
     bool LoadVolumeFromFile(std::string _vol);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief generate the default volume, two metaballs on a 100^3 grid
+    //----------------------------------------------------------------------------------------------------------------------
     void generateVolume();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief generate a volume by sampling a field of metaballs, the slices are shared out between the
+    /// threads set with setNumThreads
+    /// @param[in] _field the metaballs
+    /// @param[in] _width,_height,_depth the size of the volume
+    //----------------------------------------------------------------------------------------------------------------------
+    void generateVolume(const ScalarField &_field, unsigned int _width, unsigned int _height, unsigned int _depth);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a scalar field given as a function of the position, values below the isolevel are inside
+    //----------------------------------------------------------------------------------------------------------------------
+    typedef std::function<float(float, float, float)> ImplicitFunction;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief polygonise an implicit function instead of a volume. Nothing is sampled up front, each slab of the
+    /// extraction samples the slices it needs as it sweeps through the box and only keeps two of them (four with
+    /// the gradient normals) so the memory used doesn't depend on the depth of the grid. There is no min/max
+    /// pyramid for a function so every cell is visited
+    /// @param[in] _f the function, called from all the extraction threads at once
+    /// @param[in] _min,_max the corners of the box, x runs along the depth of the grid, y the height and z the width
+    /// @param[in] _width,_height,_depth the number of samples along each side of the box, at least 2
+    //----------------------------------------------------------------------------------------------------------------------
+    void setImplicitFunction(const ImplicitFunction &_f, const ngl::Vec3 &_min, const ngl::Vec3 &_max,
+                             unsigned int _width, unsigned int _height, unsigned int _depth);
     ~MachingCube();
 
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief draw method to draw the maching cube mesh as a VBO. The VBO first needs to be created using the CreateVAO method
     //----------------------------------------------------------------------------------------------------------------------
     void draw() const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief draw the mesh of one isolevel only, so each surface can get its own material
+    /// @param[in] _level the index of the isolevel as passed to setIsolevels
+    //----------------------------------------------------------------------------------------------------------------------
+    void draw(unsigned int _level) const;
 
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief extract the isosurface and pack it into a VAO, the volume is split into z-slabs which are
+    /// extracted in parallel (see setNumThreads) and merged back in slab order
     //----------------------------------------------------------------------------------------------------------------------
     void createVAO();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief change the isolevel, once the VAO exists the surface is re-extracted straight away into the
+    /// existing GPU buffers and only the blocks the surface can go through are visited
+    /// @param[in] _iso the new isolevel, in [0,1] for volumes loaded from a file
+    //----------------------------------------------------------------------------------------------------------------------
+    void setIsolevel(float _iso);
+    float getIsolevel() const {return isolevel;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief extract several isosurfaces (say skin and bone) at once, every level gets its own VAO but they
+    /// all come out of one sweep over the volume which classifies the cells and fetches their corners once
+    /// for all of them. The first level is the one setIsolevel changes
+    /// @param[in] _levels the isolevels, at least one
+    //----------------------------------------------------------------------------------------------------------------------
+    void setIsolevels(const std::vector<float> &_levels);
+    unsigned int getNumIsolevels() const {return m_extraIsolevels.size()+1;}
+    float getIsolevel(unsigned int _level) const {return _level == 0 ? isolevel : m_extraIsolevels[_level-1];}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of levels of detail, level n takes every 2^n-th sample of the volume
+    //----------------------------------------------------------------------------------------------------------------------
+    static const unsigned int NumLods = 4;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief select the level of detail draw uses, cheap enough to call every frame. A level is extracted the
+    /// first time it is used (or the isolevel has changed since) and kept on the GPU after that. The whole mesh
+    /// is always one level so there are no cracks between neighbouring parts of it
+    /// @param[in] _lod 0 for the full resolution up to NumLods-1
+    //----------------------------------------------------------------------------------------------------------------------
+    void setLod(unsigned int _lod);
+    unsigned int getLod() const {return m_lod;}
+    unsigned int getLodStride() const {return 1u<<m_lod;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief switch the octree-adaptive extraction on and off, off by default. Instead of one level of detail for the
+    /// whole volume each leaf of an AdaptiveOctree gets its own, coarse where its samples describe the volume well
+    /// (the flat parts of the surface) and fine where they don't (the sharply curved parts). Where two levels meet the
+    /// fine side takes the samples of the coarse one on their shared face, and the gaps that leaves in the plane of
+    /// the face are filled with patch polygons, so the mesh has no cracks. The adaptive mesh is made by marching cubes
+    /// from a volume in the indexed output and takes the place of the levels of detail, surface nets and implicit
+    /// functions ignore it. Once the VAO exists the surfaces are re-extracted straight away
+    //----------------------------------------------------------------------------------------------------------------------
+    void setAdaptive(bool _adaptive);
+    bool getAdaptive() const {return m_adaptive;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the error the adaptive extraction allows, see AdaptiveOctree::build. Cheap enough to call every frame,
+    /// the surfaces are only extracted again when the leaves of the octree change
+    /// @param[in] _error the largest difference between the volume and a leaf as a fraction of the value range
+    //----------------------------------------------------------------------------------------------------------------------
+    void setAdaptiveError(float _error);
+    float getAdaptiveError() const {return m_adaptiveError;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set the number of worker threads used by createVAO, 1 runs the serial path on the calling thread
+    /// @param[in] _n number of threads, 0 uses the number of hardware threads
+    //----------------------------------------------------------------------------------------------------------------------
+    void setNumThreads(unsigned int _n);
+    unsigned int getNumThreads() const {return m_numThreads;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief switch between the unindexed output (three vertices per triangle) and the indexed output
+    /// where the edge intersections are shared between neighbouring voxels and drawn from an element buffer
+    /// @param[in] _indexed true to use the indexed output. Once the VAO exists the surfaces are re-extracted
+    /// straight away
+    //----------------------------------------------------------------------------------------------------------------------
+    void setIndexed(bool _indexed);
+    bool isIndexed() const {return m_indexed;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief switch between one flat normal per triangle and smooth normals taken from the gradient of
+    /// the volume at each edge intersection
+    /// @param[in] _smooth true to use the gradient normals. Once the VAO exists the surfaces are re-extracted
+    /// straight away
+    //----------------------------------------------------------------------------------------------------------------------
+    void setSmoothNormals(bool _smooth);
+    bool getSmoothNormals() const {return m_smoothNormals;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the layouts of the vertex buffers. FLOAT is VertData, six floats a vertex. PACKED is PackedVertData,
+    /// the position in 16 bit fixed point over the box of the volume (the vertices are on a grid of known size so
+    /// that is a small fraction of a voxel) and the normal octahedral encoded into two more 16 bit values, which
+    /// makes the vertex buffers 2.4 times smaller. The shader decodes the normal when its OctahedralNormals
+    /// uniform is set
+    //----------------------------------------------------------------------------------------------------------------------
+    enum class VertexFormat {FLOAT, PACKED};
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief switch the vertex format, once the VAO exists the surfaces are re-extracted straight away
+    //----------------------------------------------------------------------------------------------------------------------
+    void setVertexFormat(VertexFormat _format);
+    VertexFormat getVertexFormat() const {return m_vertexFormat;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the ways of turning the volume into a mesh. Marching cubes puts the vertices on the cell edges, surface
+    /// nets is its dual and puts one vertex inside each cell the surface goes through (at the average of where it
+    /// crosses the edges) joined up by a quad around each crossed edge, which gives about as many vertices as the
+    /// indexed marching cubes and far fewer slivers. A cell the surface goes through more than once still gets one
+    /// vertex, so a few quads can share an edge there and the nets aren't always manifold. Surface nets always uses
+    /// the indexed output
+    //----------------------------------------------------------------------------------------------------------------------
+    enum class Mesher {MARCHING_CUBES, SURFACE_NETS};
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief switch the mesher, once the VAO exists the surfaces are re-extracted straight away
+    //----------------------------------------------------------------------------------------------------------------------
+    void setMesher(Mesher _mesher);
+    Mesher getMesher() const {return m_mesher;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief weld the vertices the slabs of the indexed output duplicate along their boundaries, so the mesh is
+    /// one connected piece. Welding (and decimating) forces the indexed output
+    //----------------------------------------------------------------------------------------------------------------------
+    void setWeldVertices(bool _weld);
+    bool getWeldVertices() const {return m_weld;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief cut each mesh down to about this many triangles with quadric error edge collapses after welding it,
+    /// see MeshDecimator. Once the VAO exists the surfaces are re-extracted straight away
+    /// @param[in] _triangles the target, 0 turns the decimation off
+    //----------------------------------------------------------------------------------------------------------------------
+    void setDecimationTarget(size_t _triangles);
+    size_t getDecimationTarget() const {return m_decimationTarget;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief extract the unindexed output of a volume in compute shaders (see GpuMarchingCubes) and draw it with an
+    /// indirect draw, on by default. The sweep on the CPU is the fallback for a context without compute shaders,
+    /// a volume too big for a 3D texture, implicit functions, sculpted volumes and the other outputs and vertex
+    /// formats. Nothing is read back while extracting, the vertex counts arrive with pollGpuExtraction. Once the
+    /// VAO exists the surfaces are re-extracted straight away
+    //----------------------------------------------------------------------------------------------------------------------
+    void setGpuExtraction(bool _gpu);
+    bool getGpuExtraction() const {return m_gpuExtraction;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief true if the current context can run the compute shaders and the volume fits them, needs a current
+    /// GL context. A viewer can ask for the unindexed output then so the GPU extraction is the one it gets
+    //----------------------------------------------------------------------------------------------------------------------
+    bool canExtractOnGpu();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief pick up the vertex counts of the GPU extractions that have finished since the last call, without
+    /// waiting for the ones still running. A mesh that turned out bigger than its vertex buffer (it is drawn cut
+    /// short until then) gets a bigger buffer and is extracted again, call it once a frame before draw
+    //----------------------------------------------------------------------------------------------------------------------
+    void pollGpuExtraction();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief skip the blocks of the volume whose min/max range does not straddle the isolevel, on by default
+    //----------------------------------------------------------------------------------------------------------------------
+    void setSkipEmptySpace(bool _skip){m_skipEmpty=_skip;}
+    bool getSkipEmptySpace() const {return m_skipEmpty;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief report every load and extraction (sizes, vertex counts and times) on std::cout, off by default. The
+    /// times of the last extraction are in getPhaseTimes either way
+    //----------------------------------------------------------------------------------------------------------------------
+    void setVerbose(bool _verbose){m_verbose=_verbose;}
+    bool getVerbose() const {return m_verbose;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief keep the mesh of the first extraction of each isolevel of a volume file in a cache file next to the
+    /// volume, and upload it straight from there instead of extracting it again the next time. Off by default
+    //----------------------------------------------------------------------------------------------------------------------
+    void setMeshCache(bool _cache){m_meshCache=_cache;}
+    bool getMeshCache() const {return m_meshCache;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of cells the last createVAO actually visited, the rest were skipped as empty space
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned long long getCellsVisited() const {return m_cellsVisited;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the size of the volume (of the current level of detail) and the type of the voxels we extract from,
+    /// generated volumes are always float
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int getVolumeWidth() const {return volume_width;}
+    unsigned int getVolumeHeight() const {return volume_height;}
+    unsigned int getVolumeDepth() const {return volume_depth;}
+    VoxelType voxelType() const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief how long (in ms) the phases of the last load and the last extraction took. The value range is found
+    /// by the min/max pyramid instead of normalising the voxels so that is the normalise phase. The cube indices are
+    /// worked out again as the vertices are interpolated so interpolate includes a second classification, and the
+    /// unindexed output is packed as it is interpolated so its pack phase is 0. A mesh from the cache has no phases
+    //----------------------------------------------------------------------------------------------------------------------
+    struct PhaseTimes
+    {
+        double load;        // mapping the file or sampling the field
+        double normalise;   // the min/max pyramid (and the hash of a file for the mesh cache)
+        double classify;    // counting pass of the unindexed output
+        double interpolate; // the sweep making the vertices
+        double post;        // welding and decimation
+        double pack;        // normals and vertex format of the indexed output
+    };
+    const PhaseTimes &getPhaseTimes() const {return m_phaseTimes;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief extract the mesh of the first isolevel into memory, no GL context needed (for tools and benchmarks).
+    /// The settings are the same as for createVAO, the vertices always come out as VertData
+    /// @param[out] _verts the vertices, three per triangle for the unindexed output
+    /// @param[out] _indices the triangles of the indexed output, left empty for the unindexed one
+    //----------------------------------------------------------------------------------------------------------------------
+    void extractMesh(std::vector<VertData> &_verts, std::vector<GLuint> &_indices);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief brush for sculpting the volume, adds a smooth bump to the voxels inside a sphere. The first stroke
+    /// copies a volume file (normalised to [0,1]) or an implicit function into memory and lays the unindexed mesh
+    /// out in chunks of ChunkCells^3 cells in the vertex buffers, after that each stroke only extracts the chunks
+    /// it touched again and rewrites their part of the buffers. The indexed output is extracted again as a whole.
+    /// Once the VAO exists the mesh is updated straight away
+    /// @param[in] _centre the centre of the brush in the space of the mesh ([-1,1] across the volume)
+    /// @param[in] _radius the radius of the brush in the same space
+    /// @param[in] _strength added at the centre falling off smoothly to nothing at the radius, negative to carve
+    //----------------------------------------------------------------------------------------------------------------------
+    void sculpt(const ngl::Vec3 &_centre, float _radius, float _strength);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the number of cells along each side of a chunk of the sculpted mesh, a multiple of the pyramid blocks
+    //----------------------------------------------------------------------------------------------------------------------
+    static const unsigned int ChunkCells = 32;
 
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief extract triangles from each voxel, add the triangles into tri vector
+    /// @brief extract triangles from each voxel
+    /// @param[in] g the voxel
+    /// @param[in] iso the isolevel
+    /// @param[out] triangles where to write the triangles, needs room for triangleCount of the voxel (at most 5)
+    /// @returns the number of triangles written
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int MachingTriangles(const Voxel &g, float iso, Triangle *triangles) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of triangles MachingTriangles makes for a cube index
     //----------------------------------------------------------------------------------------------------------------------
-    unsigned int MachingTriangles(Voxel g, float iso, std::vector<Triangle> &triList);
+    static unsigned int triangleCount(int _cubeindex);
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief intepolate the intersection point from the level value
     //----------------------------------------------------------------------------------------------------------------------
-    ngl::Vec3 VertexInterp(float isolevel, ngl::Vec3 p1, ngl::Vec3 p2, float valp1, float valp2);
+    ngl::Vec3 VertexInterp(float isolevel, const ngl::Vec3 &p1, const ngl::Vec3 &p2, float valp1, float valp2) const;
 
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief compute the normal from the three vertices
     //----------------------------------------------------------------------------------------------------------------------
-    ngl::Vec3 computeTriangleNormal(Triangle &itr);
+    ngl::Vec3 computeTriangleNormal(const Triangle &itr) const;
     float distFunc(ngl::Vec3 point1, ngl::Vec3 point2);
     float metaballFunc(float r);
 protected :
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief The volume data
+    /// @brief an isolevel converted into the value range of the voxels so they can be compared directly
+    //----------------------------------------------------------------------------------------------------------------------
+    float nativeIsolevel(float _iso) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief extract the surfaces whose isolevel has changed since they were last uploaded, in one sweep, and
+    /// write each one into the buffers of its level
+    //----------------------------------------------------------------------------------------------------------------------
+    void updateMesh();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the VAO and buffers holding the mesh of one isolevel
+    //----------------------------------------------------------------------------------------------------------------------
+    struct GpuMesh
+    {
+        ngl::VertexArrayObject *vao;
+        GLuint                  vbo;
+        GLuint                  ibo;
+        size_t                  vboCapacity;    // allocated size in bytes of the buffers
+        size_t                  iboCapacity;
+        GLsizei                 numIndices;     // vertices (or indices for the indexed mesh) to draw
+        size_t                  numVerts;       // vertices in the vertex buffer
+        float                   isolevel;       // the isolevel it was extracted at, NaN before the first one
+        std::vector<GLint>      chunkFirst;     // the chunked layout of a sculpted volume, empty otherwise. The
+        std::vector<GLsizei>    chunkCount;     // first vertex, vertices and room (in vertices) in the buffer of
+        std::vector<GLsizei>    chunkCapacity;  // each chunk
+        size_t                  chunkEnd;       // the vertices of the buffer handed out to chunks so far
+        GLuint                  indirect;       // the draw command the GPU extraction writes, 0 until it is used
+        bool                    drawIndirect;   // true if the mesh was extracted on the GPU
+        GLsync                  fence;          // the end of the GPU extraction until its vertex count is read
+    };
+    void createGpuMesh(GpuMesh &_mesh);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief point the attributes of the VAO at the vertex buffer in the current vertex format
+    //----------------------------------------------------------------------------------------------------------------------
+    void setVertexLayout(GpuMesh &_mesh);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the size of a vertex in the current vertex format
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t vertexSize() const;
+    void deleteGpuMesh(GpuMesh &_mesh);
+    void drawGpuMesh(const GpuMesh &_mesh) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief drop the chunked layout of a mesh, it is drawn as one range again
+    //----------------------------------------------------------------------------------------------------------------------
+    static void clearChunks(GpuMesh &_mesh);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief extract the stale levels on the GPU, uploading the volume first if it has changed
+    /// @returns false if the GPU can't extract this volume or output, nothing is touched then
+    //----------------------------------------------------------------------------------------------------------------------
+    bool gpuExtract(const std::vector<unsigned int> &_stale);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief read the vertex count of a mesh extracted on the GPU once the extraction is done, a mesh that didn't
+    /// fit its vertex buffer gets a bigger one and is marked stale
+    /// @param[in] _wait wait for the extraction, otherwise a mesh still being extracted is left for later
+    /// @returns true if the mesh has to be extracted again
+    //----------------------------------------------------------------------------------------------------------------------
+    bool finishGpuMesh(GpuMesh &_mesh, bool _wait);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief write the slab meshes of isolevel _level into its buffers, the slabs are released as they are packed
+    //----------------------------------------------------------------------------------------------------------------------
+    void uploadIndexedMesh(unsigned int _level, std::vector<IndexedMesh> &io_slabs);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief mark the meshes as out of date so the next refresh extracts them all again
+    //----------------------------------------------------------------------------------------------------------------------
+    void invalidateMeshes();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief true if the meshes of the current volume can go into the mesh cache, only volume files have a hash
+    //----------------------------------------------------------------------------------------------------------------------
+    bool canCache() const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the key of the mesh of isolevel _level, the flags are the indexed output, the smooth normals, the mesher, the welding and the vertex format
+    //----------------------------------------------------------------------------------------------------------------------
+    MeshCacheKey cacheKey(unsigned int _level) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief upload the mesh of isolevel _level from its cache file
+    /// @returns false if it isn't in the cache
+    //----------------------------------------------------------------------------------------------------------------------
+    bool loadCachedMesh(unsigned int _level);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief read the mesh of isolevel _level back from its buffers and write it to its cache file
+    //----------------------------------------------------------------------------------------------------------------------
+    void saveCachedMesh(unsigned int _level);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief true if the mesh is drawn from an element buffer, either asked for or because the mesher needs it
+    //----------------------------------------------------------------------------------------------------------------------
+    bool indexedOutput() const {return m_indexed || m_mesher == Mesher::SURFACE_NETS || m_weld || m_decimationTarget > 0 ||
+                                       adaptiveOutput();}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief true if the mesh comes from the adaptive extraction, see setAdaptive
+    //----------------------------------------------------------------------------------------------------------------------
+    bool adaptiveOutput() const {return m_adaptive && m_mesher == Mesher::MARCHING_CUBES && !m_function && m_stride == 1;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the level of detail drawn, always the full volume for the adaptive mesh
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int currentLod() const {return adaptiveOutput() ? 0 : m_lod;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief weld and decimate the slab meshes of one isolevel if that is switched on, they are replaced by one mesh
+    //----------------------------------------------------------------------------------------------------------------------
+    void postProcess(std::vector<IndexedMesh> &io_slabs);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief make sure the mesh of the current level of detail is extracted at the current isolevel
+    //----------------------------------------------------------------------------------------------------------------------
+    void refreshMesh();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the volume of level _lod as a volume of its own, the samples are taken every 2^_lod samples
+    /// (the last one of each axis is always included) so the coarse surface goes through the same points
+    /// as the fine one where they share samples. Made the first time it is asked for
+    //----------------------------------------------------------------------------------------------------------------------
+    MachingCube *lodLevel(unsigned int _lod);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief drop the levels of detail of the previous volume when a new one is loaded
+    //----------------------------------------------------------------------------------------------------------------------
+    void clearLods();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief take the samples of the coarse level _lod into _out, in the voxel type of this volume
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T>
+    void sampleLod(const MachingCube &_lod, T *_out) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief split the volume into the leaves of the adaptive octree for the current isolevels and error
+    /// @returns true if the leaves have changed, the surfaces have to be extracted again then
+    //----------------------------------------------------------------------------------------------------------------------
+    bool buildOctree();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief extract the levels of m_sweepLevels from the leaves of the octree, the result is laid out like the one
+    /// of runSlabs with a single slab
+    //----------------------------------------------------------------------------------------------------------------------
+    void extractAdaptive(std::vector<std::vector<IndexedMesh> > &_levelMeshes);
+    template <typename T>
+    void sweepAdaptive(std::vector<std::vector<IndexedMesh> > &_levelMeshes);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the marching cubes of the leaves [_begin,_end), run by each thread of sweepAdaptive. Every vertex comes
+    /// with the key of its edge (see AdaptiveOctree::edgeKey) so the parts can be joined up afterwards
+    /// @param[out] _meshes the mesh of each level
+    /// @param[out] _keys the keys of the vertices of each mesh
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T>
+    void sweepLeaves(size_t _begin, size_t _end, std::vector<IndexedMesh> &_meshes, std::vector<std::vector<uint64_t> > &_keys);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief close the cracks at isolevel _iso between the leaves of the octree and their finer neighbours. On each
+    /// face between them the segments the coarse cell and the fine cells cut out of it that don't match are joined
+    /// into loops lying in the plane of the face, which are filled with triangles
+    /// @param[in] _ids the vertex of each edge key in io_mesh
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T>
+    void patchCracks(float _iso, const std::unordered_map<uint64_t, GLuint> &_ids, IndexedMesh &io_mesh) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the segments the triangles of the cell of level _level starting at _start have on its face across
+    /// _axis (on its low side for _side 0, its high side for 1), as pairs of edge keys in the order the triangles
+    /// run round them
+    /// @returns false if the surface doesn't cross that face
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T>
+    bool faceSegments(const VolumeView<T> &_volume, unsigned int _level, const unsigned int _start[3], unsigned int _axis,
+                      unsigned int _side, float _iso, std::vector<std::pair<uint64_t, uint64_t> > &io_segments) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief convert a grid coordinate along _axis (0 depth, 1 height, 2 width) into the [-1,1] range of
+    /// the packed mesh, a level of detail maps it back onto the grid of the full volume first
+    //----------------------------------------------------------------------------------------------------------------------
+    float unitCoordinate(float _p, unsigned int _axis) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief map the first _size bytes of _buffer for writing, its storage is only grown when they don't fit
+    /// @param[in] _target the buffer target to bind to
+    /// @param[in] _buffer the buffer
+    /// @param[in,out] io_capacity the current size of the buffer storage
+    /// @param[in] _size bytes that will be written
+    /// @returns the mapped memory, 0 if _size is 0 or the buffer can't be mapped
+    //----------------------------------------------------------------------------------------------------------------------
+    void *mapBuffer(GLenum _target, GLuint _buffer, size_t &io_capacity, size_t _size);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief typed view of the current volume, T has to match voxelType()
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T>
+    VolumeView<T> volumeView() const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set the size of a new full volume, and the fine grid along with it
+    //----------------------------------------------------------------------------------------------------------------------
+    void setVolumeSize(unsigned int _width, unsigned int _height, unsigned int _depth);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief build the min/max pyramid of the volume, called when a volume is loaded or generated
+    //----------------------------------------------------------------------------------------------------------------------
+    void buildPyramid();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a run of cells [kBegin,kEnd) in row j of a cell layer that has to be visited
+    //----------------------------------------------------------------------------------------------------------------------
+    struct CellRun
+    {
+        unsigned int j;
+        unsigned int kBegin;
+        unsigned int kEnd;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief find the runs of cells in layer _i that are inside active blocks of the pyramid, every cell of
+    /// the layer when skipping is off. With several isolevels a block is visited if any of them is active in it
+    //----------------------------------------------------------------------------------------------------------------------
+    void findCellRuns(unsigned int _i, const std::vector<float> &_isos, std::vector<CellRun> &_runs) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the cells [begin,end) along the depth, height and width a sweep visits, a slab or a chunk
+    //----------------------------------------------------------------------------------------------------------------------
+    struct CellBox
+    {
+        unsigned int begin[3];
+        unsigned int end[3];
+    };
+    CellBox slabBox(unsigned int _begin, unsigned int _end) const;
+    CellBox chunkBox(unsigned int _chunk) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief cut the runs of a layer down to the rows and columns of the box
+    //----------------------------------------------------------------------------------------------------------------------
+    void clipRuns(const CellBox &_box, std::vector<CellRun> &io_runs) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the slices i-1 to i+2 needed to extract the voxels between slice i and i+1, the outer two are only
+    /// used by the gradient normals. They point straight into volumeData or the mapped file so the voxels are
+    /// read in their native type, for an implicit function they point into the slices sampled so far
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T>
+    struct SliceWindow
+    {
+        SliceWindow() {std::fill(sampledSlice, sampledSlice+4, ~0u);}
+        unsigned int    first;      // the slice in slot 0
+        const T        *slice[4];
+        std::vector<T>  sampled[4]; // slice s of an implicit function is kept in sampled[s&3]
+        unsigned int    sampledSlice[4];
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sample slice _s of the implicit function into _out
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T>
+    void sampleFunction(unsigned int _s, T *_out) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the position of sample _p along _axis (0 depth, 1 height, 2 width) inside the box of the implicit function
+    //----------------------------------------------------------------------------------------------------------------------
+    float functionCoordinate(unsigned int _p, unsigned int _axis) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief move the window so it holds the slices around slice _i
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T>
+    void moveWindow(SliceWindow<T> &_w, const VolumeView<T> &_volume, unsigned int _i) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief central difference gradient of the volume at a grid point (one sided on the border)
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T>
+    ngl::Vec3 gradient(const SliceWindow<T> &_w, unsigned int _i, unsigned int _j, unsigned int _k) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief unit surface normal at a point on a voxel edge, the gradients of the two grid points at the
+    /// ends of the edge are interpolated the same way as the position and negated so it points out of the
+    /// side with the higher values, which matches the winding of the triangles
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T>
+    ngl::Vec3 surfaceNormal(const SliceWindow<T> &_w, const ngl::Vec3 &_p) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief compute the cube index of every cell of a run from the window in one go
+    /// @returns the number of cells of the run the surface goes through, listed by the classifier
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T>
+    unsigned int classifyRun(RowClassifier &_classifier, const SliceWindow<T> &_w, const CellRun &_run, float _iso) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief counting pass over the slab [_begin,_end) along the depth axis, only classifies the cells so the
+    /// output can be allocated once before the triangles are made
+    /// @param[in] _begin first slice of the slab
+    /// @param[in] _end one past the last slice of the slab
+    /// @param[out] _counts the number of triangles the slab will make at each level of m_sweepLevels
+    //----------------------------------------------------------------------------------------------------------------------
+    void countSlab(unsigned int _begin, unsigned int _end, std::vector<size_t> &_counts);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief extract the triangles of all the voxels in the slab [_begin,_end) along the depth axis and write
+    /// them straight out as packed vertices, three per triangle
+    /// @param[in] _begin first slice of the slab
+    /// @param[in] _end one past the last slice of the slab
+    /// @param[in] _outs where the vertices of the slab go for each level, room for the counts from countSlab
+    //----------------------------------------------------------------------------------------------------------------------
+    void extractSlab(unsigned int _begin, unsigned int _end, std::vector<VertData *> &_outs);
+    void extractSlab(unsigned int _begin, unsigned int _end, std::vector<PackedVertData *> &_outs);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief indexed version of extractSlab, the edge intersections are cached per slice (keyed by the voxel edge)
+    /// so each one is only interpolated once and shared by all the voxels around that edge
+    /// @param[in] _begin first slice of the slab
+    /// @param[in] _end one past the last slice of the slab
+    /// @param[out] _meshes the vertices and triangle indices of the slab for each level
+    //----------------------------------------------------------------------------------------------------------------------
+    void extractSlabIndexed(unsigned int _begin, unsigned int _end, std::vector<IndexedMesh> &_meshes);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the slab extraction for voxels of type T, extractSlab and extractSlabIndexed pick the one matching
+    /// the volume so the voxels are never converted to float up front
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T, typename V>
+    void sweepSlab(const CellBox &_box, const std::vector<V *> &_outs);
+    template <typename T>
+    void sweepCount(const CellBox &_box, std::vector<size_t> &_counts) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief copy the volume into volumeData for sculpting and start the chunked layout, a file is normalised
+    /// to [0,1] on the way so the isolevels mean the same as before
+    //----------------------------------------------------------------------------------------------------------------------
+    void makeEditable();
+    template <typename T>
+    void copyNormalised(float *_out) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief forget the sculpting state, for a new volume
+    //----------------------------------------------------------------------------------------------------------------------
+    void clearSculpting();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the update of a sculpted volume, the levels in _stale (and those that lost their chunks to the
+    /// indexed output) are laid out again from scratch and the rest only get their dirty chunks
+    //----------------------------------------------------------------------------------------------------------------------
+    void updateChunks(const std::vector<unsigned int> &_stale);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief extract the chunks _chunks of the isolevels _levels (in m_sweepLevels) and write them into the buffers,
+    /// a mesh without a layout gets one from the counts so _chunks has to be all of them for it. A chunk that
+    /// outgrows its room moves to the end of the buffer
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename V>
+    void remeshChunks(const std::vector<unsigned int> &_levels, const std::vector<unsigned int> &_chunks);
+    template <typename T>
+    void sweepSlabIndexed(unsigned int _begin, unsigned int _end, std::vector<IndexedMesh> &_meshes);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the surface nets extraction of the slab [_begin,_end), the quads around the edges of a layer of cells
+    /// need the vertices of the layer before so each slab also makes those of the layer before _begin
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T>
+    void sweepSlabNets(unsigned int _begin, unsigned int _end, std::vector<IndexedMesh> &_meshes);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief run an extract method over the whole volume using one z-slab per thread
+    /// @param[in] _extract the slab extraction method
+    /// @param[out] _slabs one output per slab in slab order
+    //----------------------------------------------------------------------------------------------------------------------
+    template <class Mesh>
+    void runSlabs(void (MachingCube::*_extract)(unsigned int, unsigned int, Mesh &), std::vector<Mesh> &_slabs);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief write the three packed vertices of a triangle, with one flat normal unless we have the gradient normals
+    /// V is VertData or PackedVertData
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T, typename V>
+    void packTriangle(const SliceWindow<T> &_w, const Triangle &_tri, V *_out) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief counting pass of the unindexed mesh
+    /// @param[out] _slabCounts the number of triangles of each slab at each level
+    /// @param[out] _totals the total number of triangles of each level
+    //----------------------------------------------------------------------------------------------------------------------
+    void countTriangleMesh(std::vector<std::vector<size_t> > &_slabCounts, std::vector<size_t> &_totals);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief fill pass of the unindexed mesh, each slab writes its vertices straight into its part of the output
+    /// @param[in] _slabCounts the counts from countTriangleMesh
+    /// @param[out] _outs room for three vertices per counted triangle for each level
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename V>
+    void fillTriangleMesh(const std::vector<std::vector<size_t> > &_slabCounts, const std::vector<V *> &_outs);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief extract and pack the unindexed mesh of the current isolevel into a vector sized once by the counting pass
+    //----------------------------------------------------------------------------------------------------------------------
+    void packTriangleMesh(std::vector<VertData> &_vboMesh);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief pack the slabs of the indexed mesh, the normals are averaged over the triangles sharing a vertex
+    /// @param[in,out] io_slabs the slab meshes from extractSlabIndexed, released as they are packed
+    /// @param[out] _verts room for the vertices of all the slabs, VertData or PackedVertData
+    /// @param[out] _indices room for the indices of all the slabs
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename V>
+    void packIndexedMesh(std::vector<IndexedMesh> &io_slabs, V *_verts, GLuint *_indices);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief extract and pack the indexed mesh of the current isolevel into vectors
+    //----------------------------------------------------------------------------------------------------------------------
+    void packIndexedMesh(std::vector<VertData> &_vboMesh, std::vector<GLuint> &_indices);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief fill in the corner positions and values of the voxel with lowest corner (_i,_j,_k)
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T>
+    void fillVoxel(unsigned int _i, unsigned int _j, unsigned int _k, Voxel &_grid, const SliceWindow<T> &_w) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief The volume data of a generated volume, 0 when the volume comes from a file
     //----------------------------------------------------------------------------------------------------------------------
     float           *volumeData;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the mapped volume file, the voxels stay in the type they are stored in
+    //----------------------------------------------------------------------------------------------------------------------
+    RawVolume       m_volume;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the name of the volume file and the hash of its contents, made while the pyramid is built
+    //----------------------------------------------------------------------------------------------------------------------
+    std::string     m_volumeFile;
+    uint64_t        m_volumeHash;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief flag to indicate if the meshes are cached, see setMeshCache
+    //----------------------------------------------------------------------------------------------------------------------
+    bool            m_meshCache;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief min/max range of each block of the volume, built at load time
+    //----------------------------------------------------------------------------------------------------------------------
+    MinMaxPyramid   m_pyramid;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the implicit function and its box, empty when we extract from a volume
+    //----------------------------------------------------------------------------------------------------------------------
+    ImplicitFunction m_function;
+    ngl::Vec3       m_functionMin;
+    ngl::Vec3       m_functionMax;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief flag to indicate if blocks that can't contain the surface are skipped
+    //----------------------------------------------------------------------------------------------------------------------
+    bool            m_skipEmpty;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief flag to indicate if loads and extractions are reported on std::cout
+    //----------------------------------------------------------------------------------------------------------------------
+    bool            m_verbose;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of cells visited by the last extraction, added to by every slab
+    //----------------------------------------------------------------------------------------------------------------------
+    std::atomic<unsigned long long> m_cellsVisited;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief timings of the last load and extraction, see getPhaseTimes
+    //----------------------------------------------------------------------------------------------------------------------
+    PhaseTimes      m_phaseTimes;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief true once the volume has been sculpted, the number of chunks along the depth, height and width and
+    /// the chunks a brush has changed since the last update
+    //----------------------------------------------------------------------------------------------------------------------
+    bool            m_sculpted;
+    unsigned int    m_chunks[3];
+    std::vector<unsigned char> m_dirtyChunks;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the GPU extraction, made the first time it is used, and a flag to indicate the volume has changed
+    /// since it was last uploaded to it
+    //----------------------------------------------------------------------------------------------------------------------
+    bool            m_gpuExtraction;
+    std::unique_ptr<GpuMarchingCubes> m_gpu;
+    bool            m_gpuVolumeStale;
     float           isolevel;
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the isolevels after the first one, and the ones the running extraction makes a mesh for (in the
+    /// value range of the voxels)
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<float> m_extraIsolevels;
+    std::vector<float> m_sweepLevels;
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief The volume data dimension
     //----------------------------------------------------------------------------------------------------------------------
     unsigned int    volume_width;
     unsigned int    volume_height;
     unsigned int    volume_depth;
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of threads used for the extraction
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int    m_numThreads;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief flag to indicate if the mesh is extracted as shared vertices plus an element buffer
+    //----------------------------------------------------------------------------------------------------------------------
+    bool            m_indexed;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief flag to indicate if the normals come from the volume gradient instead of the triangles
+    //----------------------------------------------------------------------------------------------------------------------
+    bool            m_smoothNormals;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the layout of the vertex buffers
+    //----------------------------------------------------------------------------------------------------------------------
+    VertexFormat    m_vertexFormat;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the mesher used by the extraction
+    //----------------------------------------------------------------------------------------------------------------------
+    Mesher          m_mesher;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the post-pass on the indexed output, see setWeldVertices and setDecimationTarget
+    //----------------------------------------------------------------------------------------------------------------------
+    bool            m_weld;
+    size_t          m_decimationTarget;
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief The number of vertices in the object
     //----------------------------------------------------------------------------------------------------------------------
     unsigned long int m_nVerts;
@@ -111,18 +828,26 @@ protected :
     //----------------------------------------------------------------------------------------------------------------------
     std::vector<VertData> m_verts;
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief buffers for the VBO in order Vert, Tex, Norm
+    /// @brief the current level of detail and the coarse levels made so far (level 0 is this volume)
     //----------------------------------------------------------------------------------------------------------------------
-    GLuint m_vboBuffers;
+    unsigned int m_lod;
+    std::unique_ptr<MachingCube> m_lods[NumLods];
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief id for our vertexArray object
+    /// @brief for a level of detail the distance in full volume samples between its samples and the size of
+    /// the full volume (depth, height, width), the stride is 1 for a full volume
     //----------------------------------------------------------------------------------------------------------------------
-    ngl::VertexArrayObject *m_vaoMesh;
-
+    unsigned int m_stride;
+    unsigned int m_fineSize[3];
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief flag to indicate if a VBO has been created
+    /// @brief the adaptive extraction, see setAdaptive
+    //----------------------------------------------------------------------------------------------------------------------
+    bool            m_adaptive;
+    float           m_adaptiveError;
+    AdaptiveOctree  m_octree;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the VAO and buffers of each isolevel
     //----------------------------------------------------------------------------------------------------------------------
-    bool m_vbo;
+    std::vector<GpuMesh> m_meshes;
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief flag to indicate if a VBO has been created
     //----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,85 @@
+#ifndef MESHCACHE_H_
+#define MESHCACHE_H_
+//----------------------------------------------------------------------------------------------------------------------
+/// @file MeshCache.h
+/// @brief binary cache file of an extracted mesh
+//----------------------------------------------------------------------------------------------------------------------
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief everything the mesh in a cache file depends on, compared field by field when the file is opened
+//----------------------------------------------------------------------------------------------------------------------
+struct MeshCacheKey
+{
+    uint64_t volumeHash;    // hash of the contents of the volume file
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+    uint32_t bytesPerVoxel;
+    float    isolevel;
+    uint32_t flags;         // the extraction settings, see MachingCube::cacheKey
+    uint32_t decimation;    // target triangle count of the decimation, 0 for none
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class MeshCache "include/MeshCache.h"
+/// @brief a mesh stored as its vertex buffer followed by its index buffer, exactly as they are uploaded, behind a
+/// small header holding the key. Reading maps the file so the buffers go straight from the page cache to
+/// glBufferData. The data is in the byte order and layout of the machine that wrote it, the key and the format
+/// version make sure a file that doesn't match is just treated as a miss
+//----------------------------------------------------------------------------------------------------------------------
+class MeshCache
+{
+public :
+    MeshCache();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief unmaps the file
+    //----------------------------------------------------------------------------------------------------------------------
+    ~MeshCache();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief 64 bit FNV-1a hash of _size bytes, can be chained by passing the previous hash as _hash
+    //----------------------------------------------------------------------------------------------------------------------
+    static uint64_t hash(const void *_data, size_t _size, uint64_t _hash=14695981039346656037ull);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the cache file of a key, it sits next to the volume (mri.raw -> mri.0123456789abcdef.mesh)
+    //----------------------------------------------------------------------------------------------------------------------
+    static std::string fileName(const std::string &_volume, const MeshCacheKey &_key);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief write a cache file, through a temporary file so a reader never sees half of one
+    /// @returns false if the file can't be written
+    //----------------------------------------------------------------------------------------------------------------------
+    static bool write(const std::string &_file, const MeshCacheKey &_key, const void *_verts, size_t _vertBytes,
+                      const void *_indices, size_t _indexBytes);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief map a cache file
+    /// @returns false if there is no such file or it was written for another key
+    //----------------------------------------------------------------------------------------------------------------------
+    bool open(const std::string &_file, const MeshCacheKey &_key);
+    void close();
+
+    const void *getVertices() const {return m_data+HeaderSize;}
+    size_t getVertexBytes() const {return m_vertBytes;}
+    const void *getIndices() const {return m_data+HeaderSize+m_vertBytes;}
+    size_t getIndexBytes() const {return m_indexBytes;}
+
+private :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the header is the magic, the key and the two buffer sizes padded so the buffers start aligned
+    //----------------------------------------------------------------------------------------------------------------------
+    static const size_t HeaderSize = 64;
+
+    const unsigned char *m_data;
+    size_t          m_size;
+    size_t          m_vertBytes;
+    size_t          m_indexBytes;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief platforms without mmap read the whole file into this instead
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<unsigned char> m_buffer;
+};
+
+#endif
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,86 @@
+#ifndef MESHDECIMATOR_H_
+#define MESHDECIMATOR_H_
+//----------------------------------------------------------------------------------------------------------------------
+/// @file MeshDecimator.h
+/// @brief vertex welding and quadric error decimation of the indexed mesh
+//----------------------------------------------------------------------------------------------------------------------
+#include "IndexedMesh.h"
+#include <vector>
+#include <cstddef>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class MeshDecimator "include/MeshDecimator.h"
+/// @brief post-pass over the slab meshes of the indexed extraction. The slabs are merged with the vertices they
+/// duplicate along their boundaries welded back into one (the extraction computes those bit for bit the same so
+/// only exact matches are merged) and the mesh is then cut down by collapsing the edge that moves the surface
+/// least, measured with the quadric error metric of Garland and Heckbert, until it is down to the target.
+/// The decimation is split into blocks along the depth of the volume which are decimated by their own thread,
+/// the vertices a block shares with another one (and those on the open border of the surface) never move so
+/// the blocks still join up afterwards. A last pass over the whole, by then much smaller, mesh takes the seams
+/// between the blocks down as well
+//----------------------------------------------------------------------------------------------------------------------
+class MeshDecimator
+{
+public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief what a run did, the error is the distance (in voxels) from the collapsed vertices to the planes of
+    /// the triangles they replaced, as the square root of the summed squared distances of the worst collapse. The last
+    /// pass over the seams measures it against the mesh the blocks left. The decimation starts from the welded mesh
+    /// so trisIn doesn't count the triangles welding collapses
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Stats
+    {
+        size_t vertsIn;
+        size_t vertsWelded;
+        size_t vertsOut;
+        size_t trisIn;
+        size_t trisOut;
+        double maxError;
+        double weldTime;        // ms
+        double decimateTime;    // ms
+    };
+    MeshDecimator() : m_numThreads(1) {}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the number of blocks decimated at once
+    //----------------------------------------------------------------------------------------------------------------------
+    void setNumThreads(unsigned int _n){m_numThreads = _n > 0 ? _n : 1;}
+    unsigned int getNumThreads() const {return m_numThreads;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief weld the parts into one mesh and decimate it
+    /// @param[in,out] io_parts the slab meshes, released as they are merged
+    /// @param[out] _out the welded mesh, normals are only kept if the parts have them
+    /// @param[in] _targetTriangles the number of triangles to aim for, 0 only welds. The target can't always be
+    /// reached as collapses that would fold the surface over or change its topology are refused
+    //----------------------------------------------------------------------------------------------------------------------
+    Stats process(std::vector<IndexedMesh> &io_parts, IndexedMesh &_out, size_t _targetTriangles) const;
+
+private :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief merge the parts, dropping the triangles that welding leaves with a repeated vertex
+    //----------------------------------------------------------------------------------------------------------------------
+    static void weld(std::vector<IndexedMesh> &io_parts, IndexedMesh &_out);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief remove the vertices none of the triangles use and renumber the triangles
+    //----------------------------------------------------------------------------------------------------------------------
+    static void dropUnusedVertices(IndexedMesh &io_mesh);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief decimate the triangles _faces of io_mesh down to _target, run by each thread of process. Only the
+    /// vertices that belong to this block alone are moved in io_mesh
+    /// @param[in] _spareLocked leave the triangles around the locked vertices out of the count, for the blocks
+    /// that get a last pass over the whole mesh afterwards
+    /// @param[out] _indices the triangles left
+    /// @param[out] _maxError the error of the worst collapse
+    //----------------------------------------------------------------------------------------------------------------------
+    static void decimateBlock(IndexedMesh *io_mesh, const std::vector<GLuint> *_faces, size_t _target, bool _spareLocked,
+                              std::vector<GLuint> *_indices, double *_maxError);
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the size the mesh is split into blocks of, even with one thread
+    //----------------------------------------------------------------------------------------------------------------------
+    static const size_t BlockFaces = 32768;
+
+    unsigned int m_numThreads;
+};
+
+#endif
+//----------------------------------------------------------------------------------------------------------------------
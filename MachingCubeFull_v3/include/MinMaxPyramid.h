@@ -0,0 +1,233 @@
+#ifndef MINMAXPYRAMID_H_
+#define MINMAXPYRAMID_H_
+//----------------------------------------------------------------------------------------------------------------------
+/// @file MinMaxPyramid.h
+/// @brief min/max pyramid over blocks of voxels used to skip empty space
+//----------------------------------------------------------------------------------------------------------------------
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include "VolumeView.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class MinMaxPyramid "include/MinMaxPyramid.h"
+/// @brief stores the smallest and largest value of every block of BlockSize^3 cells of a volume, the level above
+/// holds the range of 2x2x2 blocks of the one below up to a single block for the whole volume. The range of a
+/// block includes the samples on its far faces (BlockSize+1 samples per axis) so a block whose range does not
+/// straddle the isolevel contains no cell the surface goes through.
+//----------------------------------------------------------------------------------------------------------------------
+class MinMaxPyramid
+{
+public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of cells along each side of a block on the finest level
+    //----------------------------------------------------------------------------------------------------------------------
+    static const unsigned int BlockSize = 8;
+
+    MinMaxPyramid() {}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief build the pyramid with one sweep over the slices of the volume
+    /// @param[in] _volume the volume
+    /// @param[in] _done called with each slice index once the sweep has finished with it, may be empty
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T>
+    void build(const VolumeView<T> &_volume, std::function<void(unsigned int)> _done=std::function<void(unsigned int)>());
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief bring the pyramid up to date after the samples in a box of the volume were changed, only the blocks
+    /// holding those samples and the ones above them are worked out again
+    /// @param[in] _volume the volume, the same size as the one the pyramid was built from
+    /// @param[in] _begin,_end the box of changed samples [_begin,_end) along the depth, height and width
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename T>
+    void update(const VolumeView<T> &_volume, const unsigned int _begin[3], const unsigned int _end[3]);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief clear the pyramid
+    //----------------------------------------------------------------------------------------------------------------------
+    void clear() {m_levels.clear();}
+    bool isEmpty() const {return m_levels.empty();}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the smallest and largest value in the whole volume
+    //----------------------------------------------------------------------------------------------------------------------
+    float getMinValue() const {return m_levels.back().minValue[0];}
+    float getMaxValue() const {return m_levels.back().maxValue[0];}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of blocks along each axis of the finest level
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int getBlocksDepth() const {return m_levels[0].depth;}
+    unsigned int getBlocksHeight() const {return m_levels[0].height;}
+    unsigned int getBlocksWidth() const {return m_levels[0].width;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief true if the surface at _iso can go through block (_bi,_bj,_bk) of the finest level, the values
+    /// below the isolevel are inside so the block needs a value below and one at or above it
+    //----------------------------------------------------------------------------------------------------------------------
+    bool isActive(unsigned int _bi, unsigned int _bj, unsigned int _bk, float _iso) const
+    {
+        return isActive(0, m_levels[0].index(_bi, _bj, _bk), _iso);
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the same for block (_bi,_bj,_bk) of level _level, which covers 2^_level blocks of the finest level
+    /// along each axis. A level above the top one is the whole volume
+    //----------------------------------------------------------------------------------------------------------------------
+    bool isActive(unsigned int _level, unsigned int _bi, unsigned int _bj, unsigned int _bk, float _iso) const
+    {
+        if(_level >= m_levels.size())
+            return isActive(m_levels.size()-1, 0, _iso);
+        return isActive(_level, m_levels[_level].index(_bi, _bj, _bk), _iso);
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of blocks of the finest level that are active at either of the two isolevels
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t countActive(float _isoA, float _isoB) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief find the active blocks of the finest level in block layer _bi by walking down the pyramid and
+    /// skipping every branch whose range does not straddle the isolevel
+    /// @param[in] _bi the block layer along the depth axis
+    /// @param[in] _iso the isolevel in the value range of the volume
+    /// @param[out] _blocks the (bj,bk) of each active block, ordered by bj then bk
+    //----------------------------------------------------------------------------------------------------------------------
+    void activeBlocks(unsigned int _bi, float _iso, std::vector<std::pair<unsigned int, unsigned int> > &_blocks) const;
+
+private :
+    struct Level
+    {
+        unsigned int depth;
+        unsigned int height;
+        unsigned int width;
+        std::vector<float> minValue;
+        std::vector<float> maxValue;
+        size_t index(unsigned int _bi, unsigned int _bj, unsigned int _bk) const
+        {
+            return ((size_t)_bi*height + _bj)*width + _bk;
+        }
+    };
+    bool isActive(unsigned int _level, size_t _index, float _iso) const
+    {
+        return m_levels[_level].minValue[_index] < _iso && m_levels[_level].maxValue[_index] >= _iso;
+    }
+    void descend(unsigned int _level, unsigned int _bj, unsigned int _bk, unsigned int _layer, float _iso,
+                 std::vector<std::pair<unsigned int, unsigned int> > &_blocks) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief allocate the levels for a volume of the given size and build the coarse levels from level 0
+    //----------------------------------------------------------------------------------------------------------------------
+    void allocate(unsigned int _depth, unsigned int _height, unsigned int _width);
+    void buildCoarseLevels();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief work out the blocks [_begin,_end) of the coarse levels again from the fine blocks [_begin,_end) below
+    //----------------------------------------------------------------------------------------------------------------------
+    void updateCoarseLevels(const unsigned int _begin[3], const unsigned int _end[3]);
+
+    std::vector<Level> m_levels;
+};
+
+template <typename T>
+void MinMaxPyramid::build(const VolumeView<T> &_volume, std::function<void(unsigned int)> _done)
+{
+    const unsigned int width = _volume.getWidth();
+    const unsigned int height = _volume.getHeight();
+    const unsigned int depth = _volume.getDepth();
+    allocate(depth, height, width);
+    Level &fine = m_levels[0];
+
+    // per slice range of each block footprint, first along the rows then down the columns
+    std::vector<T> rowMin(height*fine.width), rowMax(height*fine.width);
+    std::vector<T> sliceMin(fine.height*fine.width), sliceMax(fine.height*fine.width);
+    for(unsigned int s=0; s<depth; s++)
+    {
+        const T *slice = _volume.getSlice(s);
+        for(unsigned int j=0; j<height; j++)
+        {
+            const T *row = slice + (size_t)j*width;
+            for(unsigned int bk=0; bk<fine.width; bk++)
+            {
+                unsigned int k0 = bk*BlockSize;
+                unsigned int k1 = std::min(k0+BlockSize, width-1);
+                T lo = row[k0], hi = row[k0];
+                for(unsigned int k=k0+1; k<=k1; k++)
+                {
+                    lo = std::min(lo, row[k]);
+                    hi = std::max(hi, row[k]);
+                }
+                rowMin[j*fine.width+bk] = lo;
+                rowMax[j*fine.width+bk] = hi;
+            }
+        }
+        for(unsigned int bj=0; bj<fine.height; bj++)
+        {
+            unsigned int j0 = bj*BlockSize;
+            unsigned int j1 = std::min(j0+BlockSize, height-1);
+            for(unsigned int bk=0; bk<fine.width; bk++)
+            {
+                T lo = rowMin[j0*fine.width+bk], hi = rowMax[j0*fine.width+bk];
+                for(unsigned int j=j0+1; j<=j1; j++)
+                {
+                    lo = std::min(lo, rowMin[j*fine.width+bk]);
+                    hi = std::max(hi, rowMax[j*fine.width+bk]);
+                }
+                sliceMin[bj*fine.width+bk] = lo;
+                sliceMax[bj*fine.width+bk] = hi;
+            }
+        }
+        // a slice on a block boundary is the far face of the block before it as well
+        unsigned int bi1 = std::min(s/BlockSize, fine.depth-1);
+        unsigned int bi0 = (s%BlockSize == 0 && s > 0) ? s/BlockSize-1 : bi1;
+        for(unsigned int bi=bi0; bi<=bi1; bi++)
+        {
+            for(size_t b=0; b<sliceMin.size(); b++)
+            {
+                size_t index = (size_t)bi*sliceMin.size()+b;
+                fine.minValue[index] = std::min(fine.minValue[index], (float)sliceMin[b]);
+                fine.maxValue[index] = std::max(fine.maxValue[index], (float)sliceMax[b]);
+            }
+        }
+        if(_done)
+        {
+            _done(s);
+        }
+    }
+    buildCoarseLevels();
+}
+
+template <typename T>
+void MinMaxPyramid::update(const VolumeView<T> &_volume, const unsigned int _begin[3], const unsigned int _end[3])
+{
+    if(m_levels.empty())
+        return;
+    const unsigned int size[3] = {_volume.getDepth(), _volume.getHeight(), _volume.getWidth()};
+    Level &fine = m_levels[0];
+    const unsigned int blocks[3] = {fine.depth, fine.height, fine.width};
+    // a sample on a block boundary is also on the far face of the block before it
+    unsigned int b0[3], b1[3];
+    for(int a=0; a<3; a++)
+    {
+        b0[a] = _begin[a] > 0 ? (_begin[a]-1)/BlockSize : 0;
+        b1[a] = std::min((_end[a]-1)/BlockSize+1, blocks[a]);
+    }
+    for(unsigned int bi=b0[0]; bi<b1[0]; bi++)
+    {
+        for(unsigned int bj=b0[1]; bj<b1[1]; bj++)
+        {
+            for(unsigned int bk=b0[2]; bk<b1[2]; bk++)
+            {
+                T lo = _volume(bi*BlockSize, bj*BlockSize, bk*BlockSize), hi = lo;
+                for(unsigned int i=bi*BlockSize; i<=std::min((bi+1)*BlockSize, size[0]-1); i++)
+                {
+                    for(unsigned int j=bj*BlockSize; j<=std::min((bj+1)*BlockSize, size[1]-1); j++)
+                    {
+                        const T *row = _volume.getSlice(i) + (size_t)j*size[2];
+                        for(unsigned int k=bk*BlockSize; k<=std::min((bk+1)*BlockSize, size[2]-1); k++)
+                        {
+                            lo = std::min(lo, row[k]);
+                            hi = std::max(hi, row[k]);
+                        }
+                    }
+                }
+                fine.minValue[fine.index(bi, bj, bk)] = lo;
+                fine.maxValue[fine.index(bi, bj, bk)] = hi;
+            }
+        }
+    }
+    updateCoarseLevels(b0, b1);
+}
+
+#endif
+//----------------------------------------------------------------------------------------------------------------------
@@ -62,6 +62,47 @@ private:
     //----------------------------------------------------------------------------------------------------------------------
     bool m_translate;
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief flag to indicate if the Middle mouse button is pressed when dragging the isolevel
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_scrubIso;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the previous y mouse value for isolevel changes
+    //----------------------------------------------------------------------------------------------------------------------
+    int m_origYIso;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the isolevel asked for by the keys / mouse, passed to the mesh in paintGL so a burst of
+    /// events only re-extracts the surface once per frame
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_isolevel;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief pick the level of detail of the mesh from its distance to the camera every frame
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_autoLod;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief extract one adaptive mesh instead of the levels of detail, see MachingCube::setAdaptive
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_adaptive;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief draw the surface nets mesh instead of the marching cubes one
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_surfaceNets;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief weld and decimate the mesh, see MachingCube::setDecimationTarget
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_decimate;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief use the packed vertex format, see MachingCube::setVertexFormat
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_packedVertices;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief extract the mesh in compute shaders, see MachingCube::setGpuExtraction
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_gpuExtraction;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the context can run the compute shaders on this volume, see MachingCube::canExtractOnGpu
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_canExtractOnGpu;
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief the previous x mouse value
     //----------------------------------------------------------------------------------------------------------------------
     int m_origX;
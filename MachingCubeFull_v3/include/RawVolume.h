@@ -0,0 +1,96 @@
+#ifndef RAWVOLUME_H_
+#define RAWVOLUME_H_
+//----------------------------------------------------------------------------------------------------------------------
+/// @file RawVolume.h
+/// @brief memory mapped raw volume file
+//----------------------------------------------------------------------------------------------------------------------
+#include <string>
+#include <vector>
+#include <cstddef>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the type of the voxels stored in the raw file
+//----------------------------------------------------------------------------------------------------------------------
+enum class VoxelType {UINT8, UINT16, FLOAT};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class RawVolume "include/RawVolume.h"
+/// @brief a raw volume file (width*height*depth voxels, slice after slice) mapped into memory so the
+/// voxels are only paged in when a slice is read and can be dropped again once it has been used.
+/// The dimensions and voxel type come from a text sidecar next to the file (mri.raw -> mri.info) as
+///   Volume is 200 x 160 x 160
+///   1 byte per voxel
+/// 2 bytes per voxel is read as unsigned 16 bit and 4 bytes per voxel as float. A volume can also be made in
+/// memory with create, to fill in yourself.
+//----------------------------------------------------------------------------------------------------------------------
+class RawVolume
+{
+public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief default constructor, no file is open
+    //----------------------------------------------------------------------------------------------------------------------
+    RawVolume();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief unmaps the file
+    //----------------------------------------------------------------------------------------------------------------------
+    ~RawVolume();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief map a raw volume file, the sidecar is read for the layout
+    /// @param[in] _file the raw volume file
+    /// @returns false if the file can't be opened or is smaller than the sidecar says
+    //----------------------------------------------------------------------------------------------------------------------
+    bool open(const std::string &_file);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief make a zeroed volume in memory instead, fill it through editSlice
+    //----------------------------------------------------------------------------------------------------------------------
+    void create(unsigned int _width, unsigned int _height, unsigned int _depth, VoxelType _type);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief unmap the file
+    //----------------------------------------------------------------------------------------------------------------------
+    void close();
+    bool isOpen() const {return m_data != 0;}
+
+    unsigned int getWidth() const {return m_width;}
+    unsigned int getHeight() const {return m_height;}
+    unsigned int getDepth() const {return m_depth;}
+    VoxelType getVoxelType() const {return m_type;}
+    unsigned int getBytesPerVoxel() const {return m_bytesPerVoxel;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the raw voxels of slice _i, width*height voxels of getVoxelType
+    //----------------------------------------------------------------------------------------------------------------------
+    const unsigned char *getSlice(unsigned int _i) const {return m_data + (size_t)_i*m_sliceBytes;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the voxels of slice _i for writing, only for a volume made with create as the files are mapped read only
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned char *editSlice(unsigned int _i) {return &m_buffer[0] + (size_t)_i*m_sliceBytes;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief tell the OS we are done with the slices [_begin,_end) so their pages can be dropped from
+    /// memory, they are paged back in from the file if they are read again. A volume made in memory is kept
+    //----------------------------------------------------------------------------------------------------------------------
+    void releaseSlices(unsigned int _begin, unsigned int _end) const;
+
+protected :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief parse the sidecar of _file, falls back to the 200x160x160 8 bit layout of mri.raw if there isn't one
+    //----------------------------------------------------------------------------------------------------------------------
+    bool readInfo(const std::string &_file);
+
+    unsigned int    m_width;
+    unsigned int    m_height;
+    unsigned int    m_depth;
+    VoxelType       m_type;
+    unsigned int    m_bytesPerVoxel;
+    size_t          m_sliceBytes;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief start of the mapped file and its size in bytes
+    //----------------------------------------------------------------------------------------------------------------------
+    const unsigned char *m_data;
+    size_t          m_size;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief platforms without mmap read the whole file into this instead, and create makes the volume in it
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<unsigned char> m_buffer;
+};
+
+#endif
+//----------------------------------------------------------------------------------------------------------------------
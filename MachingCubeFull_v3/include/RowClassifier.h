@@ -0,0 +1,86 @@
+#ifndef ROWCLASSIFIER_H_
+#define ROWCLASSIFIER_H_
+//----------------------------------------------------------------------------------------------------------------------
+/// @file RowClassifier.h
+/// @brief computes the marching cubes index of a whole row of cells at once
+//----------------------------------------------------------------------------------------------------------------------
+#include <vector>
+#include <cstdint>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class RowClassifier "include/RowClassifier.h"
+/// @brief classifies a row of cells from the four rows of samples around it (rows j and j+1 of slices i and i+1)
+/// and lists the cells the surface goes through, so the triangle generation only sees those. The samples are
+/// compared against the isolevel 16 at a time with SSE2 or AVX2 (whichever the build targets) into bit masks,
+/// which are then combined into the cube indices 8 cells at a time. The scalar path does the eight tests per
+/// cell the way MachingTriangles does and is kept as the reference. Each thread needs its own classifier.
+//----------------------------------------------------------------------------------------------------------------------
+class RowClassifier
+{
+public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief which implementation classify uses
+    //----------------------------------------------------------------------------------------------------------------------
+    enum class Path {SCALAR, SIMD};
+
+    RowClassifier();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief select the implementation, SIMD by default (which is the scalar code if the build has no SSE2)
+    //----------------------------------------------------------------------------------------------------------------------
+    void setPath(Path _path) {m_path = _path;}
+    Path getPath() const {return m_path;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the instruction set the SIMD path was compiled for, "AVX2", "SSE2" or "scalar"
+    //----------------------------------------------------------------------------------------------------------------------
+    static const char *instructionSet();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief classify _cells cells against _iso, the corners are numbered as in MachingCube::fillVoxel
+    /// @param[in] _s0j row j of slice i starting at the first cell, each row holds _cells+1 samples
+    /// @param[in] _s0j1 row j+1 of slice i
+    /// @param[in] _s1j row j of slice i+1
+    /// @param[in] _s1j1 row j+1 of slice i+1
+    /// @param[in] _cells number of cells in the row
+    /// @param[in] _iso the isolevel, samples below it are inside
+    /// @returns the number of cells that are neither completely inside nor outside
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int classify(const unsigned char *_s0j, const unsigned char *_s0j1, const unsigned char *_s1j,
+                          const unsigned char *_s1j1, unsigned int _cells, float _iso);
+    unsigned int classify(const unsigned short *_s0j, const unsigned short *_s0j1, const unsigned short *_s1j,
+                          const unsigned short *_s1j1, unsigned int _cells, float _iso);
+    unsigned int classify(const float *_s0j, const float *_s0j1, const float *_s1j,
+                          const float *_s1j1, unsigned int _cells, float _iso);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the offsets of the cells found by the last classify, in increasing order
+    //----------------------------------------------------------------------------------------------------------------------
+    const unsigned int *getActive() const {return &m_active[0];}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the cube index of a cell of the last classify
+    //----------------------------------------------------------------------------------------------------------------------
+    int getCubeIndex(unsigned int _cell) const {return m_cubes[_cell];}
+
+private :
+    template <typename T>
+    unsigned int classifyScalar(const T *_rows[4], unsigned int _cells, float _iso);
+    template <typename T>
+    unsigned int classifySIMD(const T *_rows[4], unsigned int _cells, float _iso);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief make room for a row of _cells cells
+    //----------------------------------------------------------------------------------------------------------------------
+    void reserve(unsigned int _cells);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief build the cube indices from m_nibbles and collect the active cells
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int combine(unsigned int _cells);
+
+    Path                        m_path;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the low four corner bits of every sample of the row, the cube index of cell k is
+    /// m_nibbles[k] | m_nibbles[k+1]<<4
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<unsigned char>  m_nibbles;
+    std::vector<unsigned char>  m_cubes;
+    std::vector<unsigned int>   m_active;
+};
+
+#endif
+//----------------------------------------------------------------------------------------------------------------------
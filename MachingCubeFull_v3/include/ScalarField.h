@@ -0,0 +1,53 @@
+#ifndef SCALARFIELD_H_
+#define SCALARFIELD_H_
+//----------------------------------------------------------------------------------------------------------------------
+/// @file ScalarField.h
+/// @brief analytic scalar field made of metaballs, sampled into a volume
+//----------------------------------------------------------------------------------------------------------------------
+#include <vector>
+#include <cstddef>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class ScalarField "include/ScalarField.h"
+/// @brief a sum of metaballs using the falloff of MachingCube::metaballFunc, a ball adds strength at its centre
+/// down to nothing at its radius so it only has to be evaluated for the samples within that radius. The balls are
+/// kept as separate arrays (centres, radii, strengths) so the inner loop over a row of samples only streams the
+/// values it needs and can be vectorised by the compiler
+//----------------------------------------------------------------------------------------------------------------------
+class ScalarField
+{
+public :
+    ScalarField() {}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief add a metaball, the coordinates are in [0,1] across the volume with x along the depth (slices),
+    /// y along the height and z along the width
+    /// @param[in] _x,_y,_z the centre
+    /// @param[in] _radius the distance at which the ball stops having any effect, must be bigger than zero
+    /// @param[in] _strength the value at the centre, negative to carve a ball out of the others
+    //----------------------------------------------------------------------------------------------------------------------
+    void addMetaball(float _x, float _y, float _z, float _radius=1.0f, float _strength=1.0f);
+    void clear();
+    size_t getNumMetaballs() const {return m_radius.size();}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sample the field on a _width x _height x _depth grid, sample (i,j,k) is at (i/depth, j/height, k/width)
+    /// @param[out] _out room for all the samples, slice after slice
+    /// @param[in] _numThreads the slices are shared out between this many threads
+    //----------------------------------------------------------------------------------------------------------------------
+    void sample(float *_out, unsigned int _width, unsigned int _height, unsigned int _depth, unsigned int _numThreads) const;
+
+private :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief sample the slices [_begin,_end), run by each thread of sample
+    //----------------------------------------------------------------------------------------------------------------------
+    void sampleSlices(float *_out, unsigned int _width, unsigned int _height, unsigned int _depth,
+                      unsigned int _begin, unsigned int _end) const;
+
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_z;
+    std::vector<float> m_radius;
+    std::vector<float> m_strength;
+};
+
+#endif
+//----------------------------------------------------------------------------------------------------------------------
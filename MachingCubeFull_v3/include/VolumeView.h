@@ -0,0 +1,50 @@
+#ifndef VOLUMEVIEW_H_
+#define VOLUMEVIEW_H_
+//----------------------------------------------------------------------------------------------------------------------
+/// @file VolumeView.h
+/// @brief typed access to the voxels of a volume in their native type
+//----------------------------------------------------------------------------------------------------------------------
+#include <cstddef>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class VolumeView "include/VolumeView.h"
+/// @brief a non owning view of width*height*depth voxels of type T stored slice after slice, used so the
+/// extraction can be written once and run on 8 bit, 16 bit and float volumes without converting them
+//----------------------------------------------------------------------------------------------------------------------
+template <typename T>
+class VolumeView
+{
+public :
+    VolumeView(const void *_data, unsigned int _width, unsigned int _height, unsigned int _depth) :
+        m_data(static_cast<const T *>(_data)),
+        m_width(_width),
+        m_height(_height),
+        m_depth(_depth),
+        m_sliceSize((size_t)_width*_height)
+    {}
+
+    unsigned int getWidth() const {return m_width;}
+    unsigned int getHeight() const {return m_height;}
+    unsigned int getDepth() const {return m_depth;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the first voxel of slice _i
+    //----------------------------------------------------------------------------------------------------------------------
+    const T *getSlice(unsigned int _i) const {return m_data + _i*m_sliceSize;}
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the voxel in slice _i, row _j, column _k
+    //----------------------------------------------------------------------------------------------------------------------
+    T operator()(unsigned int _i, unsigned int _j, unsigned int _k) const
+    {
+        return m_data[_i*m_sliceSize + (size_t)_j*m_width + _k];
+    }
+
+private :
+    const T         *m_data;
+    unsigned int    m_width;
+    unsigned int    m_height;
+    unsigned int    m_depth;
+    size_t          m_sliceSize;
+};
+
+#endif
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,25 @@
+/// @brief first pass, the cube index of every cell and the number of triangles of each work group
+layout (local_size_x = 256) in;
+
+shared uint counts[256];
+
+void main()
+{
+  uint group = groupIndex();
+  // the last row of a two dimensional dispatch can have groups past the end
+  if(group >= numGroups)
+    return;
+  uint id = gl_LocalInvocationIndex;
+  uint cell = group*256u + id;
+  float val[8];
+  counts[id] = cell < numCells ? uint(triCount[cubeIndex(cellPosition(cell), val)]) : 0u;
+  barrier();
+  for(uint s=128u; s>0u; s>>=1)
+  {
+    if(id < s)
+      counts[id] += counts[id+s];
+    barrier();
+  }
+  if(id == 0u)
+    groupTotals[group] = counts[0];
+}
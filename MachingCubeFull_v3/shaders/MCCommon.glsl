@@ -0,0 +1,66 @@
+#version 430 core
+/// @brief the part the marching cubes compute passes share, the pass itself is appended to it. Each invocation of
+/// MCClassify and MCGenerate is one cell, numbered ((i*(height-1))+j)*(width-1)+k in the order the CPU sweeps them
+/// so the triangles come out in the same order
+
+/// @brief the volume, 8 and 16 bit voxels are read as integers so they compare with the isolevel exactly
+layout (binding = 0) uniform sampler3D volumeF;
+layout (binding = 1) uniform usampler3D volumeU;
+uniform bool integerVoxels;
+/// @brief depth, height and width of the volume (i, j, k), the texture is width x height x depth
+uniform uvec3 volumeSize;
+/// @brief the isolevel in the value range of the voxels
+uniform float isolevel;
+uniform uint numCells;
+uniform uint numGroups;
+/// @brief the room in the vertex buffer, in vertices
+uniform uint maxVertices;
+
+/// @brief edgeTable, the number of triangles of each cube index and triTable
+layout (std430, binding = 0) readonly buffer Tables
+{
+  int edgeTable[256];
+  int triCount[256];
+  int triTable[4096];
+};
+/// @brief the triangles of each work group, turned into the first triangle of each group by MCScan
+layout (std430, binding = 1) buffer Groups
+{
+  uint groupTotals[];
+};
+
+// corner n of a cell in (i,j,k), the numbering of the tables
+const ivec3 corners[8] = ivec3[8](ivec3(0,0,0), ivec3(1,0,0), ivec3(1,1,0), ivec3(0,1,0),
+                                  ivec3(0,0,1), ivec3(1,0,1), ivec3(1,1,1), ivec3(0,1,1));
+
+// the dispatch can be two dimensional when there are more groups than one dimension takes
+uint groupIndex()
+{
+  return gl_WorkGroupID.y*gl_NumWorkGroups.x + gl_WorkGroupID.x;
+}
+
+float voxel(ivec3 _p)
+{
+  ivec3 t = _p.zyx;
+  return integerVoxels ? float(texelFetch(volumeU, t, 0).r) : texelFetch(volumeF, t, 0).r;
+}
+
+ivec3 cellPosition(uint _cell)
+{
+  uint cellsWide = volumeSize.z-1u;
+  uint cellsHigh = volumeSize.y-1u;
+  return ivec3(_cell/(cellsWide*cellsHigh), (_cell/cellsWide)%cellsHigh, _cell%cellsWide);
+}
+
+// a corner is inside the surface when its value is below the isolevel
+int cubeIndex(ivec3 _cell, out float o_val[8])
+{
+  int index = 0;
+  for(int n=0; n<8; n++)
+  {
+    o_val[n] = voxel(_cell+corners[n]);
+    if(o_val[n] < isolevel)
+      index |= 1<<n;
+  }
+  return index;
+}
@@ -0,0 +1,143 @@
+/// @brief third pass, the triangles of each cell written as VertData (nx,ny,nz,x,y,z) at the first triangle of
+/// its group plus the triangles of the cells before it in the group
+layout (local_size_x = 256) in;
+
+layout (std430, binding = 3) writeonly buffer Vertices
+{
+  float verts[];
+};
+/// @brief gradient normals instead of one normal per triangle
+uniform bool smoothNormals;
+/// @brief for a level of detail the distance in full volume samples between its samples and the size of the
+/// full volume, the stride is 1 for a full volume
+uniform uint stride;
+uniform uvec3 fineSize;
+
+shared uint offsets[256];
+
+// the two corners of each edge of a cell
+const ivec2 edgeCorners[12] = ivec2[12](ivec2(0,1), ivec2(1,2), ivec2(2,3), ivec2(3,0), ivec2(4,5), ivec2(5,6),
+                                        ivec2(6,7), ivec2(7,4), ivec2(0,4), ivec2(1,5), ivec2(2,6), ivec2(3,7));
+
+vec3 vertexInterp(vec3 _p1, vec3 _p2, float _v1, float _v2)
+{
+  if(abs(isolevel-_v1) < 0.00001)
+    return _p1;
+  if(abs(isolevel-_v2) < 0.00001)
+    return _p2;
+  if(abs(_v1-_v2) < 0.00001)
+    return _p1;
+  float mu = (isolevel-_v1)/(_v2-_v1);
+  return _p1 + mu*(_p2-_p1);
+}
+
+// central differences inside the volume, one sided differences on the border
+vec3 gradient(ivec3 _p)
+{
+  ivec3 last = ivec3(volumeSize)-1;
+  vec3 g;
+  for(int a=0; a<3; a++)
+  {
+    ivec3 lo = _p, hi = _p;
+    lo[a] = max(_p[a]-1, 0);
+    hi[a] = min(_p[a]+1, last[a]);
+    g[a] = (voxel(hi)-voxel(lo))*(hi[a]-lo[a] == 2 ? 0.5 : 1.0);
+  }
+  return g;
+}
+
+// the point is on a cell edge so at most one coordinate has a fractional part, the gradients at the two ends
+// of that edge are interpolated
+vec3 surfaceNormal(vec3 _p)
+{
+  ivec3 last = ivec3(volumeSize)-1;
+  ivec3 c = min(ivec3(_p), last);
+  vec3 g = gradient(c);
+  for(int a=0; a<3; a++)
+  {
+    float mu = _p[a]-c[a];
+    if(mu > 0.0 && c[a] < last[a])
+    {
+      ivec3 next = c;
+      next[a]++;
+      g += (gradient(next)-g)*mu;
+      break;
+    }
+  }
+  // the inside of the surface has the lower values so the normal points down the gradient
+  if(length(g) > 0.0)
+    g = normalize(g);
+  return -g;
+}
+
+// from voxels to [-1,1] across the volume, a coarse sample c of a level of detail sits on the full volume sample
+// min(c*stride, last) so the last cell can be shorter
+float unitCoordinate(float _p, uint _axis)
+{
+  if(stride == 1u)
+    return _p/volumeSize[_axis]*2.0-1.0;
+  uint c = min(uint(_p), volumeSize[_axis]-2u);
+  float lo = float(c*stride);
+  float hi = float(min((c+1u)*stride, fineSize[_axis]-1u));
+  return (lo+(_p-c)*(hi-lo))/fineSize[_axis]*2.0-1.0;
+}
+
+void storeVertex(uint _v, vec3 _p, vec3 _n)
+{
+  verts[_v*6u] = _n.x;
+  verts[_v*6u+1u] = _n.y;
+  verts[_v*6u+2u] = _n.z;
+  verts[_v*6u+3u] = unitCoordinate(_p.x, 0u);
+  verts[_v*6u+4u] = unitCoordinate(_p.y, 1u);
+  verts[_v*6u+5u] = unitCoordinate(_p.z, 2u);
+}
+
+void main()
+{
+  uint group = groupIndex();
+  if(group >= numGroups)
+    return;
+  uint id = gl_LocalInvocationIndex;
+  uint cell = group*256u + id;
+  ivec3 position = cellPosition(cell);
+  float val[8];
+  int index = cell < numCells ? cubeIndex(position, val) : 0;
+  uint n = uint(triCount[index]);
+  // inclusive prefix sum of the triangles of the group
+  offsets[id] = n;
+  barrier();
+  for(uint o=1u; o<256u; o<<=1)
+  {
+    uint before = id >= o ? offsets[id-o] : 0u;
+    barrier();
+    offsets[id] += before;
+    barrier();
+  }
+  uint first = (groupTotals[group]+offsets[id]-n)*3u;
+  if(n == 0u || first >= maxVertices)
+    return;
+
+  vec3 vertlist[12];
+  int edges = edgeTable[index];
+  for(int e=0; e<12; e++)
+  {
+    if((edges & (1<<e)) != 0)
+    {
+      ivec2 ends = edgeCorners[e];
+      vertlist[e] = vertexInterp(vec3(position+corners[ends.x]), vec3(position+corners[ends.y]),
+                                 val[ends.x], val[ends.y]);
+    }
+  }
+  // a surface too big for the buffer is cut off after the last whole triangle that fits, as the draw is
+  for(uint t=0u; t<n && first+t*3u+3u <= maxVertices; t++)
+  {
+    vec3 p[3];
+    for(int v=0; v<3; v++)
+      p[v] = vertlist[triTable[index*16+int(t)*3+v]];
+    vec3 normal = cross(p[1]-p[0], p[2]-p[0]);
+    if(length(normal) > 0.0)
+      normal = normalize(normal);
+    for(int v=0; v<3; v++)
+      storeVertex(first+t*3u+uint(v), p[v], smoothNormals ? surfaceNormal(p[v]) : normal);
+  }
+}
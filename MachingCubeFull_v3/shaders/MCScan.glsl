@@ -0,0 +1,52 @@
+/// @brief second pass, one work group turns the triangles of each group into the first triangle of the group
+/// (an exclusive prefix sum) and writes the glDrawArraysIndirect command, for the triangles that fit in the
+/// vertex buffer, and the vertices of the whole surface
+layout (local_size_x = 1024) in;
+
+layout (std430, binding = 2) buffer Indirect
+{
+  uint vertexCount;
+  uint instanceCount;
+  uint firstVertex;
+  uint baseInstance;
+  uint totalVertices;
+};
+
+shared uint sums[1024];
+
+void main()
+{
+  // each invocation sums a run of groups, the runs are scanned in shared memory and then each
+  // invocation writes the offsets of its own run
+  uint id = gl_LocalInvocationIndex;
+  uint perInvocation = (numGroups+1023u)/1024u;
+  uint begin = min(id*perInvocation, numGroups);
+  uint end = min(begin+perInvocation, numGroups);
+  uint sum = 0u;
+  for(uint g=begin; g<end; g++)
+    sum += groupTotals[g];
+  sums[id] = sum;
+  barrier();
+  for(uint o=1u; o<1024u; o<<=1)
+  {
+    uint before = id >= o ? sums[id-o] : 0u;
+    barrier();
+    sums[id] += before;
+    barrier();
+  }
+  uint offset = sums[id]-sum;
+  for(uint g=begin; g<end; g++)
+  {
+    uint n = groupTotals[g];
+    groupTotals[g] = offset;
+    offset += n;
+  }
+  if(id == 1023u)
+  {
+    totalVertices = sums[1023]*3u;
+    vertexCount = min(totalVertices, maxVertices/3u*3u);
+    instanceCount = 1u;
+    firstVertex = 0u;
+    baseInstance = 0u;
+  }
+}
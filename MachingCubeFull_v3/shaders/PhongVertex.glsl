@@ -5,6 +5,8 @@ layout (location = 0) in vec3 inVert;
 layout (location = 1) in vec3 inNormal;
 /// @brief flag to indicate if model has unit normals if not normalize
 uniform bool Normalize;
+/// @brief flag to indicate the normal is octahedral encoded in inNormal.xy (the packed vertex format)
+uniform bool OctahedralNormals;
 // the eye position of the camera
 uniform vec3 viewerPos;
 /// @brief the current fragment normal for the vert being processed
@@ -48,10 +50,22 @@ uniform mat3 normalMatrix;
 uniform mat4 M;
 
 
+// unfold the octahedral encoding, the lower half of the sphere is folded over the diagonals of the upper one
+vec3 octahedralDecode(vec2 e)
+{
+  vec3 n = vec3(e, 1.0-abs(e.x)-abs(e.y));
+  if (n.z < 0.0)
+  {
+    n.xy = (1.0-abs(n.yx))*vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+  }
+  return normalize(n);
+}
+
 void main()
 {
 // calculate the fragments surface normal
-fragmentNormal = (normalMatrix*inNormal);
+vec3 normal = OctahedralNormals ? octahedralDecode(inNormal.xy) : inNormal;
+fragmentNormal = (normalMatrix*normal);
 
 
 if (Normalize == true)
@@ -0,0 +1,166 @@
+#include "AdaptiveOctree.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file AdaptiveOctree.cpp
+/// @brief octree choosing the sample spacing of each part of the volume for the adaptive extraction
+//----------------------------------------------------------------------------------------------------------------------
+
+void AdaptiveOctree::clear()
+{
+    m_levels = 0;
+    std::fill(m_size, m_size+3, 0);
+    std::fill(m_nodes, m_nodes+3, 0);
+    m_grid.clear();
+    m_errors.clear();
+    m_leaves.clear();
+}
+
+void AdaptiveOctree::resize(unsigned int _depth, unsigned int _height, unsigned int _width, unsigned int _levels)
+{
+    if(m_size[0] == _depth && m_size[1] == _height && m_size[2] == _width && m_levels == _levels)
+        return;
+    clear();
+    m_size[0] = _depth;
+    m_size[1] = _height;
+    m_size[2] = _width;
+    m_levels = std::max(1u, _levels);
+    // the nodes cover the cells like the blocks of the pyramid, there is one cell less than samples along each axis
+    for(int a=0; a<3; a++)
+    {
+        m_nodes[a] = std::max(1u, (m_size[a]-1+LeafCells-1)/LeafCells);
+    }
+    m_grid.assign((size_t)m_nodes[0]*m_nodes[1]*m_nodes[2], 0);
+    m_errors.resize(m_levels);
+    for(unsigned int l=1; l<m_levels; l++)
+    {
+        m_errors[l].assign((size_t)nodesAt(l, 0)*nodesAt(l, 1)*nodesAt(l, 2), NAN);
+    }
+}
+
+size_t AdaptiveOctree::countLeaves(unsigned int _level) const
+{
+    size_t count = 0;
+    for(size_t l=0; l<m_leaves.size(); l++)
+    {
+        if(m_leaves[l].level == _level)
+            ++count;
+    }
+    return count;
+}
+
+unsigned int AdaptiveOctree::maxLevelAt(const unsigned int _p[3], int _axis) const
+{
+    // a sample on the boundary between two nodes touches both of them, an edge only the one it runs through
+    unsigned int lo[3], hi[3];
+    for(int a=0; a<3; a++)
+    {
+        hi[a] = std::min(_p[a]/LeafCells, m_nodes[a]-1);
+        lo[a] = hi[a];
+        if(a != _axis && _p[a]%LeafCells == 0 && _p[a] > 0)
+            lo[a] = std::min(_p[a]/LeafCells-1, m_nodes[a]-1);
+    }
+    unsigned int level = 0;
+    for(unsigned int i=lo[0]; i<=hi[0]; i++)
+    {
+        for(unsigned int j=lo[1]; j<=hi[1]; j++)
+        {
+            for(unsigned int k=lo[2]; k<=hi[2]; k++)
+            {
+                level = std::max(level, leafLevel(i, j, k));
+            }
+        }
+    }
+    return level;
+}
+
+uint64_t AdaptiveOctree::edgeKey(unsigned int io_p[3], unsigned int _axis, unsigned int &io_level) const
+{
+    // leaves that touch are at most one level apart so an edge is only ever moved up one level
+    const unsigned int b = (_axis+1)%3;
+    const unsigned int c = (_axis+2)%3;
+    if(io_level+1 < m_levels && onLattice(io_p[b], b, io_level+1) && onLattice(io_p[c], c, io_level+1) &&
+       maxLevelAt(io_p, _axis) > io_level)
+    {
+        ++io_level;
+        io_p[_axis] -= io_p[_axis]%(1u<<io_level);
+    }
+    // 20 bits for each coordinate, the axis and the level
+    return ((uint64_t)io_p[0]<<44) | ((uint64_t)io_p[1]<<24) | ((uint64_t)io_p[2]<<4) | (_axis<<2) | io_level;
+}
+
+void AdaptiveOctree::setLevel(const unsigned int _begin[3], const unsigned int _end[3], unsigned int _level,
+                              std::vector<unsigned char> &io_grid) const
+{
+    for(unsigned int i=_begin[0]; i<_end[0]; i++)
+    {
+        for(unsigned int j=_begin[1]; j<_end[1]; j++)
+        {
+            std::fill(io_grid.begin()+((size_t)i*m_nodes[1] + j)*m_nodes[2] + _begin[2],
+                      io_grid.begin()+((size_t)i*m_nodes[1] + j)*m_nodes[2] + _end[2], (unsigned char)_level);
+        }
+    }
+}
+
+void AdaptiveOctree::balance(std::vector<unsigned char> &io_grid) const
+{
+    // a split can make the leaves around it too coarse in turn so we go round until nothing changes, which takes
+    // at most one round per level
+    bool changed = true;
+    while(changed)
+    {
+        changed = false;
+        for(unsigned int i=0; i<m_nodes[0]; i++)
+        {
+            for(unsigned int j=0; j<m_nodes[1]; j++)
+            {
+                for(unsigned int k=0; k<m_nodes[2]; k++)
+                {
+                    const size_t node = ((size_t)i*m_nodes[1] + j)*m_nodes[2] + k;
+                    unsigned int finest = io_grid[node];
+                    for(unsigned int ni=(i > 0 ? i-1 : 0); ni<=std::min(i+1, m_nodes[0]-1); ni++)
+                        for(unsigned int nj=(j > 0 ? j-1 : 0); nj<=std::min(j+1, m_nodes[1]-1); nj++)
+                            for(unsigned int nk=(k > 0 ? k-1 : 0); nk<=std::min(k+1, m_nodes[2]-1); nk++)
+                                finest = std::min(finest, (unsigned int)io_grid[((size_t)ni*m_nodes[1] + nj)*m_nodes[2] + nk]);
+                    const unsigned int level = io_grid[node];
+                    if(level <= finest+1)
+                        continue;
+                    // split the leaf this node is in into its children
+                    const unsigned int p[3] = {i, j, k};
+                    unsigned int begin[3], end[3];
+                    for(int a=0; a<3; a++)
+                    {
+                        begin[a] = p[a]>>level<<level;
+                        end[a] = std::min(begin[a]+(1u<<level), m_nodes[a]);
+                    }
+                    setLevel(begin, end, level-1, io_grid);
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+void AdaptiveOctree::collectLeaves()
+{
+    m_leaves.clear();
+    for(unsigned int i=0; i<m_nodes[0]; i++)
+    {
+        for(unsigned int j=0; j<m_nodes[1]; j++)
+        {
+            for(unsigned int k=0; k<m_nodes[2]; k++)
+            {
+                // the first level 0 node of each leaf stands for it
+                const unsigned int level = leafLevel(i, j, k);
+                const unsigned int mask = (1u<<level)-1;
+                if((i & mask) || (j & mask) || (k & mask))
+                    continue;
+                Leaf leaf;
+                leaf.level = level;
+                leaf.origin[0] = i*LeafCells;
+                leaf.origin[1] = j*LeafCells;
+                leaf.origin[2] = k*LeafCells;
+                m_leaves.push_back(leaf);
+            }
+        }
+    }
+}
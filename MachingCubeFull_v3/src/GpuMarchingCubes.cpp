@@ -0,0 +1,252 @@
+#include "GpuMarchingCubes.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file GpuMarchingCubes.cpp
+/// @brief marching cubes in GL 4.3 compute shaders
+//----------------------------------------------------------------------------------------------------------------------
+
+GpuMarchingCubes::GpuMarchingCubes()
+{
+    m_ready = false;
+    m_classify = 0;
+    m_scan = 0;
+    m_generate = 0;
+    m_tables = 0;
+    m_groups = 0;
+    m_groupsCapacity = 0;
+    m_texture = 0;
+    m_type = VoxelType::FLOAT;
+    std::fill(m_size, m_size+3, 0);
+    m_stride = 1;
+    std::fill(m_fineSize, m_fineSize+3, 0);
+}
+
+GpuMarchingCubes::~GpuMarchingCubes()
+{
+    // glDelete* ignore 0 so this is fine for a backend that never got going
+    glDeleteProgram(m_classify);
+    glDeleteProgram(m_scan);
+    glDeleteProgram(m_generate);
+    glDeleteBuffers(1, &m_tables);
+    glDeleteBuffers(1, &m_groups);
+    glDeleteTextures(1, &m_texture);
+}
+
+std::string GpuMarchingCubes::readFile(const std::string &_file)
+{
+    std::ifstream in(_file.c_str());
+    std::stringstream source;
+    source<<in.rdbuf();
+    return source.str();
+}
+
+GLuint GpuMarchingCubes::loadProgram(const std::string &_common, const std::string &_file)
+{
+    const std::string pass = readFile(_file);
+    if(_common.empty() || pass.empty())
+    {
+        std::cout<<"can't read "<<_file<<" or shaders/MCCommon.glsl\n";
+        return 0;
+    }
+    // the common part starts with the #version so it goes first
+    const char *sources[2] = {_common.c_str(), pass.c_str()};
+    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(shader, 2, sources, 0);
+    glCompileShader(shader);
+    GLint ok = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    GLuint program = 0;
+    if(ok == GL_TRUE)
+    {
+        program = glCreateProgram();
+        glAttachShader(program, shader);
+        glLinkProgram(program);
+        glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    }
+    if(ok != GL_TRUE)
+    {
+        char log[4096] = "";
+        if(program != 0)
+            glGetProgramInfoLog(program, sizeof(log), 0, log);
+        else
+            glGetShaderInfoLog(shader, sizeof(log), 0, log);
+        std::cout<<_file<<" failed to build\n"<<log<<"\n";
+        glDeleteProgram(program);
+        program = 0;
+    }
+    glDeleteShader(shader);
+    return program;
+}
+
+bool GpuMarchingCubes::init(const int _edgeTable[256], const int _triTable[256][16])
+{
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if(major < 4 || (major == 4 && minor < 3))
+    {
+        std::cout<<"GL "<<major<<"."<<minor<<" has no compute shaders, extracting on the CPU\n";
+        return false;
+    }
+    const std::string common = readFile("shaders/MCCommon.glsl");
+    m_classify = loadProgram(common, "shaders/MCClassify.glsl");
+    m_scan = loadProgram(common, "shaders/MCScan.glsl");
+    m_generate = loadProgram(common, "shaders/MCGenerate.glsl");
+    if(m_classify == 0 || m_scan == 0 || m_generate == 0)
+    {
+        std::cout<<"extracting on the CPU\n";
+        return false;
+    }
+    // laid out as the Tables block of MCCommon.glsl
+    std::vector<GLint> tables(256+256+256*16);
+    for(int c=0; c<256; c++)
+    {
+        tables[c] = _edgeTable[c];
+        int n = 0;
+        while(_triTable[c][n] != -1)
+            n++;
+        tables[256+c] = n/3;
+        std::copy(_triTable[c], _triTable[c]+16, &tables[512+c*16]);
+    }
+    glGenBuffers(1, &m_tables);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_tables);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, tables.size()*sizeof(GLint), &tables[0], GL_STATIC_DRAW);
+    glGenBuffers(1, &m_groups);
+    m_ready = true;
+    return true;
+}
+
+bool GpuMarchingCubes::canHold(unsigned int _width, unsigned int _height, unsigned int _depth) const
+{
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxSize);
+    if(_width > (unsigned int)maxSize || _height > (unsigned int)maxSize || _depth > (unsigned int)maxSize)
+        return false;
+    // the cells are numbered in a uint, and so are the cells of the last (partly empty) work group
+    const unsigned long long cells = (unsigned long long)(_width-1)*(_height-1)*(_depth-1);
+    return cells+GroupCells <= 0xffffffffull;
+}
+
+bool GpuMarchingCubes::setVolume(VoxelType _type, unsigned int _width, unsigned int _height, unsigned int _depth)
+{
+    glDeleteTextures(1, &m_texture);
+    m_texture = 0;
+    if(!canHold(_width, _height, _depth))
+    {
+        std::cout<<"the volume is too big for a 3D texture or the compute shaders, extracting on the CPU\n";
+        return false;
+    }
+    m_type = _type;
+    m_size[0] = _depth;
+    m_size[1] = _height;
+    m_size[2] = _width;
+    // the integer formats keep the voxels as they are, a normalised format would need scaling back which
+    // can round a voxel onto the other side of the isolevel
+    const GLenum format[3] = {GL_R8UI, GL_R16UI, GL_R32F};
+    glGenTextures(1, &m_texture);
+    glBindTexture(GL_TEXTURE_3D, m_texture);
+    glTexStorage3D(GL_TEXTURE_3D, 1, format[(int)_type], _width, _height, _depth);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    return true;
+}
+
+void GpuMarchingCubes::uploadSlice(unsigned int _s, const void *_voxels)
+{
+    const GLenum format[3] = {GL_RED_INTEGER, GL_RED_INTEGER, GL_RED};
+    const GLenum type[3] = {GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_FLOAT};
+    glBindTexture(GL_TEXTURE_3D, m_texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, _s, m_size[2], m_size[1], 1, format[(int)m_type], type[(int)m_type], _voxels);
+}
+
+void GpuMarchingCubes::setStride(unsigned int _stride, const unsigned int _fineSize[3])
+{
+    m_stride = _stride;
+    std::copy(_fineSize, _fineSize+3, m_fineSize);
+}
+
+GLuint GpuMarchingCubes::numCells() const
+{
+    return (GLuint)((unsigned long long)(m_size[0]-1)*(m_size[1]-1)*(m_size[2]-1));
+}
+
+void GpuMarchingCubes::dispatch(GLuint _program, float _iso, bool _perCell)
+{
+    const GLuint cells = numCells();
+    const GLuint groups = (cells+GroupCells-1)/GroupCells;
+    glUseProgram(_program);
+    glUniform1i(glGetUniformLocation(_program, "integerVoxels"), m_type != VoxelType::FLOAT);
+    glUniform3ui(glGetUniformLocation(_program, "volumeSize"), m_size[0], m_size[1], m_size[2]);
+    glUniform1f(glGetUniformLocation(_program, "isolevel"), _iso);
+    glUniform1ui(glGetUniformLocation(_program, "numCells"), cells);
+    glUniform1ui(glGetUniformLocation(_program, "numGroups"), groups);
+    if(!_perCell)
+    {
+        glDispatchCompute(1, 1, 1);
+        return;
+    }
+    // there can be more groups than one dimension of a dispatch takes, the shaders number them row by row
+    const GLuint wide = std::min(groups, 32768u);
+    glDispatchCompute(wide, (groups+wide-1)/wide, 1);
+}
+
+void GpuMarchingCubes::extract(float _iso, bool _smoothNormals, GLuint _vbo, size_t _capacity, GLuint _indirect)
+{
+    const size_t groups = (numCells()+GroupCells-1)/GroupCells;
+    if(groups > m_groupsCapacity)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_groups);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, groups*sizeof(GLuint), 0, GL_DYNAMIC_COPY);
+        m_groupsCapacity = groups;
+    }
+    // an empty command until the scan writes the real one, which is all there is for a volume without cells.
+    // The vertices of the whole surface go after it
+    const GLuint empty[5] = {0, 1, 0, 0, 0};
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _indirect);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(empty), empty, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    if(groups == 0 || _capacity == 0)
+        return;
+    const GLuint maxVertices = (GLuint)std::min<size_t>(_capacity/(6*sizeof(GLfloat)), 0xffffffffu);
+    glActiveTexture(GL_TEXTURE0+(m_type == VoxelType::FLOAT ? 0 : 1));
+    glBindTexture(GL_TEXTURE_3D, m_texture);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_tables);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_groups);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _indirect);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, _vbo);
+
+    dispatch(m_classify, _iso, true);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    glUseProgram(m_scan);
+    glUniform1ui(glGetUniformLocation(m_scan, "maxVertices"), maxVertices);
+    dispatch(m_scan, _iso, false);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    glUseProgram(m_generate);
+    glUniform1ui(glGetUniformLocation(m_generate, "maxVertices"), maxVertices);
+    glUniform1i(glGetUniformLocation(m_generate, "smoothNormals"), _smoothNormals);
+    glUniform1ui(glGetUniformLocation(m_generate, "stride"), m_stride);
+    glUniform3ui(glGetUniformLocation(m_generate, "fineSize"), m_fineSize[0], m_fineSize[1], m_fineSize[2]);
+    dispatch(m_generate, _iso, true);
+    // the vertices are read as attributes and the count by the indirect draw
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    for(GLuint b=0; b<4; b++)
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, b, 0);
+    }
+    glUseProgram(0);
+}
+
+size_t GpuMarchingCubes::vertexCount(GLuint _indirect)
+{
+    GLuint nVerts = 0;
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _indirect);
+    glGetBufferSubData(GL_DRAW_INDIRECT_BUFFER, 4*sizeof(GLuint), sizeof(GLuint), &nVerts);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    return nVerts;
+}
@@ -1,246 +1,3128 @@
 #include "MachingCube.h"
+#include <cstring>
+#include <cfloat>
 
 //----------------------------------------------------------------------------------------------------------------------
 /// @file MachingCube.cpp
 /// @brief the basic maching cube algorithm
 //----------------------------------------------------------------------------------------------------------------------
 
+// Lookup tables from http://paulbourke.net/geometry/polygonise/
+
+/*
+   int edgeTable[256].  It corresponds to the 2^8 possible combinations of
+   of the eight (n) vertices either existing inside or outside (2^n) of the
+   surface.  A vertex is inside of a surface if the value at that vertex is
+   less than that of the surface you are scanning for.  The table index is
+   constructed bitwise with bit 0 corresponding to vertex 0, bit 1 to vert
+   1.. bit 7 to vert 7.  The value in the table tells you which edges of
+   the table are intersected by the surface.  Once again bit 0 corresponds
+   to edge 0 and so on, up to edge 12.
+   Constructing the table simply consisted of having a program run thru
+   the 256 cases and setting the edge bit if the vertices at either end of
+   the edge had different values (one is inside while the other is out).
+   The purpose of the table is to speed up the scanning process.  Only the
+   edges whose bit's are set contain vertices of the surface.
+   Vertex 0 is on the bottom face, back edge, left side.
+   The progression of vertices is clockwise around the bottom face
+   and then clockwise around the top face of the cube.  Edge 0 goes from
+   vertex 0 to vertex 1, Edge 1 is from 2->3 and so on around clockwise to
+   vertex 0 again. Then Edge 4 to 7 make up the top face, 4->5, 5->6, 6->7
+   and 7->4.  Edge 8 thru 11 are the vertical edges from vert 0->4, 1->5,
+   2->6, and 3->7.
+       4--------5     *---4----*
+      /|       /|    /|       /|
+     / |      / |   7 |      5 |
+    /  |     /  |  /  8     /  9
+   7--------6   | *----6---*   |
+   |   |    |   | |   |    |   |
+   |   0----|---1 |   *---0|---*
+   |  /     |  /  11 /     10 /
+   | /      | /   | 3      | 1
+   |/       |/    |/       |/
+   3--------2     *---2----*
+*/
+static const int edgeTable[256]={
+0x0  , 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c,
+0x80c, 0x905, 0xa0f, 0xb06, 0xc0a, 0xd03, 0xe09, 0xf00,
+0x190, 0x99 , 0x393, 0x29a, 0x596, 0x49f, 0x795, 0x69c,
+0x99c, 0x895, 0xb9f, 0xa96, 0xd9a, 0xc93, 0xf99, 0xe90,
+0x230, 0x339, 0x33 , 0x13a, 0x636, 0x73f, 0x435, 0x53c,
+0xa3c, 0xb35, 0x83f, 0x936, 0xe3a, 0xf33, 0xc39, 0xd30,
+0x3a0, 0x2a9, 0x1a3, 0xaa , 0x7a6, 0x6af, 0x5a5, 0x4ac,
+0xbac, 0xaa5, 0x9af, 0x8a6, 0xfaa, 0xea3, 0xda9, 0xca0,
+0x460, 0x569, 0x663, 0x76a, 0x66 , 0x16f, 0x265, 0x36c,
+0xc6c, 0xd65, 0xe6f, 0xf66, 0x86a, 0x963, 0xa69, 0xb60,
+0x5f0, 0x4f9, 0x7f3, 0x6fa, 0x1f6, 0xff , 0x3f5, 0x2fc,
+0xdfc, 0xcf5, 0xfff, 0xef6, 0x9fa, 0x8f3, 0xbf9, 0xaf0,
+0x650, 0x759, 0x453, 0x55a, 0x256, 0x35f, 0x55 , 0x15c,
+0xe5c, 0xf55, 0xc5f, 0xd56, 0xa5a, 0xb53, 0x859, 0x950,
+0x7c0, 0x6c9, 0x5c3, 0x4ca, 0x3c6, 0x2cf, 0x1c5, 0xcc ,
+0xfcc, 0xec5, 0xdcf, 0xcc6, 0xbca, 0xac3, 0x9c9, 0x8c0,
+0x8c0, 0x9c9, 0xac3, 0xbca, 0xcc6, 0xdcf, 0xec5, 0xfcc,
+0xcc , 0x1c5, 0x2cf, 0x3c6, 0x4ca, 0x5c3, 0x6c9, 0x7c0,
+0x950, 0x859, 0xb53, 0xa5a, 0xd56, 0xc5f, 0xf55, 0xe5c,
+0x15c, 0x55 , 0x35f, 0x256, 0x55a, 0x453, 0x759, 0x650,
+0xaf0, 0xbf9, 0x8f3, 0x9fa, 0xef6, 0xfff, 0xcf5, 0xdfc,
+0x2fc, 0x3f5, 0xff , 0x1f6, 0x6fa, 0x7f3, 0x4f9, 0x5f0,
+0xb60, 0xa69, 0x963, 0x86a, 0xf66, 0xe6f, 0xd65, 0xc6c,
+0x36c, 0x265, 0x16f, 0x66 , 0x76a, 0x663, 0x569, 0x460,
+0xca0, 0xda9, 0xea3, 0xfaa, 0x8a6, 0x9af, 0xaa5, 0xbac,
+0x4ac, 0x5a5, 0x6af, 0x7a6, 0xaa , 0x1a3, 0x2a9, 0x3a0,
+0xd30, 0xc39, 0xf33, 0xe3a, 0x936, 0x83f, 0xb35, 0xa3c,
+0x53c, 0x435, 0x73f, 0x636, 0x13a, 0x33 , 0x339, 0x230,
+0xe90, 0xf99, 0xc93, 0xd9a, 0xa96, 0xb9f, 0x895, 0x99c,
+0x69c, 0x795, 0x49f, 0x596, 0x29a, 0x393, 0x99 , 0x190,
+0xf00, 0xe09, 0xd03, 0xc0a, 0xb06, 0xa0f, 0x905, 0x80c,
+0x70c, 0x605, 0x50f, 0x406, 0x30a, 0x203, 0x109, 0x0   };
+
+/*
+   int triTable[256][16] also corresponds to the 256 possible combinations
+   of vertices.
+   The [16] dimension of the table is again the list of edges of the cube
+   which are intersected by the surface.  This time however, the edges are
+   enumerated in the order of the vertices making up the triangle mesh of
+   the surface.  Each edge contains one vertex that is on the surface.
+   Each triple of edges listed in the table contains the vertices of one
+   triangle on the mesh.  The are 16 entries because it has been shown that
+   there are at most 5 triangles in a cube and each "edge triple" list is
+   terminated with the value -1.
+   For example triTable[3] contains
+   {1, 8, 3, 9, 8, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}
+   This corresponds to the case of a cube whose vertex 0 and 1 are inside
+   of the surface and the rest of the verts are outside (00000001 bitwise
+   OR'ed with 00000010 makes 00000011 == 3).  Therefore, this cube is
+   intersected by the surface roughly in the form of a plane which cuts
+   edges 8,9,1 and 3.  This quadrilateral can be constructed from two
+   triangles: one which is made of the intersection vertices found on edges
+   1,8, and 3; the other is formed from the vertices on edges 9,8, and 1.
+   Remember, each intersected edge contains only one surface vertex.  The
+   vertex triples are listed in counter clockwise order for proper facing.
+*/
+static const int triTable[256][16] =
+{{-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{0, 1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{1, 8, 3, 9, 8, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{0, 8, 3, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{9, 2, 10, 0, 2, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{2, 8, 3, 2, 10, 8, 10, 9, 8, -1, -1, -1, -1, -1, -1, -1},
+{3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{0, 11, 2, 8, 11, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{1, 9, 0, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{1, 11, 2, 1, 9, 11, 9, 8, 11, -1, -1, -1, -1, -1, -1, -1},
+{3, 10, 1, 11, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{0, 10, 1, 0, 8, 10, 8, 11, 10, -1, -1, -1, -1, -1, -1, -1},
+{3, 9, 0, 3, 11, 9, 11, 10, 9, -1, -1, -1, -1, -1, -1, -1},
+{9, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{4, 3, 0, 7, 3, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{0, 1, 9, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{4, 1, 9, 4, 7, 1, 7, 3, 1, -1, -1, -1, -1, -1, -1, -1},
+{1, 2, 10, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{3, 4, 7, 3, 0, 4, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1},
+{9, 2, 10, 9, 0, 2, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1},
+{2, 10, 9, 2, 9, 7, 2, 7, 3, 7, 9, 4, -1, -1, -1, -1},
+{8, 4, 7, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{11, 4, 7, 11, 2, 4, 2, 0, 4, -1, -1, -1, -1, -1, -1, -1},
+{9, 0, 1, 8, 4, 7, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1},
+{4, 7, 11, 9, 4, 11, 9, 11, 2, 9, 2, 1, -1, -1, -1, -1},
+{3, 10, 1, 3, 11, 10, 7, 8, 4, -1, -1, -1, -1, -1, -1, -1},
+{1, 11, 10, 1, 4, 11, 1, 0, 4, 7, 11, 4, -1, -1, -1, -1},
+{4, 7, 8, 9, 0, 11, 9, 11, 10, 11, 0, 3, -1, -1, -1, -1},
+{4, 7, 11, 4, 11, 9, 9, 11, 10, -1, -1, -1, -1, -1, -1, -1},
+{9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{9, 5, 4, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{0, 5, 4, 1, 5, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{8, 5, 4, 8, 3, 5, 3, 1, 5, -1, -1, -1, -1, -1, -1, -1},
+{1, 2, 10, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{3, 0, 8, 1, 2, 10, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1},
+{5, 2, 10, 5, 4, 2, 4, 0, 2, -1, -1, -1, -1, -1, -1, -1},
+{2, 10, 5, 3, 2, 5, 3, 5, 4, 3, 4, 8, -1, -1, -1, -1},
+{9, 5, 4, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{0, 11, 2, 0, 8, 11, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1},
+{0, 5, 4, 0, 1, 5, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1},
+{2, 1, 5, 2, 5, 8, 2, 8, 11, 4, 8, 5, -1, -1, -1, -1},
+{10, 3, 11, 10, 1, 3, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1},
+{4, 9, 5, 0, 8, 1, 8, 10, 1, 8, 11, 10, -1, -1, -1, -1},
+{5, 4, 0, 5, 0, 11, 5, 11, 10, 11, 0, 3, -1, -1, -1, -1},
+{5, 4, 8, 5, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1},
+{9, 7, 8, 5, 7, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{9, 3, 0, 9, 5, 3, 5, 7, 3, -1, -1, -1, -1, -1, -1, -1},
+{0, 7, 8, 0, 1, 7, 1, 5, 7, -1, -1, -1, -1, -1, -1, -1},
+{1, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{9, 7, 8, 9, 5, 7, 10, 1, 2, -1, -1, -1, -1, -1, -1, -1},
+{10, 1, 2, 9, 5, 0, 5, 3, 0, 5, 7, 3, -1, -1, -1, -1},
+{8, 0, 2, 8, 2, 5, 8, 5, 7, 10, 5, 2, -1, -1, -1, -1},
+{2, 10, 5, 2, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1},
+{7, 9, 5, 7, 8, 9, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1},
+{9, 5, 7, 9, 7, 2, 9, 2, 0, 2, 7, 11, -1, -1, -1, -1},
+{2, 3, 11, 0, 1, 8, 1, 7, 8, 1, 5, 7, -1, -1, -1, -1},
+{11, 2, 1, 11, 1, 7, 7, 1, 5, -1, -1, -1, -1, -1, -1, -1},
+{9, 5, 8, 8, 5, 7, 10, 1, 3, 10, 3, 11, -1, -1, -1, -1},
+{5, 7, 0, 5, 0, 9, 7, 11, 0, 1, 0, 10, 11, 10, 0, -1},
+{11, 10, 0, 11, 0, 3, 10, 5, 0, 8, 0, 7, 5, 7, 0, -1},
+{11, 10, 5, 7, 11, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{0, 8, 3, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{9, 0, 1, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{1, 8, 3, 1, 9, 8, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1},
+{1, 6, 5, 2, 6, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{1, 6, 5, 1, 2, 6, 3, 0, 8, -1, -1, -1, -1, -1, -1, -1},
+{9, 6, 5, 9, 0, 6, 0, 2, 6, -1, -1, -1, -1, -1, -1, -1},
+{5, 9, 8, 5, 8, 2, 5, 2, 6, 3, 2, 8, -1, -1, -1, -1},
+{2, 3, 11, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{11, 0, 8, 11, 2, 0, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1},
+{0, 1, 9, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1},
+{5, 10, 6, 1, 9, 2, 9, 11, 2, 9, 8, 11, -1, -1, -1, -1},
+{6, 3, 11, 6, 5, 3, 5, 1, 3, -1, -1, -1, -1, -1, -1, -1},
+{0, 8, 11, 0, 11, 5, 0, 5, 1, 5, 11, 6, -1, -1, -1, -1},
+{3, 11, 6, 0, 3, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1},
+{6, 5, 9, 6, 9, 11, 11, 9, 8, -1, -1, -1, -1, -1, -1, -1},
+{5, 10, 6, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{4, 3, 0, 4, 7, 3, 6, 5, 10, -1, -1, -1, -1, -1, -1, -1},
+{1, 9, 0, 5, 10, 6, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1},
+{10, 6, 5, 1, 9, 7, 1, 7, 3, 7, 9, 4, -1, -1, -1, -1},
+{6, 1, 2, 6, 5, 1, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1},
+{1, 2, 5, 5, 2, 6, 3, 0, 4, 3, 4, 7, -1, -1, -1, -1},
+{8, 4, 7, 9, 0, 5, 0, 6, 5, 0, 2, 6, -1, -1, -1, -1},
+{7, 3, 9, 7, 9, 4, 3, 2, 9, 5, 9, 6, 2, 6, 9, -1},
+{3, 11, 2, 7, 8, 4, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1},
+{5, 10, 6, 4, 7, 2, 4, 2, 0, 2, 7, 11, -1, -1, -1, -1},
+{0, 1, 9, 4, 7, 8, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1},
+{9, 2, 1, 9, 11, 2, 9, 4, 11, 7, 11, 4, 5, 10, 6, -1},
+{8, 4, 7, 3, 11, 5, 3, 5, 1, 5, 11, 6, -1, -1, -1, -1},
+{5, 1, 11, 5, 11, 6, 1, 0, 11, 7, 11, 4, 0, 4, 11, -1},
+{0, 5, 9, 0, 6, 5, 0, 3, 6, 11, 6, 3, 8, 4, 7, -1},
+{6, 5, 9, 6, 9, 11, 4, 7, 9, 7, 11, 9, -1, -1, -1, -1},
+{10, 4, 9, 6, 4, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{4, 10, 6, 4, 9, 10, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1},
+{10, 0, 1, 10, 6, 0, 6, 4, 0, -1, -1, -1, -1, -1, -1, -1},
+{8, 3, 1, 8, 1, 6, 8, 6, 4, 6, 1, 10, -1, -1, -1, -1},
+{1, 4, 9, 1, 2, 4, 2, 6, 4, -1, -1, -1, -1, -1, -1, -1},
+{3, 0, 8, 1, 2, 9, 2, 4, 9, 2, 6, 4, -1, -1, -1, -1},
+{0, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{8, 3, 2, 8, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1},
+{10, 4, 9, 10, 6, 4, 11, 2, 3, -1, -1, -1, -1, -1, -1, -1},
+{0, 8, 2, 2, 8, 11, 4, 9, 10, 4, 10, 6, -1, -1, -1, -1},
+{3, 11, 2, 0, 1, 6, 0, 6, 4, 6, 1, 10, -1, -1, -1, -1},
+{6, 4, 1, 6, 1, 10, 4, 8, 1, 2, 1, 11, 8, 11, 1, -1},
+{9, 6, 4, 9, 3, 6, 9, 1, 3, 11, 6, 3, -1, -1, -1, -1},
+{8, 11, 1, 8, 1, 0, 11, 6, 1, 9, 1, 4, 6, 4, 1, -1},
+{3, 11, 6, 3, 6, 0, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1},
+{6, 4, 8, 11, 6, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{7, 10, 6, 7, 8, 10, 8, 9, 10, -1, -1, -1, -1, -1, -1, -1},
+{0, 7, 3, 0, 10, 7, 0, 9, 10, 6, 7, 10, -1, -1, -1, -1},
+{10, 6, 7, 1, 10, 7, 1, 7, 8, 1, 8, 0, -1, -1, -1, -1},
+{10, 6, 7, 10, 7, 1, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1},
+{1, 2, 6, 1, 6, 8, 1, 8, 9, 8, 6, 7, -1, -1, -1, -1},
+{2, 6, 9, 2, 9, 1, 6, 7, 9, 0, 9, 3, 7, 3, 9, -1},
+{7, 8, 0, 7, 0, 6, 6, 0, 2, -1, -1, -1, -1, -1, -1, -1},
+{7, 3, 2, 6, 7, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{2, 3, 11, 10, 6, 8, 10, 8, 9, 8, 6, 7, -1, -1, -1, -1},
+{2, 0, 7, 2, 7, 11, 0, 9, 7, 6, 7, 10, 9, 10, 7, -1},
+{1, 8, 0, 1, 7, 8, 1, 10, 7, 6, 7, 10, 2, 3, 11, -1},
+{11, 2, 1, 11, 1, 7, 10, 6, 1, 6, 7, 1, -1, -1, -1, -1},
+{8, 9, 6, 8, 6, 7, 9, 1, 6, 11, 6, 3, 1, 3, 6, -1},
+{0, 9, 1, 11, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{7, 8, 0, 7, 0, 6, 3, 11, 0, 11, 6, 0, -1, -1, -1, -1},
+{7, 11, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{3, 0, 8, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{0, 1, 9, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{8, 1, 9, 8, 3, 1, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1},
+{10, 1, 2, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{1, 2, 10, 3, 0, 8, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1},
+{2, 9, 0, 2, 10, 9, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1},
+{6, 11, 7, 2, 10, 3, 10, 8, 3, 10, 9, 8, -1, -1, -1, -1},
+{7, 2, 3, 6, 2, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{7, 0, 8, 7, 6, 0, 6, 2, 0, -1, -1, -1, -1, -1, -1, -1},
+{2, 7, 6, 2, 3, 7, 0, 1, 9, -1, -1, -1, -1, -1, -1, -1},
+{1, 6, 2, 1, 8, 6, 1, 9, 8, 8, 7, 6, -1, -1, -1, -1},
+{10, 7, 6, 10, 1, 7, 1, 3, 7, -1, -1, -1, -1, -1, -1, -1},
+{10, 7, 6, 1, 7, 10, 1, 8, 7, 1, 0, 8, -1, -1, -1, -1},
+{0, 3, 7, 0, 7, 10, 0, 10, 9, 6, 10, 7, -1, -1, -1, -1},
+{7, 6, 10, 7, 10, 8, 8, 10, 9, -1, -1, -1, -1, -1, -1, -1},
+{6, 8, 4, 11, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{3, 6, 11, 3, 0, 6, 0, 4, 6, -1, -1, -1, -1, -1, -1, -1},
+{8, 6, 11, 8, 4, 6, 9, 0, 1, -1, -1, -1, -1, -1, -1, -1},
+{9, 4, 6, 9, 6, 3, 9, 3, 1, 11, 3, 6, -1, -1, -1, -1},
+{6, 8, 4, 6, 11, 8, 2, 10, 1, -1, -1, -1, -1, -1, -1, -1},
+{1, 2, 10, 3, 0, 11, 0, 6, 11, 0, 4, 6, -1, -1, -1, -1},
+{4, 11, 8, 4, 6, 11, 0, 2, 9, 2, 10, 9, -1, -1, -1, -1},
+{10, 9, 3, 10, 3, 2, 9, 4, 3, 11, 3, 6, 4, 6, 3, -1},
+{8, 2, 3, 8, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1},
+{0, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{1, 9, 0, 2, 3, 4, 2, 4, 6, 4, 3, 8, -1, -1, -1, -1},
+{1, 9, 4, 1, 4, 2, 2, 4, 6, -1, -1, -1, -1, -1, -1, -1},
+{8, 1, 3, 8, 6, 1, 8, 4, 6, 6, 10, 1, -1, -1, -1, -1},
+{10, 1, 0, 10, 0, 6, 6, 0, 4, -1, -1, -1, -1, -1, -1, -1},
+{4, 6, 3, 4, 3, 8, 6, 10, 3, 0, 3, 9, 10, 9, 3, -1},
+{10, 9, 4, 6, 10, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{4, 9, 5, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{0, 8, 3, 4, 9, 5, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1},
+{5, 0, 1, 5, 4, 0, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1},
+{11, 7, 6, 8, 3, 4, 3, 5, 4, 3, 1, 5, -1, -1, -1, -1},
+{9, 5, 4, 10, 1, 2, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1},
+{6, 11, 7, 1, 2, 10, 0, 8, 3, 4, 9, 5, -1, -1, -1, -1},
+{7, 6, 11, 5, 4, 10, 4, 2, 10, 4, 0, 2, -1, -1, -1, -1},
+{3, 4, 8, 3, 5, 4, 3, 2, 5, 10, 5, 2, 11, 7, 6, -1},
+{7, 2, 3, 7, 6, 2, 5, 4, 9, -1, -1, -1, -1, -1, -1, -1},
+{9, 5, 4, 0, 8, 6, 0, 6, 2, 6, 8, 7, -1, -1, -1, -1},
+{3, 6, 2, 3, 7, 6, 1, 5, 0, 5, 4, 0, -1, -1, -1, -1},
+{6, 2, 8, 6, 8, 7, 2, 1, 8, 4, 8, 5, 1, 5, 8, -1},
+{9, 5, 4, 10, 1, 6, 1, 7, 6, 1, 3, 7, -1, -1, -1, -1},
+{1, 6, 10, 1, 7, 6, 1, 0, 7, 8, 7, 0, 9, 5, 4, -1},
+{4, 0, 10, 4, 10, 5, 0, 3, 10, 6, 10, 7, 3, 7, 10, -1},
+{7, 6, 10, 7, 10, 8, 5, 4, 10, 4, 8, 10, -1, -1, -1, -1},
+{6, 9, 5, 6, 11, 9, 11, 8, 9, -1, -1, -1, -1, -1, -1, -1},
+{3, 6, 11, 0, 6, 3, 0, 5, 6, 0, 9, 5, -1, -1, -1, -1},
+{0, 11, 8, 0, 5, 11, 0, 1, 5, 5, 6, 11, -1, -1, -1, -1},
+{6, 11, 3, 6, 3, 5, 5, 3, 1, -1, -1, -1, -1, -1, -1, -1},
+{1, 2, 10, 9, 5, 11, 9, 11, 8, 11, 5, 6, -1, -1, -1, -1},
+{0, 11, 3, 0, 6, 11, 0, 9, 6, 5, 6, 9, 1, 2, 10, -1},
+{11, 8, 5, 11, 5, 6, 8, 0, 5, 10, 5, 2, 0, 2, 5, -1},
+{6, 11, 3, 6, 3, 5, 2, 10, 3, 10, 5, 3, -1, -1, -1, -1},
+{5, 8, 9, 5, 2, 8, 5, 6, 2, 3, 8, 2, -1, -1, -1, -1},
+{9, 5, 6, 9, 6, 0, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1},
+{1, 5, 8, 1, 8, 0, 5, 6, 8, 3, 8, 2, 6, 2, 8, -1},
+{1, 5, 6, 2, 1, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{1, 3, 6, 1, 6, 10, 3, 8, 6, 5, 6, 9, 8, 9, 6, -1},
+{10, 1, 0, 10, 0, 6, 9, 5, 0, 5, 6, 0, -1, -1, -1, -1},
+{0, 3, 8, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{10, 5, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{11, 5, 10, 7, 5, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{11, 5, 10, 11, 7, 5, 8, 3, 0, -1, -1, -1, -1, -1, -1, -1},
+{5, 11, 7, 5, 10, 11, 1, 9, 0, -1, -1, -1, -1, -1, -1, -1},
+{10, 7, 5, 10, 11, 7, 9, 8, 1, 8, 3, 1, -1, -1, -1, -1},
+{11, 1, 2, 11, 7, 1, 7, 5, 1, -1, -1, -1, -1, -1, -1, -1},
+{0, 8, 3, 1, 2, 7, 1, 7, 5, 7, 2, 11, -1, -1, -1, -1},
+{9, 7, 5, 9, 2, 7, 9, 0, 2, 2, 11, 7, -1, -1, -1, -1},
+{7, 5, 2, 7, 2, 11, 5, 9, 2, 3, 2, 8, 9, 8, 2, -1},
+{2, 5, 10, 2, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1},
+{8, 2, 0, 8, 5, 2, 8, 7, 5, 10, 2, 5, -1, -1, -1, -1},
+{9, 0, 1, 5, 10, 3, 5, 3, 7, 3, 10, 2, -1, -1, -1, -1},
+{9, 8, 2, 9, 2, 1, 8, 7, 2, 10, 2, 5, 7, 5, 2, -1},
+{1, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{0, 8, 7, 0, 7, 1, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1},
+{9, 0, 3, 9, 3, 5, 5, 3, 7, -1, -1, -1, -1, -1, -1, -1},
+{9, 8, 7, 5, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{5, 8, 4, 5, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1},
+{5, 0, 4, 5, 11, 0, 5, 10, 11, 11, 3, 0, -1, -1, -1, -1},
+{0, 1, 9, 8, 4, 10, 8, 10, 11, 10, 4, 5, -1, -1, -1, -1},
+{10, 11, 4, 10, 4, 5, 11, 3, 4, 9, 4, 1, 3, 1, 4, -1},
+{2, 5, 1, 2, 8, 5, 2, 11, 8, 4, 5, 8, -1, -1, -1, -1},
+{0, 4, 11, 0, 11, 3, 4, 5, 11, 2, 11, 1, 5, 1, 11, -1},
+{0, 2, 5, 0, 5, 9, 2, 11, 5, 4, 5, 8, 11, 8, 5, -1},
+{9, 4, 5, 2, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{2, 5, 10, 3, 5, 2, 3, 4, 5, 3, 8, 4, -1, -1, -1, -1},
+{5, 10, 2, 5, 2, 4, 4, 2, 0, -1, -1, -1, -1, -1, -1, -1},
+{3, 10, 2, 3, 5, 10, 3, 8, 5, 4, 5, 8, 0, 1, 9, -1},
+{5, 10, 2, 5, 2, 4, 1, 9, 2, 9, 4, 2, -1, -1, -1, -1},
+{8, 4, 5, 8, 5, 3, 3, 5, 1, -1, -1, -1, -1, -1, -1, -1},
+{0, 4, 5, 1, 0, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{8, 4, 5, 8, 5, 3, 9, 0, 5, 0, 3, 5, -1, -1, -1, -1},
+{9, 4, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{4, 11, 7, 4, 9, 11, 9, 10, 11, -1, -1, -1, -1, -1, -1, -1},
+{0, 8, 3, 4, 9, 7, 9, 11, 7, 9, 10, 11, -1, -1, -1, -1},
+{1, 10, 11, 1, 11, 4, 1, 4, 0, 7, 4, 11, -1, -1, -1, -1},
+{3, 1, 4, 3, 4, 8, 1, 10, 4, 7, 4, 11, 10, 11, 4, -1},
+{4, 11, 7, 9, 11, 4, 9, 2, 11, 9, 1, 2, -1, -1, -1, -1},
+{9, 7, 4, 9, 11, 7, 9, 1, 11, 2, 11, 1, 0, 8, 3, -1},
+{11, 7, 4, 11, 4, 2, 2, 4, 0, -1, -1, -1, -1, -1, -1, -1},
+{11, 7, 4, 11, 4, 2, 8, 3, 4, 3, 2, 4, -1, -1, -1, -1},
+{2, 9, 10, 2, 7, 9, 2, 3, 7, 7, 4, 9, -1, -1, -1, -1},
+{9, 10, 7, 9, 7, 4, 10, 2, 7, 8, 7, 0, 2, 0, 7, -1},
+{3, 7, 10, 3, 10, 2, 7, 4, 10, 1, 10, 0, 4, 0, 10, -1},
+{1, 10, 2, 8, 7, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{4, 9, 1, 4, 1, 7, 7, 1, 3, -1, -1, -1, -1, -1, -1, -1},
+{4, 9, 1, 4, 1, 7, 0, 8, 1, 8, 7, 1, -1, -1, -1, -1},
+{4, 0, 3, 7, 4, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{4, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{9, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{3, 0, 9, 3, 9, 11, 11, 9, 10, -1, -1, -1, -1, -1, -1, -1},
+{0, 1, 10, 0, 10, 8, 8, 10, 11, -1, -1, -1, -1, -1, -1, -1},
+{3, 1, 10, 11, 3, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{1, 2, 11, 1, 11, 9, 9, 11, 8, -1, -1, -1, -1, -1, -1, -1},
+{3, 0, 9, 3, 9, 11, 1, 2, 9, 2, 11, 9, -1, -1, -1, -1},
+{0, 2, 11, 8, 0, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{3, 2, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{2, 3, 8, 2, 8, 10, 10, 8, 9, -1, -1, -1, -1, -1, -1, -1},
+{9, 10, 2, 0, 9, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{2, 3, 8, 2, 8, 10, 0, 1, 8, 1, 10, 8, -1, -1, -1, -1},
+{1, 10, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{1, 3, 8, 9, 1, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{0, 9, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{0, 3, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+{-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}};
+
+
+/*-------------------------------------------------------------------------
+   The number of triangles in each row of the triTable, so the output can be
+   sized from the cube indices alone
+*/
+struct TriangleCountTable
+{
+    TriangleCountTable()
+    {
+        for(int c=0; c<256; c++)
+        {
+            int n = 0;
+            while(triTable[c][n] != -1)
+                n++;
+            count[c] = n/3;
+        }
+    }
+    unsigned char count[256];
+};
+static const TriangleCountTable s_triangleCount;
+
+/*-------------------------------------------------------------------------
+   Determine the index into the edge table which tells us which vertices
+   are inside of the surface
+*/
+static int computeCubeIndex(const Voxel &g, float iso)
+{
+    int cubeindex = 0;
+    if (g.val[0] < iso) cubeindex |= 1;
+    if (g.val[1] < iso) cubeindex |= 2;
+    if (g.val[2] < iso) cubeindex |= 4;
+    if (g.val[3] < iso) cubeindex |= 8;
+    if (g.val[4] < iso) cubeindex |= 16;
+    if (g.val[5] < iso) cubeindex |= 32;
+    if (g.val[6] < iso) cubeindex |= 64;
+    if (g.val[7] < iso) cubeindex |= 128;
+    return cubeindex;
+}
+
+/*-------------------------------------------------------------------------
+   For each of the 12 cube edges: the two corners ordered from the lower to
+   the higher grid position (so a shared edge is always interpolated the same
+   way round), which edge cache it lives in (0 slice i, 1 slice i+1, 2 the
+   depth edges running between the two slices), the j/k offset of its lower
+   corner and whether it runs along j (0) or k (1) inside its slice.
+*/
+static const int edgeCache[12][6] =
+{
+    {0, 1, 2, 0, 0, 0},
+    {1, 2, 1, 0, 0, 0},
+    {3, 2, 2, 1, 0, 0},
+    {0, 3, 0, 0, 0, 0},
+    {4, 5, 2, 0, 1, 0},
+    {5, 6, 1, 0, 1, 0},
+    {7, 6, 2, 1, 1, 0},
+    {4, 7, 0, 0, 1, 0},
+    {0, 4, 0, 0, 0, 1},
+    {1, 5, 1, 0, 0, 1},
+    {2, 6, 1, 1, 0, 1},
+    {3, 7, 0, 1, 0, 1}
+};
+
+// write a vertex in one of the two vertex formats, the position is already in the [-1,1] box
+static inline void storeVertex(VertData &_d, float _x, float _y, float _z, const ngl::Vec3 &_normal)
+{
+    _d.x = _x;
+    _d.y = _y;
+    _d.z = _z;
+    _d.nx = _normal.m_x;
+    _d.ny = _normal.m_y;
+    _d.nz = _normal.m_z;
+}
+
+static inline GLshort toSnorm16(float _v)
+{
+    return (GLshort)std::lround(std::max(-1.0f, std::min(1.0f, _v))*32767.0f);
+}
+
+static inline void storeVertex(PackedVertData &_d, float _x, float _y, float _z, const ngl::Vec3 &_normal)
+{
+    _d.x = toSnorm16(_x);
+    _d.y = toSnorm16(_y);
+    _d.z = toSnorm16(_z);
+    // octahedral encoding, the normal is projected onto the octahedron |x|+|y|+|z|=1 and the lower half is
+    // folded over the upper one, a zero normal comes out as (0,0,1). PhongVertex.glsl undoes it
+    const float l1 = std::fabs(_normal.m_x)+std::fabs(_normal.m_y)+std::fabs(_normal.m_z);
+    float u = l1 > 0.0f ? _normal.m_x/l1 : 0.0f;
+    float v = l1 > 0.0f ? _normal.m_y/l1 : 0.0f;
+    if(_normal.m_z < 0.0f)
+    {
+        const float fu = (1.0f-std::fabs(v))*(u >= 0.0f ? 1.0f : -1.0f);
+        const float fv = (1.0f-std::fabs(u))*(v >= 0.0f ? 1.0f : -1.0f);
+        u = fu;
+        v = fv;
+    }
+    _d.nu = toSnorm16(u);
+    _d.nv = toSnorm16(v);
+}
+
+static inline double millisecondsSince(std::chrono::steady_clock::time_point _start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-_start).count();
+}
+
+static void clearExtractionTimes(MachingCube::PhaseTimes &_times)
+{
+    _times.classify = 0.0;
+    _times.interpolate = 0.0;
+    _times.post = 0.0;
+    _times.pack = 0.0;
+}
+
 MachingCube::MachingCube()
 {
-    m_vbo=false;
-    m_vao=false;
-    isolevel = 0.8;
+    m_vao=false;
+    m_lod = 0;
+    m_stride = 1;
+    std::fill(m_fineSize, m_fineSize+3, 0);
+    m_adaptive = false;
+    m_adaptiveError = 0.02f;
+    volumeData = 0;
+    isolevel = 0.8;
+    m_indexed = false;
+    m_smoothNormals = false;
+    m_vertexFormat = VertexFormat::FLOAT;
+    m_mesher = Mesher::MARCHING_CUBES;
+    m_weld = false;
+    m_decimationTarget = 0;
+    m_skipEmpty = true;
+    m_verbose = false;
+    m_meshCache = false;
+    m_volumeHash = 0;
+    m_cellsVisited = 0;
+    m_phaseTimes = PhaseTimes();
+    m_sculpted = false;
+    std::fill(m_chunks, m_chunks+3, 1);
+    m_gpuExtraction = true;
+    m_gpuVolumeStale = true;
+    setNumThreads(0);
+}
+
+void MachingCube::setNumThreads(unsigned int _n)
+{
+    if(_n == 0)
+        _n = std::thread::hardware_concurrency();
+    // hardware_concurrency is allowed to return 0 if it can't tell
+    m_numThreads = _n > 0 ? _n : 1;
+}
+
+void MachingCube::setVolumeSize(unsigned int _width, unsigned int _height, unsigned int _depth)
+{
+    volume_width = _width;
+    volume_height = _height;
+    volume_depth = _depth;
+    // a full volume is its own fine grid, only lodLevel sets up a coarser one
+    m_fineSize[0] = _depth;
+    m_fineSize[1] = _height;
+    m_fineSize[2] = _width;
+}
+
+bool MachingCube::LoadVolumeFromFile(std::string _vol)
+{
+    // the file is only mapped here, the extraction streams it a few slices at a time
+    // so we never hold a full copy of the volume in memory
+    delete [] volumeData;
+    volumeData = 0;
+    m_function = ImplicitFunction();
+    clearLods();
+    clearSculpting();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if(m_volume.open(_vol) != true)
+    {
+        return false;
+    }
+    m_phaseTimes.load = millisecondsSince(start);
+    m_volumeFile = _vol;
+    m_gpuVolumeStale = true;
+    setVolumeSize(m_volume.getWidth(), m_volume.getHeight(), m_volume.getDepth());
+    if(m_verbose)
+        std::cout<<"Volume is "<<volume_width<<" x "<<volume_height<<" x "<<volume_depth<<", "
+                 <<m_volume.getBytesPerVoxel()<<" byte per voxel\n";
+    start = std::chrono::steady_clock::now();
+    buildPyramid();
+    m_phaseTimes.normalise = millisecondsSince(start);
+    return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+MachingCube::~MachingCube()
+{
+    delete [] volumeData;
+
+    m_verts.erase(m_verts.begin(),m_verts.end());
+    for(size_t l=0;l<m_meshes.size();l++)
+    {
+        deleteGpuMesh(m_meshes[l]);
+    }
+}
+
+float MachingCube::distFunc(ngl::Vec3 point1, ngl::Vec3 point2)
+{
+    ngl::Vec3 vec = point1 - point2;
+    return (vec.length());
+}
+
+float MachingCube::metaballFunc(float r)
+{
+    // r is the distance from the sampling point to
+    // the centre of the all, it must be bigger than zero
+    float a = 1.0;
+    float b = 1.0;
+    if(r>=0 && r <=b/3.0)
+        return a*(1.0-3.0*r*r/b/b);
+    if(r<b && r >=b/3.0)
+        return 3.0*a/2.0*(1.0-r/b)*(1.0-r/b);
+    if(r>=b)
+        return 0;
+}
+
+void MachingCube::generateVolume()
+{
+    ScalarField field;
+    field.addMetaball(0.1, 0.5, 0.5);
+    field.addMetaball(0.9, 0.5, 0.5);
+    generateVolume(field, 100, 100, 100);
+    isolevel = 1;
+}
+
+void MachingCube::generateVolume(const ScalarField &_field, unsigned int _width, unsigned int _height, unsigned int _depth)
+{
+    setVolumeSize(_width, _height, _depth);
+
+    m_volume.close();
+    m_function = ImplicitFunction();
+    clearLods();
+    clearSculpting();
+    delete [] volumeData;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    volumeData = new float[(size_t)volume_width*volume_height*volume_depth];
+    _field.sample(volumeData, volume_width, volume_height, volume_depth, m_numThreads);
+    m_phaseTimes.load = millisecondsSince(start);
+    m_gpuVolumeStale = true;
+    start = std::chrono::steady_clock::now();
+    buildPyramid();
+    m_phaseTimes.normalise = millisecondsSince(start);
+}
+
+void MachingCube::setImplicitFunction(const ImplicitFunction &_f, const ngl::Vec3 &_min, const ngl::Vec3 &_max,
+                                      unsigned int _width, unsigned int _height, unsigned int _depth)
+{
+    setVolumeSize(_width, _height, _depth);
+    m_function = _f;
+    m_functionMin = _min;
+    m_functionMax = _max;
+
+    m_volume.close();
+    clearLods();
+    clearSculpting();
+    delete [] volumeData;
+    volumeData = 0;
+    // the pyramid would need the whole field sampled once, so we go without and visit every cell
+    m_pyramid.clear();
+    // the function is only sampled as it is swept so it has nothing to load
+    m_phaseTimes.load = 0.0;
+    m_phaseTimes.normalise = 0.0;
+}
+
+float MachingCube::functionCoordinate(unsigned int _p, unsigned int _axis) const
+{
+    const unsigned int size[3] = {volume_depth, volume_height, volume_width};
+    // a level of detail samples the function where the full grid has its samples
+    float p = _p;
+    float last = size[_axis]-1;
+    if(m_stride != 1)
+    {
+        p = std::min(_p*m_stride, m_fineSize[_axis]-1);
+        last = m_fineSize[_axis]-1;
+    }
+    return m_functionMin[_axis]+(m_functionMax[_axis]-m_functionMin[_axis])*p/last;
+}
+
+template <typename T>
+void MachingCube::sampleFunction(unsigned int _s, T *_out) const
+{
+    const float x = functionCoordinate(_s, 0);
+    for(unsigned int j=0;j<volume_height;j++)
+    {
+        const float y = functionCoordinate(j, 1);
+        for(unsigned int k=0;k<volume_width;k++)
+        {
+            *_out++ = m_function(x, y, functionCoordinate(k, 2));
+        }
+    }
+}
+
+template <class Mesh>
+void MachingCube::runSlabs(void (MachingCube::*_extract)(unsigned int, unsigned int, Mesh &), std::vector<Mesh> &_slabs)
+{
+    // split the volume into one z-slab per thread, each slab gets its own output mesh
+    // so the workers never touch shared data, the caller merges them in slab order
+    // which gives exactly the same result (and order) as the serial extraction
+    unsigned int nCells = volume_depth-1;
+    unsigned int nSlabs = std::max(1u, std::min(m_numThreads, nCells));
+    _slabs.resize(nSlabs);
+    if(nSlabs == 1)
+    {
+        (this->*_extract)(0, nCells, _slabs[0]);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for(unsigned int i=0;i<nSlabs;i++)
+    {
+        unsigned int begin = nCells*i/nSlabs;
+        unsigned int end = nCells*(i+1)/nSlabs;
+        workers.push_back(std::thread(_extract, this, begin, end, std::ref(_slabs[i])));
+    }
+    for(unsigned int i=0;i<nSlabs;i++)
+    {
+        workers[i].join();
+    }
+}
+
+void MachingCube::countTriangleMesh(std::vector<std::vector<size_t> > &_slabCounts, std::vector<size_t> &_totals)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    runSlabs(&MachingCube::countSlab, _slabCounts);
+    m_phaseTimes.classify += millisecondsSince(start);
+    _totals.assign(m_sweepLevels.size(), 0);
+    for(size_t s=0;s<_slabCounts.size();s++)
+    {
+        for(size_t l=0;l<_totals.size();l++)
+        {
+            _totals[l] += _slabCounts[s][l];
+        }
+    }
+}
+
+template <typename V>
+void MachingCube::fillTriangleMesh(const std::vector<std::vector<size_t> > &_slabCounts, const std::vector<V *> &_outs)
+{
+    // the slabs come out the same as for the counting pass so each one knows where its vertices start
+    std::vector<std::vector<V *> > slabOut(_slabCounts.size());
+    std::vector<V *> out(_outs);
+    for(size_t s=0;s<_slabCounts.size();s++)
+    {
+        slabOut[s] = out;
+        for(size_t l=0;l<out.size();l++)
+        {
+            out[l] += _slabCounts[s][l]*3;
+        }
+    }
+    void (MachingCube::*extract)(unsigned int, unsigned int, std::vector<V *> &) = &MachingCube::extractSlab;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    runSlabs(extract, slabOut);
+    m_phaseTimes.interpolate += millisecondsSince(start);
+}
+
+void MachingCube::packTriangleMesh(std::vector<VertData> &_vboMesh)
+{
+    m_sweepLevels.assign(1, nativeIsolevel(isolevel));
+    m_cellsVisited = 0;
+    clearExtractionTimes(m_phaseTimes);
+    std::vector<std::vector<size_t> > slabCounts;
+    std::vector<size_t> totals;
+    countTriangleMesh(slabCounts, totals);
+    _vboMesh.resize(totals[0]*3);
+    if(totals[0] > 0)
+        fillTriangleMesh(slabCounts, std::vector<VertData *>(1, &_vboMesh[0]));
+    m_nVerts = _vboMesh.size();
+}
+
+template <typename V>
+void MachingCube::packIndexedMesh(std::vector<IndexedMesh> &io_slabs, V *_verts, GLuint *_indices)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t nVerts=0;
+    for(size_t s=0;s<io_slabs.size();s++)
+    {
+        nVerts += io_slabs[s].verts.size();
+    }
+
+    // the vertices are shared so unless we have the gradient normals each one gets the
+    // area weighted sum of the normals of the triangles using it, vertices on the slab
+    // boundaries are duplicated as each slab has its own edge cache. The output may be
+    // mapped GPU memory so it is only ever written, front to back
+    std::vector<ngl::Vec3> normals(m_smoothNormals ? 0 : nVerts, ngl::Vec3(0.0, 0.0, 0.0));
+    GLuint base=0;
+    for(size_t s=0;s<io_slabs.size();s++)
+    {
+        const IndexedMesh &mesh = io_slabs[s];
+        for(size_t i=0;i<mesh.indices.size();i+=3)
+        {
+            ngl::Vec3 faceNormal;
+            if(!m_smoothNormals)
+                faceNormal.cross(mesh.verts[mesh.indices[i+1]]-mesh.verts[mesh.indices[i]],
+                                 mesh.verts[mesh.indices[i+2]]-mesh.verts[mesh.indices[i]]);
+            for(int v=0;v<3;v++)
+            {
+                if(!m_smoothNormals)
+                    normals[base+mesh.indices[i+v]] += faceNormal;
+                *_indices++ = base+mesh.indices[i+v];
+            }
+        }
+        base += mesh.verts.size();
+    }
+    base=0;
+    for(size_t s=0;s<io_slabs.size();s++)
+    {
+        const IndexedMesh &mesh = io_slabs[s];
+        for(size_t i=0;i<mesh.verts.size();i++)
+        {
+            ngl::Vec3 normal = m_smoothNormals ? mesh.normals[i] : normals[base+i];
+            if(normal.length()>0.0)
+                normal.normalize();
+            storeVertex(_verts[base+i], unitCoordinate(mesh.verts[i].m_x, 0), unitCoordinate(mesh.verts[i].m_y, 1),
+                        unitCoordinate(mesh.verts[i].m_z, 2), normal);
+        }
+        base += mesh.verts.size();
+        io_slabs[s] = IndexedMesh();
+    }
+    m_nVerts = nVerts;
+    m_phaseTimes.pack += millisecondsSince(start);
+}
+
+void MachingCube::packIndexedMesh(std::vector<VertData> &_vboMesh, std::vector<GLuint> &_indices)
+{
+    m_sweepLevels.assign(1, nativeIsolevel(isolevel));
+    m_cellsVisited = 0;
+    clearExtractionTimes(m_phaseTimes);
+    std::vector<std::vector<IndexedMesh> > levelMeshes;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if(adaptiveOutput())
+    {
+        buildOctree();
+        extractAdaptive(levelMeshes);
+    }
+    else
+    {
+        runSlabs(&MachingCube::extractSlabIndexed, levelMeshes);
+    }
+    m_phaseTimes.interpolate = millisecondsSince(start);
+    std::vector<IndexedMesh> slabMeshes(levelMeshes.size());
+    for(size_t s=0;s<levelMeshes.size();s++)
+    {
+        std::swap(slabMeshes[s], levelMeshes[s][0]);
+    }
+    postProcess(slabMeshes);
+
+    size_t nVerts=0, nIndices=0;
+    for(size_t s=0;s<slabMeshes.size();s++)
+    {
+        nVerts += slabMeshes[s].verts.size();
+        nIndices += slabMeshes[s].indices.size();
+    }
+    _vboMesh.resize(nVerts);
+    _indices.resize(nIndices);
+    packIndexedMesh(slabMeshes, _vboMesh.empty() ? 0 : &_vboMesh[0], _indices.empty() ? 0 : &_indices[0]);
+}
+
+void MachingCube::extractMesh(std::vector<VertData> &_verts, std::vector<GLuint> &_indices)
+{
+    if(indexedOutput())
+    {
+        packIndexedMesh(_verts, _indices);
+    }
+    else
+    {
+        _indices.clear();
+        packTriangleMesh(_verts);
+    }
+}
+
+void MachingCube::createVAO()
+{
+    // if we have already created a VBO just return.
+    if(m_vao == true)
+    {
+        std::cout<<"VAO exist so returning\n";
+        return;
+    }
+    // indicate we have a vao now, the VAO of each isolevel is made the first time it is extracted
+    m_vao=true;
+    refreshMesh();
+}
+
+void MachingCube::createGpuMesh(GpuMesh &_mesh)
+{
+    // first we grab an instance of our VOA, we keep hold of the vertex and element buffers
+    // ourselves so a new isolevel can be uploaded into the same buffers
+    _mesh.vao= ngl::VertexArrayObject::createVOA(GL_TRIANGLES);
+    // next we bind it so it's active for setting data
+    _mesh.vao->bind();
+    glGenBuffers(1, &_mesh.vbo);
+    glGenBuffers(1, &_mesh.ibo);
+    glBindBuffer(GL_ARRAY_BUFFER, _mesh.vbo);
+    // the element buffer binding is part of the VAO state
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _mesh.ibo);
+    setVertexLayout(_mesh);
+    // finally we have finished for now so time to unbind the VAO
+    _mesh.vao->unbind();
+    _mesh.vboCapacity = 0;
+    _mesh.iboCapacity = 0;
+    _mesh.numIndices = 0;
+    _mesh.numVerts = 0;
+    _mesh.isolevel = NAN;
+    _mesh.chunkEnd = 0;
+    _mesh.indirect = 0;
+    _mesh.drawIndirect = false;
+    _mesh.fence = 0;
+}
+
+void MachingCube::setVertexLayout(GpuMesh &_mesh)
+{
+    _mesh.vao->bind();
+    glBindBuffer(GL_ARRAY_BUFFER, _mesh.vbo);
+    if(m_vertexFormat == VertexFormat::PACKED)
+    {
+        // nu,nv,x,y,z as normalised shorts, the position is attribute 0 one float (nu,nv) in and comes out
+        // of the normalisation already in [-1,1], the two octahedral components of the normal are attribute 1
+        _mesh.vao->setVertexAttributePointer(0,3,GL_SHORT,sizeof(PackedVertData),1,true);
+        _mesh.vao->setVertexAttributePointer(1,2,GL_SHORT,sizeof(PackedVertData),0,true);
+    }
+    else
+    {
+        // in this case we have packed our data in interleaved format as follows
+        // nx,ny,nz,x,y,z
+        // If you look at the shader we have the following attributes being used
+        // attribute vec3 inVert; attribute 0
+        // attribute vec3 inNormal; attribure 1
+        // so we need to set the vertexAttributePointer so the correct size and type as follows
+        // vertex is attribute 0 with x,y,z(3) parts of type GL_FLOAT, our complete packed data is
+        // sizeof(vertData) and the offset into the data structure for the first x component is 3 (nx,ny,nz)..x
+        _mesh.vao->setVertexAttributePointer(0,3,GL_FLOAT,sizeof(VertData),3);
+        // normal same as vertex only starts at position 2 (u,v)-> nx
+        _mesh.vao->setVertexAttributePointer(1,3,GL_FLOAT,sizeof(VertData),0);
+    }
+}
+
+size_t MachingCube::vertexSize() const
+{
+    return m_vertexFormat == VertexFormat::PACKED ? sizeof(PackedVertData) : sizeof(VertData);
+}
+
+void MachingCube::deleteGpuMesh(GpuMesh &_mesh)
+{
+    glDeleteBuffers(1,&_mesh.vbo);
+    glDeleteBuffers(1,&_mesh.ibo);
+    glDeleteBuffers(1,&_mesh.indirect);
+    glDeleteSync(_mesh.fence);
+    delete _mesh.vao;
+    _mesh.vao = 0;
+}
+
+void MachingCube::setIsolevel(float _iso)
+{
+    if(_iso == isolevel)
+        return;
+    isolevel = _iso;
+    if(m_vao == true)
+        refreshMesh();
+}
+
+void MachingCube::setIsolevels(const std::vector<float> &_levels)
+{
+    if(_levels.empty())
+        return;
+    isolevel = _levels[0];
+    m_extraIsolevels.assign(_levels.begin()+1, _levels.end());
+    if(m_vao == true)
+        refreshMesh();
+}
+
+void MachingCube::setIndexed(bool _indexed)
+{
+    if(_indexed == m_indexed)
+        return;
+    m_indexed = _indexed;
+    invalidateMeshes();
+    if(m_vao == true)
+        refreshMesh();
+}
+
+void MachingCube::setSmoothNormals(bool _smooth)
+{
+    if(_smooth == m_smoothNormals)
+        return;
+    m_smoothNormals = _smooth;
+    invalidateMeshes();
+    if(m_vao == true)
+        refreshMesh();
+}
+
+void MachingCube::setMesher(Mesher _mesher)
+{
+    if(_mesher == m_mesher)
+        return;
+    m_mesher = _mesher;
+    invalidateMeshes();
+    if(m_vao == true)
+        refreshMesh();
+}
+
+void MachingCube::setVertexFormat(VertexFormat _format)
+{
+    if(_format == m_vertexFormat)
+        return;
+    m_vertexFormat = _format;
+    // the buffers are refilled in the new layout by the re-extraction
+    for(size_t m=0;m<m_meshes.size();m++)
+    {
+        setVertexLayout(m_meshes[m]);
+        m_meshes[m].vao->unbind();
+    }
+    invalidateMeshes();
+    if(m_vao == true)
+        refreshMesh();
+}
+
+void MachingCube::setWeldVertices(bool _weld)
+{
+    if(_weld == m_weld)
+        return;
+    m_weld = _weld;
+    invalidateMeshes();
+    if(m_vao == true)
+        refreshMesh();
+}
+
+void MachingCube::setDecimationTarget(size_t _triangles)
+{
+    if(_triangles == m_decimationTarget)
+        return;
+    m_decimationTarget = _triangles;
+    invalidateMeshes();
+    if(m_vao == true)
+        refreshMesh();
+}
+
+void MachingCube::setGpuExtraction(bool _gpu)
+{
+    if(_gpu == m_gpuExtraction)
+        return;
+    m_gpuExtraction = _gpu;
+    invalidateMeshes();
+    if(m_vao == true)
+        refreshMesh();
+}
+
+void MachingCube::setLod(unsigned int _lod)
+{
+    _lod = std::min(_lod, NumLods-1);
+    if(_lod == m_lod)
+        return;
+    m_lod = _lod;
+    if(m_vao == true)
+        refreshMesh();
+}
+
+void MachingCube::setAdaptive(bool _adaptive)
+{
+    if(_adaptive == m_adaptive)
+        return;
+    m_adaptive = _adaptive;
+    invalidateMeshes();
+    if(m_vao == true)
+        refreshMesh();
+}
+
+void MachingCube::setAdaptiveError(float _error)
+{
+    _error = std::max(_error, 0.0f);
+    if(_error == m_adaptiveError)
+        return;
+    m_adaptiveError = _error;
+    // updateMesh only extracts the surfaces again if the leaves come out different
+    if(m_vao == true && adaptiveOutput())
+        refreshMesh();
+}
+
+void MachingCube::refreshMesh()
+{
+    if(currentLod() > 0)
+    {
+        // the coarse levels are volumes of their own holding the raw voxel values so they get the
+        // isolevels in the value range of the voxels
+        MachingCube *lod = lodLevel(m_lod);
+        lod->isolevel = nativeIsolevel(isolevel);
+        lod->m_extraIsolevels.resize(m_extraIsolevels.size());
+        for(size_t l=0;l<m_extraIsolevels.size();l++)
+        {
+            lod->m_extraIsolevels[l] = nativeIsolevel(m_extraIsolevels[l]);
+        }
+        if(lod->m_vao == true)
+            lod->refreshMesh();
+        else
+            lod->createVAO();
+        return;
+    }
+    // a function has no pyramid so there are no blocks to count
+    if(m_verbose && !m_pyramid.isEmpty() && !m_meshes.empty() && !std::isnan(m_meshes[0].isolevel) &&
+       m_meshes[0].isolevel != isolevel)
+    {
+        // a block whose range straddles neither level had no surface before and still has none, so only the
+        // blocks active at either level change. The ones active at the old level hold everything we drew before
+        // and are replaced as a whole, the sweep then only walks the blocks active at the new level
+        std::cout<<"isolevel "<<isolevel<<" re-extracting "
+                 <<m_pyramid.countActive(nativeIsolevel(m_meshes[0].isolevel), nativeIsolevel(isolevel))<<" of "
+                 <<(size_t)m_pyramid.getBlocksDepth()*m_pyramid.getBlocksHeight()*m_pyramid.getBlocksWidth()<<" blocks\n";
+    }
+    updateMesh();
+}
+
+MachingCube *MachingCube::lodLevel(unsigned int _lod)
+{
+    if(_lod == 0)
+        return this;
+    if(!m_lods[_lod])
+    {
+        std::unique_ptr<MachingCube> lod(new MachingCube());
+        lod->m_stride = 1u<<_lod;
+        lod->m_fineSize[0] = volume_depth;
+        lod->m_fineSize[1] = volume_height;
+        lod->m_fineSize[2] = volume_width;
+        // enough samples to reach the last one of each axis, so the last cell may be shorter than the rest
+        lod->volume_depth = (volume_depth+lod->m_stride-2)/lod->m_stride+1;
+        lod->volume_height = (volume_height+lod->m_stride-2)/lod->m_stride+1;
+        lod->volume_width = (volume_width+lod->m_stride-2)/lod->m_stride+1;
+        if(m_function)
+        {
+            // a coarse level of a function is the same function sampled more sparsely
+            lod->m_function = m_function;
+            lod->m_functionMin = m_functionMin;
+            lod->m_functionMax = m_functionMax;
+        }
+        else if(volumeData != 0)
+        {
+            lod->volumeData = new float[(size_t)lod->volume_depth*lod->volume_height*lod->volume_width];
+            sampleLod<float>(*lod, lod->volumeData);
+            lod->buildPyramid();
+        }
+        else
+        {
+            // a coarse level of a file keeps the voxel type of the file, which is all the sweep and the GPU
+            // have to read and a half or a quarter of the memory of floats
+            lod->m_volume.create(lod->volume_width, lod->volume_height, lod->volume_depth, voxelType());
+            switch(voxelType())
+            {
+                case VoxelType::UINT8 : sampleLod(*lod, lod->m_volume.editSlice(0)); break;
+                case VoxelType::UINT16 : sampleLod(*lod, reinterpret_cast<unsigned short *>(lod->m_volume.editSlice(0))); break;
+                case VoxelType::FLOAT : sampleLod(*lod, reinterpret_cast<float *>(lod->m_volume.editSlice(0))); break;
+            }
+            lod->buildPyramid();
+        }
+        if(m_verbose)
+            std::cout<<"level of detail "<<_lod<<" is "<<lod->volume_width<<" x "<<lod->volume_height<<" x "
+                     <<lod->volume_depth<<"\n";
+        m_lods[_lod] = std::move(lod);
+    }
+    // the settings can change between uses of the level
+    MachingCube *lod = m_lods[_lod].get();
+    if(lod->m_indexed != m_indexed || lod->m_smoothNormals != m_smoothNormals)
+    {
+        lod->m_indexed = m_indexed;
+        lod->m_smoothNormals = m_smoothNormals;
+        lod->invalidateMeshes();
+    }
+    if(lod->m_mesher != m_mesher)
+    {
+        lod->m_mesher = m_mesher;
+        lod->invalidateMeshes();
+    }
+    if(lod->m_vertexFormat != m_vertexFormat)
+    {
+        lod->m_vertexFormat = m_vertexFormat;
+        for(size_t m=0;m<lod->m_meshes.size();m++)
+        {
+            lod->setVertexLayout(lod->m_meshes[m]);
+            lod->m_meshes[m].vao->unbind();
+        }
+        lod->invalidateMeshes();
+    }
+    if(lod->m_weld != m_weld || lod->m_decimationTarget != m_decimationTarget)
+    {
+        lod->m_weld = m_weld;
+        lod->m_decimationTarget = m_decimationTarget;
+        lod->invalidateMeshes();
+    }
+    if(lod->m_gpuExtraction != m_gpuExtraction)
+    {
+        lod->m_gpuExtraction = m_gpuExtraction;
+        lod->invalidateMeshes();
+    }
+    lod->m_skipEmpty = m_skipEmpty;
+    lod->m_verbose = m_verbose;
+    lod->m_numThreads = m_numThreads;
+    return lod;
+}
+
+template <typename T>
+void MachingCube::sampleLod(const MachingCube &_lod, T *_out) const
+{
+    const VolumeView<T> volume = volumeView<T>();
+    T *out = _out;
+    for(unsigned int i=0;i<_lod.volume_depth;i++)
+    {
+        unsigned int fi = std::min(i*_lod.m_stride, volume_depth-1);
+        for(unsigned int j=0;j<_lod.volume_height;j++)
+        {
+            unsigned int fj = std::min(j*_lod.m_stride, volume_height-1);
+            for(unsigned int k=0;k<_lod.volume_width;k++)
+            {
+                *out++ = volume(fi, fj, std::min(k*_lod.m_stride, volume_width-1));
+            }
+        }
+        if(volumeData == 0)
+            m_volume.releaseSlices(fi, fi+1);
+    }
+}
+
+void MachingCube::clearLods()
+{
+    for(unsigned int l=0;l<NumLods;l++)
+    {
+        m_lods[l].reset();
+    }
+    m_octree.clear();
+    invalidateMeshes();
+}
+
+bool MachingCube::buildOctree()
+{
+    if(m_pyramid.isEmpty())
+        return false;
+    std::vector<float> isos(getNumIsolevels());
+    for(unsigned int l=0;l<isos.size();l++)
+    {
+        isos[l] = nativeIsolevel(getIsolevel(l));
+    }
+    bool changed = false;
+    switch(voxelType())
+    {
+        case VoxelType::UINT8 : changed = m_octree.build(volumeView<unsigned char>(), m_pyramid, NumLods, isos, m_adaptiveError); break;
+        case VoxelType::UINT16 : changed = m_octree.build(volumeView<unsigned short>(), m_pyramid, NumLods, isos, m_adaptiveError); break;
+        case VoxelType::FLOAT : changed = m_octree.build(volumeView<float>(), m_pyramid, NumLods, isos, m_adaptiveError); break;
+    }
+    if(changed && m_verbose)
+    {
+        std::cout<<"adaptive octree "<<m_octree.getLeaves().size()<<" leaves (";
+        for(unsigned int l=0;l<NumLods;l++)
+        {
+            std::cout<<(l > 0 ? ", " : "")<<m_octree.countLeaves(l)<<" at stride "<<(1u<<l);
+        }
+        std::cout<<")\n";
+    }
+    return changed;
+}
+
+void MachingCube::invalidateMeshes()
+{
+    for(size_t l=0;l<m_meshes.size();l++)
+    {
+        m_meshes[l].isolevel = NAN;
+    }
+}
+
+float MachingCube::unitCoordinate(float _p, unsigned int _axis) const
+{
+    const unsigned int size[3] = {volume_depth, volume_height, volume_width};
+    if(m_stride == 1)
+        return _p/size[_axis]*2.0-1.0;
+    // coarse sample c sits on full volume sample min(c*stride, last) so the last cell can be shorter
+    unsigned int c = std::min((unsigned int)_p, size[_axis]-2);
+    float lo = c*m_stride;
+    float hi = std::min((c+1)*m_stride, m_fineSize[_axis]-1);
+    return (lo+(_p-c)*(hi-lo))/m_fineSize[_axis]*2.0-1.0;
+}
+
+void MachingCube::updateMesh()
+{
+    // one VAO per isolevel, made or dropped as the list of levels changes
+    const unsigned int nLevels = getNumIsolevels();
+    while(m_meshes.size() > nLevels)
+    {
+        deleteGpuMesh(m_meshes.back());
+        m_meshes.pop_back();
+    }
+    while(m_meshes.size() < nLevels)
+    {
+        m_meshes.push_back(GpuMesh());
+        createGpuMesh(m_meshes.back());
+    }
+    // the leaves of the adaptive octree follow the isolevels and the error allowed, when they change every
+    // surface is extracted again
+    if(adaptiveOutput() && buildOctree())
+        invalidateMeshes();
+    // the levels that are out of date all come out of the same sweep
+    clearExtractionTimes(m_phaseTimes);
+    std::vector<unsigned int> stale;
+    m_sweepLevels.clear();
+    for(unsigned int l=0;l<nLevels;l++)
+    {
+        if(m_meshes[l].isolevel != getIsolevel(l))
+        {
+            stale.push_back(l);
+            m_sweepLevels.push_back(nativeIsolevel(getIsolevel(l)));
+        }
+    }
+    // a volume file may have these meshes in its cache already, the ones that aren't are cached once
+    // they are extracted if this is the first time (not every stop while scrubbing the isolevel)
+    std::vector<unsigned int> save;
+    if(canCache())
+    {
+        std::vector<unsigned int> missing;
+        m_sweepLevels.clear();
+        for(size_t x=0;x<stale.size();x++)
+        {
+            if(loadCachedMesh(stale[x]))
+                continue;
+            if(std::isnan(m_meshes[stale[x]].isolevel))
+                save.push_back(stale[x]);
+            missing.push_back(stale[x]);
+            m_sweepLevels.push_back(nativeIsolevel(getIsolevel(stale[x])));
+        }
+        stale.swap(missing);
+    }
+    // once the volume is sculpted the unindexed output is kept in chunks, the stale levels are laid out again
+    // and the rest only get the chunks the brush has touched since the last update
+    if(m_sculpted && !indexedOutput())
+    {
+        updateChunks(stale);
+        return;
+    }
+    if(stale.empty())
+        return;
+
+    // count first then write the meshes straight into the GPU buffers, so the only copy of them
+    // in memory is the one the GL gives us (plus the slab meshes for the indexed output)
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    m_cellsVisited = 0;
+    const bool gpu = gpuExtract(stale);
+    if(gpu)
+    {
+        m_cellsVisited = (unsigned long long)(volume_depth-1)*(volume_height-1)*(volume_width-1);
+    }
+    else if(indexedOutput())
+    {
+        std::vector<std::vector<IndexedMesh> > levelMeshes;
+        std::chrono::steady_clock::time_point sweep = std::chrono::steady_clock::now();
+        if(adaptiveOutput())
+            extractAdaptive(levelMeshes);
+        else
+            runSlabs(&MachingCube::extractSlabIndexed, levelMeshes);
+        m_phaseTimes.interpolate = millisecondsSince(sweep);
+        std::vector<IndexedMesh> slabMeshes(levelMeshes.size());
+        for(size_t x=0;x<stale.size();x++)
+        {
+            for(size_t s=0;s<levelMeshes.size();s++)
+            {
+                std::swap(slabMeshes[s], levelMeshes[s][x]);
+            }
+            postProcess(slabMeshes);
+            uploadIndexedMesh(stale[x], slabMeshes);
+        }
+    }
+    else
+    {
+        std::vector<std::vector<size_t> > slabCounts;
+        std::vector<size_t> totals;
+        countTriangleMesh(slabCounts, totals);
+        std::vector<void *> verts(stale.size());
+        bool mapped = true;
+        for(size_t x=0;x<stale.size();x++)
+        {
+            GpuMesh &mesh = m_meshes[stale[x]];
+            verts[x] = mapBuffer(GL_ARRAY_BUFFER, mesh.vbo, mesh.vboCapacity, totals[x]*3*vertexSize());
+            mapped = (totals[x] == 0 || verts[x] != 0) && mapped;
+        }
+        if(mapped && m_vertexFormat == VertexFormat::PACKED)
+        {
+            std::vector<PackedVertData *> out(stale.size());
+            for(size_t x=0;x<stale.size();x++)
+                out[x] = static_cast<PackedVertData *>(verts[x]);
+            fillTriangleMesh(slabCounts, out);
+        }
+        else if(mapped)
+        {
+            std::vector<VertData *> out(stale.size());
+            for(size_t x=0;x<stale.size();x++)
+                out[x] = static_cast<VertData *>(verts[x]);
+            fillTriangleMesh(slabCounts, out);
+        }
+        for(size_t x=0;x<stale.size();x++)
+        {
+            GpuMesh &mesh = m_meshes[stale[x]];
+            clearChunks(mesh);
+            mesh.drawIndirect = false;
+            bool written = mapped;
+            // unmapping can fail if the buffer got trashed (mode switch etc.) and then there is nothing to draw
+            if(verts[x] != 0)
+            {
+                glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+                written = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE && written;
+            }
+            if(!written)
+                std::cout<<"failed to write the mesh into the vertex buffers\n";
+            else if(m_verbose)
+                std::cout<<"isolevel "<<getIsolevel(stale[x])<<" : "<<totals[x]*3<<" vertices, "<<totals[x]<<" triangles\n";
+            mesh.numIndices = written ? totals[x]*3 : 0;
+            mesh.numVerts = mesh.numIndices;
+            mesh.isolevel = getIsolevel(stale[x]);
+            mesh.vao->bind();
+            mesh.vao->setNumIndices(mesh.numIndices);
+            mesh.vao->unbind();
+        }
+        m_nVerts = totals[0]*3;
+    }
+    if(m_verbose)
+    {
+        unsigned long long nCells = (unsigned long long)(volume_depth-1)*(volume_height-1)*(volume_width-1);
+        std::cout<<"visited "<<m_cellsVisited<<" of "<<nCells<<" cells for "<<stale.size()<<" isolevels in "
+                 <<millisecondsSince(start)<<" ms ("
+                 <<(m_mesher == Mesher::SURFACE_NETS ? "surface nets" : adaptiveOutput() ? "adaptive marching cubes" : "marching cubes")
+                 <<(gpu ? " on the GPU" : "")<<")\n";
+    }
+    for(size_t x=0;x<save.size();x++)
+    {
+        saveCachedMesh(save[x]);
+    }
+}
+
+bool MachingCube::gpuExtract(const std::vector<unsigned int> &_stale)
+{
+    if(!m_gpuExtraction || indexedOutput() || m_vertexFormat != VertexFormat::FLOAT || m_function || m_sculpted)
+        return false;
+    if(!canExtractOnGpu())
+        return false;
+    if(m_gpuVolumeStale)
+    {
+        // a slice at a time straight from the mapped file (which drops it again) or our own copy
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        m_gpuVolumeStale = false;
+        if(m_gpu->setVolume(voxelType(), volume_width, volume_height, volume_depth))
+        {
+            const size_t sliceVoxels = (size_t)volume_width*volume_height;
+            for(unsigned int s=0;s<volume_depth;s++)
+            {
+                if(volumeData != 0)
+                {
+                    m_gpu->uploadSlice(s, volumeData+s*sliceVoxels);
+                }
+                else
+                {
+                    m_gpu->uploadSlice(s, m_volume.getSlice(s));
+                    m_volume.releaseSlices(s, s+1);
+                }
+            }
+            if(m_verbose)
+                std::cout<<"uploaded the volume to the GPU in "<<millisecondsSince(start)<<" ms\n";
+        }
+        m_gpu->setStride(m_stride, m_fineSize);
+    }
+    if(!m_gpu->hasVolume())
+        return false;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(size_t x=0;x<_stale.size();x++)
+    {
+        GpuMesh &mesh = m_meshes[_stale[x]];
+        clearChunks(mesh);
+        if(mesh.indirect == 0)
+            glGenBuffers(1, &mesh.indirect);
+        glDeleteSync(mesh.fence);
+        // nothing comes back before the mesh is drawn so the buffer is sized from the pyramid, the surface crosses
+        // about BlockSize^2 cells of each block it passes through with two triangles in each. A mesh that turns
+        // out bigger is extracted again by pollGpuExtraction
+        const size_t blockVerts = MinMaxPyramid::BlockSize*MinMaxPyramid::BlockSize*6;
+        const size_t estimate = (m_pyramid.countActive(m_sweepLevels[x], m_sweepLevels[x])*blockVerts+3)*vertexSize();
+        if(estimate > mesh.vboCapacity)
+        {
+            mesh.vboCapacity = estimate + estimate/4;
+            glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+            glBufferData(GL_ARRAY_BUFFER, mesh.vboCapacity, 0, GL_DYNAMIC_DRAW);
+        }
+        m_gpu->extract(m_sweepLevels[x], m_smoothNormals, mesh.vbo, mesh.vboCapacity, mesh.indirect);
+        mesh.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        mesh.drawIndirect = true;
+        mesh.isolevel = getIsolevel(_stale[x]);
+    }
+    // the time to issue the passes, the GPU carries on with them after we return
+    m_phaseTimes.interpolate = millisecondsSince(start);
+    return true;
+}
+
+bool MachingCube::finishGpuMesh(GpuMesh &_mesh, bool _wait)
+{
+    if(_mesh.fence == 0)
+        return false;
+    // the fence of a GPU extraction the CPU has replaced since is just dropped
+    if(_mesh.drawIndirect && !_wait && glClientWaitSync(_mesh.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED)
+        return false;
+    glDeleteSync(_mesh.fence);
+    _mesh.fence = 0;
+    if(!_mesh.drawIndirect)
+        return false;
+    const size_t nVerts = GpuMarchingCubes::vertexCount(_mesh.indirect);
+    const size_t bytes = nVerts*vertexSize();
+    if(bytes > _mesh.vboCapacity)
+    {
+        _mesh.vboCapacity = bytes + bytes/4;
+        glBindBuffer(GL_ARRAY_BUFFER, _mesh.vbo);
+        glBufferData(GL_ARRAY_BUFFER, _mesh.vboCapacity, 0, GL_DYNAMIC_DRAW);
+        _mesh.isolevel = NAN;
+        return true;
+    }
+    _mesh.numVerts = nVerts;
+    _mesh.numIndices = nVerts;
+    _mesh.vao->bind();
+    _mesh.vao->setNumIndices(_mesh.numIndices);
+    _mesh.vao->unbind();
+    if(m_verbose)
+        std::cout<<"isolevel "<<_mesh.isolevel<<" : "<<_mesh.numVerts<<" vertices, "<<_mesh.numVerts/3<<" triangles\n";
+    return false;
+}
+
+bool MachingCube::canExtractOnGpu()
+{
+    if(!m_gpu)
+    {
+        m_gpu.reset(new GpuMarchingCubes());
+        m_gpu->init(edgeTable, triTable);
+    }
+    return m_gpu->isReady() && m_gpu->canHold(volume_width, volume_height, volume_depth);
+}
+
+void MachingCube::pollGpuExtraction()
+{
+    if(currentLod() > 0 && m_lods[m_lod])
+    {
+        m_lods[m_lod]->pollGpuExtraction();
+        return;
+    }
+    bool again = false;
+    for(size_t l=0;l<m_meshes.size();l++)
+    {
+        again = finishGpuMesh(m_meshes[l], false) || again;
+    }
+    m_nVerts = m_meshes.empty() ? 0 : m_meshes[0].numVerts;
+    if(again && m_vao == true)
+        updateMesh();
+}
+
+void MachingCube::uploadIndexedMesh(unsigned int _level, std::vector<IndexedMesh> &io_slabs)
+{
+    GpuMesh &mesh = m_meshes[_level];
+    clearChunks(mesh);
+    mesh.drawIndirect = false;
+    // the element buffer binding belongs to the VAO so it has to be bound before the IBO is mapped
+    mesh.vao->bind();
+    size_t nVerts=0, nIndices=0;
+    for(size_t s=0;s<io_slabs.size();s++)
+    {
+        nVerts += io_slabs[s].verts.size();
+        nIndices += io_slabs[s].indices.size();
+    }
+    void *verts = mapBuffer(GL_ARRAY_BUFFER, mesh.vbo, mesh.vboCapacity, nVerts*vertexSize());
+    GLuint *indices = static_cast<GLuint *>(mapBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ibo, mesh.iboCapacity, nIndices*sizeof(GLuint)));
+    bool mapped = nIndices == 0 || (verts != 0 && indices != 0);
+    if(mapped && nIndices > 0 && m_vertexFormat == VertexFormat::PACKED)
+        packIndexedMesh(io_slabs, static_cast<PackedVertData *>(verts), indices);
+    else if(mapped && nIndices > 0)
+        packIndexedMesh(io_slabs, static_cast<VertData *>(verts), indices);
+    // unmapping can fail if the buffer got trashed (mode switch etc.) and then there is nothing to draw
+    if(verts != 0)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+        mapped = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE && mapped;
+    }
+    if(indices != 0)
+        mapped = glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER) == GL_TRUE && mapped;
+    if(!mapped)
+        std::cout<<"failed to write the mesh into the vertex buffers\n";
+    else if(m_verbose)
+        std::cout<<"isolevel "<<getIsolevel(_level)<<" : "<<nVerts<<" vertices, "<<nIndices/3<<" triangles\n";
+    // in indexed mode the triangles come from the element buffer so the shared vertices are only stored once
+    // now we tell the VAO how many indices to draw
+    mesh.numIndices = mapped ? nIndices : 0;
+    mesh.numVerts = mapped ? nVerts : 0;
+    mesh.isolevel = getIsolevel(_level);
+    mesh.vao->setNumIndices(mesh.numIndices);
+    mesh.vao->unbind();
+}
+
+void MachingCube::postProcess(std::vector<IndexedMesh> &io_slabs)
+{
+    if(!m_weld && m_decimationTarget == 0)
+        return;
+    MeshDecimator decimator;
+    decimator.setNumThreads(m_numThreads);
+    std::vector<IndexedMesh> mesh(1);
+    const MeshDecimator::Stats stats = decimator.process(io_slabs, mesh[0], m_decimationTarget);
+    io_slabs.swap(mesh);
+    m_phaseTimes.post += stats.weldTime+stats.decimateTime;
+    if(!m_verbose)
+        return;
+    std::cout<<"welded "<<stats.vertsIn<<" to "<<stats.vertsWelded<<" vertices in "<<stats.weldTime<<" ms";
+    if(m_decimationTarget > 0)
+        std::cout<<", decimated "<<stats.trisIn<<" to "<<stats.trisOut<<" triangles ("<<stats.vertsOut
+                 <<" vertices) in "<<stats.decimateTime<<" ms, max error "<<stats.maxError<<" voxels";
+    std::cout<<"\n";
+}
+
+void MachingCube::sculpt(const ngl::Vec3 &_centre, float _radius, float _strength)
+{
+    if(_radius <= 0.0f)
+        return;
+    makeEditable();
+    // from the space of the mesh to voxels is the inverse of unitCoordinate, the brush is a sphere in the
+    // space of the mesh so it is stretched along the longer sides of the volume
+    const unsigned int size[3] = {volume_depth, volume_height, volume_width};
+    const float centre[3] = {_centre.m_x, _centre.m_y, _centre.m_z};
+    float c[3], scale[3];
+    unsigned int lo[3], hi[3];
+    for(int a=0;a<3;a++)
+    {
+        c[a] = (centre[a]+1.0f)*0.5f*size[a];
+        const float r = _radius*0.5f*size[a];
+        lo[a] = (unsigned int)std::min(std::max(std::floor(c[a]-r), 0.0f), (float)size[a]);
+        hi[a] = (unsigned int)std::min(std::max(std::ceil(c[a]+r)+1.0f, 0.0f), (float)size[a]);
+        scale[a] = 1.0f/r;
+        if(lo[a] >= hi[a])
+            return;
+    }
+    for(unsigned int i=lo[0];i<hi[0];i++)
+    {
+        const float di = (i-c[0])*scale[0];
+        for(unsigned int j=lo[1];j<hi[1];j++)
+        {
+            const float dj = (j-c[1])*scale[1];
+            float *row = volumeData + ((size_t)i*volume_height + j)*volume_width;
+            for(unsigned int k=lo[2];k<hi[2];k++)
+            {
+                const float dk = (k-c[2])*scale[2];
+                const float d2 = di*di+dj*dj+dk*dk;
+                if(d2 < 1.0f)
+                    row[k] += _strength*(1.0f-d2)*(1.0f-d2);
+            }
+        }
+    }
+    m_pyramid.update(volumeView<float>(), lo, hi);
+
+    // a cell has the samples c and c+1 as corners and its gradient normals reach one sample further out
+    // either way, so the cells from lo-2 to hi are the ones that can change
+    unsigned int first[3], last[3];
+    for(int a=0;a<3;a++)
+    {
+        first[a] = (lo[a] > 2 ? lo[a]-2 : 0)/ChunkCells;
+        last[a] = std::min(std::min(hi[a], size[a]-2)/ChunkCells, m_chunks[a]-1);
+    }
+    for(unsigned int i=first[0];i<=last[0];i++)
+        for(unsigned int j=first[1];j<=last[1];j++)
+            for(unsigned int k=first[2];k<=last[2];k++)
+                m_dirtyChunks[(i*m_chunks[1]+j)*m_chunks[2]+k] = 1;
+    // the coarse levels are sampled again when they are next used, the indexed output has no chunks
+    for(unsigned int l=1;l<NumLods;l++)
+    {
+        m_lods[l].reset();
+    }
+    // and the errors of the octree worked out again
+    m_octree.clear();
+    if(indexedOutput())
+        invalidateMeshes();
+    if(m_vao == true)
+        refreshMesh();
+}
+
+void MachingCube::makeEditable()
+{
+    if(m_sculpted)
+        return;
+    if(volumeData == 0)
+    {
+        const size_t sliceSize = (size_t)volume_width*volume_height;
+        float *data = new float[sliceSize*volume_depth];
+        if(m_function)
+        {
+            for(unsigned int s=0;s<volume_depth;s++)
+            {
+                sampleFunction(s, data+s*sliceSize);
+            }
+            m_function = ImplicitFunction();
+        }
+        else
+        {
+            switch(voxelType())
+            {
+                case VoxelType::UINT8 : copyNormalised<unsigned char>(data); break;
+                case VoxelType::UINT16 : copyNormalised<unsigned short>(data); break;
+                case VoxelType::FLOAT : copyNormalised<float>(data); break;
+            }
+            m_volume.close();
+        }
+        volumeData = data;
+        buildPyramid();
+    }
+    const unsigned int cells[3] = {volume_depth-1, volume_height-1, volume_width-1};
+    for(int a=0;a<3;a++)
+    {
+        m_chunks[a] = std::max(1u, (cells[a]+ChunkCells-1)/ChunkCells);
+    }
+    m_dirtyChunks.assign((size_t)m_chunks[0]*m_chunks[1]*m_chunks[2], 0);
+    m_sculpted = true;
+    // the meshes are laid out in chunks from scratch
+    clearLods();
+}
+
+template <typename T>
+void MachingCube::copyNormalised(float *_out) const
+{
+    const VolumeView<T> volume = volumeView<T>();
+    const float lo = m_pyramid.getMinValue();
+    const float range = m_pyramid.getMaxValue()-lo;
+    const float scale = range > 0.0f ? 1.0f/range : 0.0f;
+    const size_t sliceSize = (size_t)volume_width*volume_height;
+    for(unsigned int s=0;s<volume_depth;s++)
+    {
+        const T *slice = volume.getSlice(s);
+        for(size_t v=0;v<sliceSize;v++)
+        {
+            *_out++ = (slice[v]-lo)*scale;
+        }
+        m_volume.releaseSlices(s, s+1);
+    }
+}
+
+void MachingCube::clearSculpting()
+{
+    m_sculpted = false;
+    m_dirtyChunks.clear();
+    for(size_t l=0;l<m_meshes.size();l++)
+    {
+        clearChunks(m_meshes[l]);
+    }
+}
+
+void MachingCube::clearChunks(GpuMesh &_mesh)
+{
+    _mesh.chunkFirst.clear();
+    _mesh.chunkCount.clear();
+    _mesh.chunkCapacity.clear();
+    _mesh.chunkEnd = 0;
+}
+
+void MachingCube::updateChunks(const std::vector<unsigned int> &_stale)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    m_cellsVisited = 0;
+    std::vector<unsigned int> all(m_dirtyChunks.size()), dirty;
+    for(unsigned int c=0;c<all.size();c++)
+    {
+        all[c] = c;
+        if(m_dirtyChunks[c])
+            dirty.push_back(c);
+    }
+    std::vector<unsigned int> layout, update;
+    for(unsigned int l=0;l<m_meshes.size();l++)
+    {
+        if(std::find(_stale.begin(), _stale.end(), l) != _stale.end() || m_meshes[l].chunkFirst.empty())
+            layout.push_back(l);
+        else if(!dirty.empty())
+            update.push_back(l);
+    }
+    const std::vector<unsigned int> *levels[2] = {&layout, &update};
+    const std::vector<unsigned int> *chunks[2] = {&all, &dirty};
+    for(int p=0;p<2;p++)
+    {
+        if(levels[p]->empty())
+            continue;
+        m_sweepLevels.clear();
+        for(size_t x=0;x<levels[p]->size();x++)
+        {
+            const unsigned int l = (*levels[p])[x];
+            m_sweepLevels.push_back(nativeIsolevel(getIsolevel(l)));
+            if(p == 0)
+                clearChunks(m_meshes[l]);
+        }
+        if(m_vertexFormat == VertexFormat::PACKED)
+            remeshChunks<PackedVertData>(*levels[p], *chunks[p]);
+        else
+            remeshChunks<VertData>(*levels[p], *chunks[p]);
+    }
+    std::fill(m_dirtyChunks.begin(), m_dirtyChunks.end(), 0);
+    m_phaseTimes.interpolate = millisecondsSince(start);
+    if(!m_verbose || (layout.empty() && update.empty()))
+        return;
+    std::cout<<"re-meshed "<<(layout.empty() ? dirty.size() : all.size())<<" of "<<all.size()<<" chunks ("
+             <<m_cellsVisited<<" cells) in "<<m_phaseTimes.interpolate<<" ms\n";
+}
+
+template <typename V>
+void MachingCube::remeshChunks(const std::vector<unsigned int> &_levels, const std::vector<unsigned int> &_chunks)
+{
+    // every chunk is counted and extracted by one thread into its own vectors, the threads take every nth chunk
+    const size_t nLevels = _levels.size();
+    std::vector<std::vector<std::vector<V> > > verts(_chunks.size(), std::vector<std::vector<V> >(nLevels));
+    auto extract = [this, &verts, &_chunks, nLevels](unsigned int _worker, unsigned int _nWorkers)
+    {
+        std::vector<size_t> counts;
+        std::vector<V *> outs(nLevels);
+        for(size_t c=_worker;c<_chunks.size();c+=_nWorkers)
+        {
+            const CellBox box = chunkBox(_chunks[c]);
+            sweepCount<float>(box, counts);
+            for(size_t l=0;l<nLevels;l++)
+            {
+                verts[c][l].resize(counts[l]*3);
+                outs[l] = verts[c][l].empty() ? 0 : &verts[c][l][0];
+            }
+            sweepSlab<float>(box, outs);
+        }
+    };
+    const unsigned int nWorkers = std::max(1u, std::min(m_numThreads, (unsigned int)_chunks.size()));
+    std::vector<std::thread> workers;
+    for(unsigned int w=1;w<nWorkers;w++)
+    {
+        workers.push_back(std::thread(extract, w, nWorkers));
+    }
+    extract(0, nWorkers);
+    for(size_t w=0;w<workers.size();w++)
+    {
+        workers[w].join();
+    }
+
+    for(size_t l=0;l<nLevels;l++)
+    {
+        GpuMesh &mesh = m_meshes[_levels[l]];
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+        if(mesh.chunkFirst.empty())
+        {
+            mesh.numIndices = 0;
+            mesh.drawIndirect = false;
+            // a fresh layout with some room in every chunk (in whole triangles) so a stroke seldom moves one
+            const size_t nChunks = m_dirtyChunks.size();
+            mesh.chunkFirst.resize(nChunks);
+            mesh.chunkCount.assign(nChunks, 0);
+            mesh.chunkCapacity.resize(nChunks);
+            for(size_t c=0;c<nChunks;c++)
+            {
+                const GLsizei count = verts[c][l].size();
+                mesh.chunkFirst[c] = mesh.chunkEnd;
+                mesh.chunkCapacity[c] = count == 0 ? 0 : count+count/12*3+48;
+                mesh.chunkEnd += mesh.chunkCapacity[c];
+            }
+            if(mesh.chunkEnd*sizeof(V) > mesh.vboCapacity)
+            {
+                mesh.vboCapacity = mesh.chunkEnd*sizeof(V) + mesh.chunkEnd*sizeof(V)/4;
+                glBufferData(GL_ARRAY_BUFFER, mesh.vboCapacity, 0, GL_DYNAMIC_DRAW);
+            }
+        }
+        for(size_t x=0;x<_chunks.size();x++)
+        {
+            const unsigned int c = _chunks[x];
+            const GLsizei count = verts[x][l].size();
+            if(count > mesh.chunkCapacity[c])
+            {
+                // the chunk moves to the end of the buffer, which grows by copying it on the GPU if it has to
+                const GLsizei capacity = count+count/12*3+48;
+                if((mesh.chunkEnd+capacity)*sizeof(V) > mesh.vboCapacity)
+                {
+                    const size_t bytes = (mesh.chunkEnd+capacity)*sizeof(V)*3/2;
+                    GLuint vbo;
+                    glGenBuffers(1, &vbo);
+                    glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+                    glBufferData(GL_COPY_WRITE_BUFFER, bytes, 0, GL_DYNAMIC_DRAW);
+                    glBindBuffer(GL_COPY_READ_BUFFER, mesh.vbo);
+                    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, mesh.chunkEnd*sizeof(V));
+                    glDeleteBuffers(1, &mesh.vbo);
+                    mesh.vbo = vbo;
+                    mesh.vboCapacity = bytes;
+                    setVertexLayout(mesh);
+                    mesh.vao->unbind();
+                    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+                }
+                mesh.chunkFirst[c] = mesh.chunkEnd;
+                mesh.chunkCapacity[c] = capacity;
+                mesh.chunkEnd += capacity;
+            }
+            if(count > 0)
+                glBufferSubData(GL_ARRAY_BUFFER, mesh.chunkFirst[c]*sizeof(V), count*sizeof(V), &verts[x][l][0]);
+            mesh.numIndices += count-mesh.chunkCount[c];
+            mesh.chunkCount[c] = count;
+        }
+        mesh.numVerts = mesh.numIndices;
+        mesh.isolevel = getIsolevel(_levels[l]);
+        mesh.vao->bind();
+        mesh.vao->setNumIndices(mesh.numIndices);
+        mesh.vao->unbind();
+    }
+    m_nVerts = m_meshes[0].numVerts;
+}
+
+bool MachingCube::canCache() const
+{
+    return m_meshCache && volumeData == 0 && !m_function && m_volume.isOpen() && m_stride == 1 && !adaptiveOutput();
+}
+
+MeshCacheKey MachingCube::cacheKey(unsigned int _level) const
+{
+    MeshCacheKey key;
+    // the key is compared as raw bytes so there must be no stray padding
+    std::memset(&key, 0, sizeof(key));
+    key.volumeHash = m_volumeHash;
+    key.width = volume_width;
+    key.height = volume_height;
+    key.depth = volume_depth;
+    key.bytesPerVoxel = m_volume.getBytesPerVoxel();
+    key.isolevel = getIsolevel(_level);
+    key.flags = (indexedOutput() ? 1 : 0) | (m_smoothNormals ? 2 : 0) | (unsigned int)m_mesher<<2 | (m_weld ? 8 : 0) |
+                (m_vertexFormat == VertexFormat::PACKED ? 16 : 0);
+    key.decimation = (uint32_t)std::min<size_t>(m_decimationTarget, 0xffffffffu);
+    return key;
+}
+
+bool MachingCube::loadCachedMesh(unsigned int _level)
+{
+    const MeshCacheKey key = cacheKey(_level);
+    const std::string file = MeshCache::fileName(m_volumeFile, key);
+    MeshCache cache;
+    if(!cache.open(file, key))
+        return false;
+    // straight from the mapped file into the buffers, the element buffer binding belongs to the VAO
+    GpuMesh &mesh = m_meshes[_level];
+    mesh.drawIndirect = false;
+    mesh.vao->bind();
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+    glBufferData(GL_ARRAY_BUFFER, cache.getVertexBytes(), cache.getVertices(), GL_DYNAMIC_DRAW);
+    mesh.vboCapacity = cache.getVertexBytes();
+    mesh.numVerts = cache.getVertexBytes()/vertexSize();
+    mesh.numIndices = mesh.numVerts;
+    if(indexedOutput())
+    {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ibo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, cache.getIndexBytes(), cache.getIndices(), GL_DYNAMIC_DRAW);
+        mesh.iboCapacity = cache.getIndexBytes();
+        mesh.numIndices = cache.getIndexBytes()/sizeof(GLuint);
+    }
+    mesh.isolevel = getIsolevel(_level);
+    mesh.vao->setNumIndices(mesh.numIndices);
+    mesh.vao->unbind();
+    if(m_verbose)
+        std::cout<<"isolevel "<<mesh.isolevel<<" : "<<mesh.numVerts<<" vertices, "<<mesh.numIndices/3<<" triangles from "<<file<<"\n";
+    return true;
+}
+
+void MachingCube::saveCachedMesh(unsigned int _level)
+{
+    GpuMesh &mesh = m_meshes[_level];
+    // the file needs the vertex count of a GPU extraction now, one that overflowed is saved after its second go
+    if(finishGpuMesh(mesh, true))
+        return;
+    // an empty mesh may just be a failed upload, it isn't worth keeping either way
+    if(mesh.numIndices == 0)
+        return;
+    // the buffers were only ever mapped for writing so they are read back for the file
+    std::vector<unsigned char> verts(mesh.numVerts*vertexSize());
+    std::vector<GLuint> indices(indexedOutput() ? mesh.numIndices : 0);
+    mesh.vao->bind();
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+    glGetBufferSubData(GL_ARRAY_BUFFER, 0, verts.size(), &verts[0]);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ibo);
+    if(!indices.empty())
+        glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size()*sizeof(GLuint), &indices[0]);
+    mesh.vao->unbind();
+    const MeshCacheKey key = cacheKey(_level);
+    const std::string file = MeshCache::fileName(m_volumeFile, key);
+    if(MeshCache::write(file, key, &verts[0], verts.size(),
+                        indices.empty() ? 0 : &indices[0], indices.size()*sizeof(GLuint)) && m_verbose)
+        std::cout<<"cached isolevel "<<mesh.isolevel<<" in "<<file<<"\n";
+}
+
+void *MachingCube::mapBuffer(GLenum _target, GLuint _buffer, size_t &io_capacity, size_t _size)
+{
+    glBindBuffer(_target, _buffer);
+    if(_size > io_capacity)
+    {
+        // leave some room so scrubbing the isolevel doesn't reallocate every time the mesh grows a bit
+        io_capacity = _size + _size/4;
+        glBufferData(_target, io_capacity, 0, GL_DYNAMIC_DRAW);
+    }
+    if(_size == 0)
+        return 0;
+    // we overwrite the whole range so the driver doesn't need to keep the old contents around
+    return glMapBufferRange(_target, 0, _size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+}
+
+VoxelType MachingCube::voxelType() const
+{
+    return volumeData != 0 || m_function ? VoxelType::FLOAT : m_volume.getVoxelType();
+}
+
+float MachingCube::nativeIsolevel(float _iso) const
+{
+    // generated volumes are already in the isolevel's range, file volumes keep their raw
+    // values so we scale the isolevel to the value range of the file once instead of
+    // normalising every voxel, which is the same test as the voxels only get shifted and scaled.
+    // A coarse level is given its isolevels in that range already, see refreshMesh
+    if(volumeData != 0 || m_function || m_stride != 1)
+        return _iso;
+    return m_pyramid.getMinValue() + _iso*(m_pyramid.getMaxValue()-m_pyramid.getMinValue());
+}
+
+void MachingCube::buildPyramid()
+{
+    // file volumes drop each slice as soon as the sweep is done with it
+    // and hash the file on the way for the mesh cache
+    std::function<void(unsigned int)> done;
+    if(volumeData == 0)
+    {
+        m_volumeHash = MeshCache::hash(0, 0);
+        const size_t sliceBytes = (size_t)volume_width*volume_height*m_volume.getBytesPerVoxel();
+        done = [this, sliceBytes](unsigned int _s)
+        {
+            m_volumeHash = MeshCache::hash(m_volume.getSlice(_s), sliceBytes, m_volumeHash);
+            m_volume.releaseSlices(_s, _s+1);
+        };
+    }
+    switch(voxelType())
+    {
+        case VoxelType::UINT8 : m_pyramid.build(volumeView<unsigned char>(), done); break;
+        case VoxelType::UINT16 : m_pyramid.build(volumeView<unsigned short>(), done); break;
+        case VoxelType::FLOAT : m_pyramid.build(volumeView<float>(), done); break;
+    }
+}
+
+template <typename T>
+VolumeView<T> MachingCube::volumeView() const
+{
+    const void *data = volumeData != 0 ? static_cast<const void *>(volumeData) : m_volume.getSlice(0);
+    return VolumeView<T>(data, volume_width, volume_height, volume_depth);
+}
+
+template <typename T>
+void MachingCube::moveWindow(SliceWindow<T> &_w, const VolumeView<T> &_volume, unsigned int _i) const
+{
+    // the window holds slices _i-1 to _i+2, slice -1 wraps round to a huge index
+    // so the range test also covers the first slice
+    _w.first = _i-1;
+    for(unsigned int slot=0; slot<4; slot++)
+    {
+        unsigned int s = _i-1+slot;
+        if(s >= volume_depth || !m_function)
+        {
+            _w.slice[slot] = s < volume_depth ? _volume.getSlice(s) : 0;
+            continue;
+        }
+        // only the gradient normals need the outer two slices of a function, each slice is
+        // sampled once as it comes into the window and dropped when it is overwritten by s+4
+        if(!m_smoothNormals && (slot == 0 || slot == 3))
+        {
+            _w.slice[slot] = 0;
+            continue;
+        }
+        std::vector<T> &sampled = _w.sampled[s&3];
+        if(_w.sampledSlice[s&3] != s)
+        {
+            sampled.resize((size_t)volume_width*volume_height);
+            sampleFunction(s, &sampled[0]);
+            _w.sampledSlice[s&3] = s;
+        }
+        _w.slice[slot] = &sampled[0];
+    }
+    // we never go back so the pages of the slice we just left can go
+    if(volumeData == 0 && !m_function && _i >= 2)
+    {
+        m_volume.releaseSlices(_i-2, _i-1);
+    }
+}
+
+template <typename T>
+void MachingCube::fillVoxel(unsigned int _i, unsigned int _j, unsigned int _k, Voxel &_grid, const SliceWindow<T> &_w) const
+{
+    // slot 1 of the window is slice _i and slot 2 is slice _i+1
+    const T *s0 = _w.slice[1];
+    const T *s1 = _w.slice[2];
+    _grid.p[0].m_x = _i;
+    _grid.p[0].m_y = _j;
+    _grid.p[0].m_z = _k;
+    _grid.val[0] = s0[_j*volume_width + _k];
+    _grid.p[1].m_x = _i+1;
+    _grid.p[1].m_y = _j;
+    _grid.p[1].m_z = _k;
+    _grid.val[1] = s1[_j*volume_width + _k];
+    _grid.p[2].m_x = _i+1;
+    _grid.p[2].m_y = _j+1;
+    _grid.p[2].m_z = _k;
+    _grid.val[2] = s1[(_j+1)*volume_width + _k];
+    _grid.p[3].m_x = _i;
+    _grid.p[3].m_y = _j+1;
+    _grid.p[3].m_z = _k;
+    _grid.val[3] = s0[(_j+1)*volume_width + _k];
+    _grid.p[4].m_x = _i;
+    _grid.p[4].m_y = _j;
+    _grid.p[4].m_z = _k+1;
+    _grid.val[4] = s0[_j*volume_width + _k+1];
+    _grid.p[5].m_x = _i+1;
+    _grid.p[5].m_y = _j;
+    _grid.p[5].m_z = _k+1;
+    _grid.val[5] = s1[_j*volume_width + _k+1];
+    _grid.p[6].m_x = _i+1;
+    _grid.p[6].m_y = _j+1;
+    _grid.p[6].m_z = _k+1;
+    _grid.val[6] = s1[(_j+1)*volume_width + _k+1];
+    _grid.p[7].m_x = _i;
+    _grid.p[7].m_y = _j+1;
+    _grid.p[7].m_z = _k+1;
+    _grid.val[7] = s0[(_j+1)*volume_width + _k+1];
+}
+
+void MachingCube::findCellRuns(unsigned int _i, const std::vector<float> &_isos, std::vector<CellRun> &_runs) const
+{
+    _runs.clear();
+    const unsigned int cellsHigh = volume_height-1;
+    const unsigned int cellsWide = volume_width-1;
+    if(!m_skipEmpty || m_pyramid.isEmpty())
+    {
+        for(unsigned int j=0;j<cellsHigh;j++)
+        {
+            CellRun run = {j, 0, cellsWide};
+            _runs.push_back(run);
+        }
+        return;
+    }
+    const unsigned int size = MinMaxPyramid::BlockSize;
+    std::vector<std::pair<unsigned int, unsigned int> > blocks, levelBlocks, merged;
+    m_pyramid.activeBlocks(_i/size, _isos[0], blocks);
+    for(size_t l=1;l<_isos.size();l++)
+    {
+        // both lists are sorted the same way so the union keeps the order below
+        m_pyramid.activeBlocks(_i/size, _isos[l], levelBlocks);
+        merged.clear();
+        std::set_union(blocks.begin(), blocks.end(), levelBlocks.begin(), levelBlocks.end(), std::back_inserter(merged));
+        blocks.swap(merged);
+    }
+    // the blocks come ordered by row of blocks then column so each row of cells inside a row of blocks
+    // is built left to right, and neighbouring blocks are merged into one run
+    size_t rowStart = 0;
+    while(rowStart < blocks.size())
+    {
+        size_t rowEnd = rowStart;
+        while(rowEnd < blocks.size() && blocks[rowEnd].first == blocks[rowStart].first)
+            ++rowEnd;
+        unsigned int bj = blocks[rowStart].first;
+        for(unsigned int j=bj*size; j<std::min((bj+1)*size, cellsHigh); j++)
+        {
+            for(size_t b=rowStart; b<rowEnd; b++)
+            {
+                unsigned int k0 = blocks[b].second*size;
+                unsigned int k1 = std::min(k0+size, cellsWide);
+                if(!_runs.empty() && _runs.back().j == j && _runs.back().kEnd == k0)
+                {
+                    _runs.back().kEnd = k1;
+                }
+                else
+                {
+                    CellRun run = {j, k0, k1};
+                    _runs.push_back(run);
+                }
+            }
+        }
+        rowStart = rowEnd;
+    }
+}
+
+MachingCube::CellBox MachingCube::slabBox(unsigned int _begin, unsigned int _end) const
+{
+    CellBox box = {{_begin, 0, 0}, {_end, volume_height-1, volume_width-1}};
+    return box;
 }
 
-bool MachingCube::LoadVolumeFromFile(std::string _vol)
+MachingCube::CellBox MachingCube::chunkBox(unsigned int _chunk) const
 {
-    std::ifstream in(_vol.c_str(), std::ifstream::binary);
-    if (in.is_open() != true)
+    const unsigned int cells[3] = {volume_depth-1, volume_height-1, volume_width-1};
+    const unsigned int c[3] = {_chunk/(m_chunks[1]*m_chunks[2]), _chunk/m_chunks[2]%m_chunks[1], _chunk%m_chunks[2]};
+    CellBox box;
+    for(int a=0;a<3;a++)
     {
-        std::cout<<"FILE NOT FOUND !!!! "<<_vol.c_str()<<"\n";
-        return false;
+        box.begin[a] = c[a]*ChunkCells;
+        box.end[a] = std::min(box.begin[a]+ChunkCells, cells[a]);
     }
-    // read in the volume data 200x160x160, 1 byte per voxel
-    volume_width = 200;
-    volume_height = 160;
-    volume_depth = 160;
-    unsigned int volume_size = volume_width*volume_height*volume_depth;
-    char *volData = new char[volume_size];
-    in.read(volData, volume_size);
+    return box;
+}
 
-    // compute the minimum and maximum value of the volume
-    unsigned char minVolumeData;
-    unsigned char maxVolumeData;
-    minVolumeData=maxVolumeData=volData[0];
-    for(unsigned int i = 1; i<volume_size; i++)
+void MachingCube::clipRuns(const CellBox &_box, std::vector<CellRun> &io_runs) const
+{
+    if(_box.begin[1] == 0 && _box.end[1] >= volume_height-1 && _box.begin[2] == 0 && _box.end[2] >= volume_width-1)
+        return;
+    size_t n=0;
+    for(size_t r=0;r<io_runs.size();r++)
     {
-        if(minVolumeData>volData[i]) minVolumeData = volData[i];
-        if(maxVolumeData<volData[i]) maxVolumeData = volData[i];
+        CellRun run = io_runs[r];
+        if(run.j < _box.begin[1] || run.j >= _box.end[1])
+            continue;
+        run.kBegin = std::max(run.kBegin, _box.begin[2]);
+        run.kEnd = std::min(run.kEnd, _box.end[2]);
+        if(run.kBegin < run.kEnd)
+            io_runs[n++] = run;
     }
+    io_runs.resize(n);
+}
+
+template <typename T>
+unsigned int MachingCube::classifyRun(RowClassifier &_classifier, const SliceWindow<T> &_w, const CellRun &_run, float _iso) const
+{
+    // slot 1 of the window is slice i and slot 2 is slice i+1
+    const size_t row = (size_t)_run.j*volume_width + _run.kBegin;
+    const T *s0j = _w.slice[1] + row;
+    const T *s1j = _w.slice[2] + row;
+    return _classifier.classify(s0j, s0j+volume_width, s1j, s1j+volume_width, _run.kEnd-_run.kBegin, _iso);
+}
+
+template <typename T, typename V>
+void MachingCube::sweepSlab(const CellBox &_box, const std::vector<V *> &_outs)
+{
+    Voxel       grid;
+    Triangle    triangles[5];
+    unsigned int    i,k,n,l,t,cell;
+    size_t      r;
+    unsigned long long visited = 0;
+    const VolumeView<T> volume = volumeView<T>();
+    const unsigned int nLevels = m_sweepLevels.size();
+    SliceWindow<T> window;
+    std::vector<CellRun> runs;
+    // one classifier per level, each keeps the active cells of its own level for the current run
+    std::vector<RowClassifier> classifiers(nLevels);
+    std::vector<unsigned int> nActive(nLevels), next(nLevels);
+    std::vector<V *> out(_outs);
 
-    // normalize volume value into [0.0, 1.0]
-    volumeData = new float[volume_size];
-    float dim =maxVolumeData - minVolumeData;
-    for(unsigned int i = 1; i<volume_size; i++)
+    for (i=_box.begin[0];i<_box.end[0];i++)
     {
-        volumeData[i]=((float)volData[i]-minVolumeData)/(float)dim;
+        moveWindow(window, volume, i);
+        // the runs only change when we move into the next layer of blocks
+        if(i == _box.begin[0] || i%MinMaxPyramid::BlockSize == 0)
+        {
+            findCellRuns(i, m_sweepLevels, runs);
+            clipRuns(_box, runs);
+        }
+        for (r=0;r<runs.size();r++)
+        {
+            const unsigned int j = runs[r].j;
+            visited += runs[r].kEnd-runs[r].kBegin;
+            // only the cells the surface goes through make it to the triangle generation
+            for (l=0;l<nLevels;l++)
+            {
+                nActive[l] = classifyRun(classifiers[l], window, runs[r], m_sweepLevels[l]);
+                next[l] = 0;
+            }
+            // walk the cells active at any level in order, so a cell the surfaces share is fetched once for all of them
+            for (;;)
+            {
+                cell = ~0u;
+                for (l=0;l<nLevels;l++)
+                {
+                    if(next[l] < nActive[l])
+                        cell = std::min(cell, classifiers[l].getActive()[next[l]]);
+                }
+                if(cell == ~0u)
+                    break;
+                k = runs[r].kBegin+cell;
+                fillVoxel(i, j, k, grid, window);
+                for (l=0;l<nLevels;l++)
+                {
+                    if(next[l] >= nActive[l] || classifiers[l].getActive()[next[l]] != cell)
+                        continue;
+                    ++next[l];
+                    n = MachingTriangles(grid, m_sweepLevels[l], triangles);
+                    // the triangles of a cell are packed straight away, they never go into a list
+                    for(t=0;t<n;t++)
+                    {
+                        packTriangle(window, triangles[t], out[l]);
+                        out[l] += 3;
+                    }
+                }
+            }
+        }
     }
+    m_cellsVisited += visited;
+}
 
-    delete volData;
-    in.close();
-    return true;
+template <typename T, typename V>
+void MachingCube::packTriangle(const SliceWindow<T> &_w, const Triangle &_tri, V *_out) const
+{
+    // two ways to compute the normal, 1. one normal per triangle; 2. each vertex got seperate normal
+    ngl::Vec3 normal;
+    if(!m_smoothNormals)
+        normal = computeTriangleNormal(_tri);
+    for(int v=0;v<3;v++)
+    {
+        // one normal for all three vertices in the triangle unless we have the gradient normals
+        if(m_smoothNormals)
+            normal = surfaceNormal(_w, _tri.p[v]);
+        storeVertex(_out[v], unitCoordinate(_tri.p[v].m_x, 0), unitCoordinate(_tri.p[v].m_y, 1),
+                    unitCoordinate(_tri.p[v].m_z, 2), normal);
+    }
 }
 
+template <typename T>
+void MachingCube::sweepCount(const CellBox &_box, std::vector<size_t> &_counts) const
+{
+    unsigned int    i,a,l;
+    size_t      r;
+    const VolumeView<T> volume = volumeView<T>();
+    const unsigned int nLevels = m_sweepLevels.size();
+    SliceWindow<T> window;
+    std::vector<CellRun> runs;
+    RowClassifier classifier;
 
-//----------------------------------------------------------------------------------------------------------------------
-MachingCube::~MachingCube()
+    _counts.assign(nLevels, 0);
+    for (i=_box.begin[0];i<_box.end[0];i++)
+    {
+        moveWindow(window, volume, i);
+        if(i == _box.begin[0] || i%MinMaxPyramid::BlockSize == 0)
+        {
+            findCellRuns(i, m_sweepLevels, runs);
+            clipRuns(_box, runs);
+        }
+        for (r=0;r<runs.size();r++)
+        {
+            for (l=0;l<nLevels;l++)
+            {
+                const unsigned int nActive = classifyRun(classifier, window, runs[r], m_sweepLevels[l]);
+                for (a=0;a<nActive;a++)
+                {
+                    _counts[l] += s_triangleCount.count[classifier.getCubeIndex(classifier.getActive()[a])];
+                }
+            }
+        }
+    }
+}
+
+template <typename T>
+void MachingCube::sweepSlabIndexed(unsigned int _begin, unsigned int _end, std::vector<IndexedMesh> &_meshes)
 {
-    delete volumeData;
+    Voxel       grid;
+    unsigned int    i,k,e,l,cell;
+    size_t      r;
+    int         cubeindex;
+    GLuint      vertlist[12];
+    unsigned long long visited = 0;
+    const GLuint empty = ~0u;
+    const unsigned int sliceSize = volume_width*volume_height;
+    const unsigned int nLevels = m_sweepLevels.size();
+    const VolumeView<T> volume = volumeView<T>();
+    SliceWindow<T> window;
+    std::vector<CellRun> runs;
+    std::vector<RowClassifier> classifiers(nLevels);
+    std::vector<unsigned int> nActive(nLevels), next(nLevels);
 
-    m_verts.erase(m_verts.begin(),m_verts.end());
-    if(m_vbo)
+    // edge caches holding the vertex index of every edge intersection already computed,
+    // two per slice for the j and k edges of each sample plus one for the depth edges
+    // running from slice i to slice i+1. Rather than clearing them for every layer (which
+    // would cost more than the sweep itself on a mostly empty volume) an entry is only
+    // valid if it was made since the layer that first used the slice, as the vertices are
+    // numbered in the order they are made. Every level has its own caches as its surface
+    // cuts the edges somewhere else
+    struct EdgeCache
     {
-        //glDeleteBuffers(1,&m_vboBuffers);
-        if(m_vaoMesh!=0)
+        std::vector<GLuint> sliceEdges[2];
+        std::vector<GLuint> depthEdges;
+        GLuint              layerStart;
+        std::vector<GLuint> *cache[3];
+        GLuint              validFrom[3];
+    };
+    std::vector<EdgeCache> caches(nLevels);
+    _meshes.resize(nLevels);
+
+    // the number of indices comes from the counting pass, a closed surface has about half as many
+    // shared vertices as triangles so we leave some room over that and only grow in the odd case it isn't enough
+    // there is no counting pass over a function as it would sample it all twice, the slab meshes just grow
+    std::vector<size_t> nTriangles(nLevels, 0);
+    if(!m_function)
+        sweepCount<T>(slabBox(_begin, _end), nTriangles);
+    for (l=0;l<nLevels;l++)
+    {
+        caches[l].sliceEdges[0].assign(sliceSize*2, empty);
+        caches[l].sliceEdges[1].assign(sliceSize*2, empty);
+        caches[l].depthEdges.assign(sliceSize, empty);
+        caches[l].layerStart = 0;
+        _meshes[l].indices.reserve(nTriangles[l]*3);
+        _meshes[l].verts.reserve(nTriangles[l]/2+nTriangles[l]/8+64);
+        if(m_smoothNormals)
+            _meshes[l].normals.reserve(_meshes[l].verts.capacity());
+    }
+
+    for (i=_begin;i<_end;i++)
+    {
+        moveWindow(window, volume, i);
+        if(i == _begin || i%MinMaxPyramid::BlockSize == 0)
+            findCellRuns(i, m_sweepLevels, runs);
+        for (l=0;l<nLevels;l++)
+        {
+            EdgeCache &c = caches[l];
+            GLuint previousStart = c.layerStart;
+            c.layerStart = _meshes[l].verts.size();
+            c.cache[0] = &c.sliceEdges[i&1];
+            c.cache[1] = &c.sliceEdges[(i+1)&1];
+            c.cache[2] = &c.depthEdges;
+            c.validFrom[0] = previousStart;
+            c.validFrom[1] = c.layerStart;
+            c.validFrom[2] = c.layerStart;
+        }
+        for (r=0;r<runs.size();r++)
         {
-            delete m_vaoMesh;
+            const unsigned int j = runs[r].j;
+            visited += runs[r].kEnd-runs[r].kBegin;
+            for (l=0;l<nLevels;l++)
+            {
+                nActive[l] = classifyRun(classifiers[l], window, runs[r], m_sweepLevels[l]);
+                next[l] = 0;
+            }
+            for (;;)
+            {
+                cell = ~0u;
+                for (l=0;l<nLevels;l++)
+                {
+                    if(next[l] < nActive[l])
+                        cell = std::min(cell, classifiers[l].getActive()[next[l]]);
+                }
+                if(cell == ~0u)
+                    break;
+                k = runs[r].kBegin+cell;
+                fillVoxel(i, j, k, grid, window);
+                for (l=0;l<nLevels;l++)
+                {
+                    if(next[l] >= nActive[l] || classifiers[l].getActive()[next[l]] != cell)
+                        continue;
+                    ++next[l];
+                    const float iso = m_sweepLevels[l];
+                    const EdgeCache &c = caches[l];
+                    IndexedMesh &mesh = _meshes[l];
+                    cubeindex = classifiers[l].getCubeIndex(cell);
+                    for (e=0;e<12;e++)
+                    {
+                        if (!(edgeTable[cubeindex] & (1<<e)))
+                            continue;
+                        const int *ec = edgeCache[e];
+                        unsigned int sample = (j+ec[3])*volume_width + k+ec[4];
+                        GLuint &id = ec[2] == 2 ? (*c.cache[2])[sample] : (*c.cache[ec[2]])[sample*2+ec[5]];
+                        if (id == empty || id < c.validFrom[ec[2]])
+                        {
+                            id = mesh.verts.size();
+                            mesh.verts.push_back(VertexInterp(iso, grid.p[ec[0]], grid.p[ec[1]], grid.val[ec[0]], grid.val[ec[1]]));
+                            if(m_smoothNormals)
+                                mesh.normals.push_back(surfaceNormal(window, mesh.verts.back()));
+                        }
+                        vertlist[e] = id;
+                    }
+                    for (e=0;triTable[cubeindex][e]!=-1;e++)
+                    {
+                        mesh.indices.push_back(vertlist[triTable[cubeindex][e]]);
+                    }
+                }
+            }
         }
     }
+    m_cellsVisited += visited;
 }
 
-float MachingCube::distFunc(ngl::Vec3 point1, ngl::Vec3 point2)
+/*-------------------------------------------------------------------------
+   Add the quad q0-q3 (in order round its edge) as two triangles, split
+   along the shorter diagonal as that gives the better shaped pair.
+   _flip reverses the winding.
+*/
+static void addQuad(IndexedMesh &_mesh, GLuint _q0, GLuint _q1, GLuint _q2, GLuint _q3, bool _flip)
 {
-    ngl::Vec3 vec = point1 - point2;
-    return (vec.length());
+    if(_flip)
+        std::swap(_q1, _q3);
+    const std::vector<ngl::Vec3> &v = _mesh.verts;
+    if((v[_q0]-v[_q2]).lengthSquared() <= (v[_q1]-v[_q3]).lengthSquared())
+    {
+        GLuint tris[6] = {_q0, _q1, _q2, _q0, _q2, _q3};
+        _mesh.indices.insert(_mesh.indices.end(), tris, tris+6);
+    }
+    else
+    {
+        GLuint tris[6] = {_q1, _q2, _q3, _q1, _q3, _q0};
+        _mesh.indices.insert(_mesh.indices.end(), tris, tris+6);
+    }
 }
 
-float MachingCube::metaballFunc(float r)
+template <typename T>
+void MachingCube::sweepSlabNets(unsigned int _begin, unsigned int _end, std::vector<IndexedMesh> &_meshes)
 {
-    // r is the distance from the sampling point to
-    // the centre of the all, it must be bigger than zero
-    float a = 1.0;
-    float b = 1.0;
-    if(r>=0 && r <=b/3.0)
-        return a*(1.0-3.0*r*r/b/b);
-    if(r<b && r >=b/3.0)
-        return 3.0*a/2.0*(1.0-r/b)*(1.0-r/b);
-    if(r>=b)
-        return 0;
+    Voxel       grid;
+    unsigned int    i,k,e,l,cell;
+    size_t      r;
+    int         cubeindex;
+    unsigned long long visited = 0;
+    const GLuint empty = ~0u;
+    const unsigned int cellsWide = volume_width-1;
+    const unsigned int layerSize = (volume_height-1)*cellsWide;
+    const unsigned int nLevels = m_sweepLevels.size();
+    const VolumeView<T> volume = volumeView<T>();
+    SliceWindow<T> window;
+    std::vector<CellRun> runs;
+    std::vector<RowClassifier> classifiers(nLevels);
+    std::vector<unsigned int> nActive(nLevels), next(nLevels);
+
+    // the vertex index of every cell of the current and the previous layer of cells, like the edge caches
+    // of the marching cubes an entry is only valid if it was made since its layer started
+    struct CellCache
+    {
+        std::vector<GLuint> cells[2];
+        GLuint              layerStart[2];
+    };
+    std::vector<CellCache> caches(nLevels);
+    _meshes.resize(nLevels);
+    for (l=0;l<nLevels;l++)
+    {
+        caches[l].cells[0].assign(layerSize, empty);
+        caches[l].cells[1].assign(layerSize, empty);
+        caches[l].layerStart[0] = caches[l].layerStart[1] = 0;
+    }
+
+    const unsigned int first = _begin > 0 ? _begin-1 : 0;
+    for (i=first;i<_end;i++)
+    {
+        moveWindow(window, volume, i);
+        if(i == first || i%MinMaxPyramid::BlockSize == 0)
+            findCellRuns(i, m_sweepLevels, runs);
+        for (l=0;l<nLevels;l++)
+        {
+            caches[l].layerStart[i&1] = _meshes[l].verts.size();
+        }
+        for (r=0;r<runs.size();r++)
+        {
+            const unsigned int j = runs[r].j;
+            visited += runs[r].kEnd-runs[r].kBegin;
+            for (l=0;l<nLevels;l++)
+            {
+                nActive[l] = classifyRun(classifiers[l], window, runs[r], m_sweepLevels[l]);
+                next[l] = 0;
+            }
+            for (;;)
+            {
+                cell = ~0u;
+                for (l=0;l<nLevels;l++)
+                {
+                    if(next[l] < nActive[l])
+                        cell = std::min(cell, classifiers[l].getActive()[next[l]]);
+                }
+                if(cell == ~0u)
+                    break;
+                k = runs[r].kBegin+cell;
+                fillVoxel(i, j, k, grid, window);
+                for (l=0;l<nLevels;l++)
+                {
+                    if(next[l] >= nActive[l] || classifiers[l].getActive()[next[l]] != cell)
+                        continue;
+                    ++next[l];
+                    const float iso = m_sweepLevels[l];
+                    CellCache &c = caches[l];
+                    IndexedMesh &mesh = _meshes[l];
+                    cubeindex = classifiers[l].getCubeIndex(cell);
+
+                    // the vertex of the cell sits at the average of the points where the surface crosses its edges
+                    ngl::Vec3 p(0.0, 0.0, 0.0), n(0.0, 0.0, 0.0);
+                    unsigned int nCrossings = 0;
+                    for (e=0;e<12;e++)
+                    {
+                        if (!(edgeTable[cubeindex] & (1<<e)))
+                            continue;
+                        const int *ec = edgeCache[e];
+                        ngl::Vec3 q = VertexInterp(iso, grid.p[ec[0]], grid.p[ec[1]], grid.val[ec[0]], grid.val[ec[1]]);
+                        p += q;
+                        if(m_smoothNormals)
+                            n += surfaceNormal(window, q);
+                        ++nCrossings;
+                    }
+                    const GLuint id = mesh.verts.size();
+                    mesh.verts.push_back(p/nCrossings);
+                    if(m_smoothNormals)
+                        mesh.normals.push_back(n);
+                    std::vector<GLuint> &layer = c.cells[i&1];
+                    std::vector<GLuint> &below = c.cells[(i+1)&1];
+                    layer[j*cellsWide+k] = id;
+                    if(i < _begin)
+                        continue;
+
+                    // every crossed edge is shared by four cells and joined up by the one it starts from, which
+                    // comes last in the sweep so the other three have their vertex already. Corner 0 of the cell
+                    // is the start of edges 0 (to corner 1, across the layer), 3 (along j) and 8 (along k) and the
+                    // quad faces down the gradient like the marching cubes triangles
+                    const bool inside = cubeindex & 1;
+                    const GLuint startBelow = c.layerStart[(i+1)&1];
+                    const GLuint startHere = c.layerStart[i&1];
+                    GLuint q[4];
+                    if(j > 0 && k > 0 && inside != ((cubeindex & 2) != 0))
+                    {
+                        q[0] = layer[(j-1)*cellsWide+k-1];
+                        q[1] = layer[j*cellsWide+k-1];
+                        q[2] = layer[(j-1)*cellsWide+k];
+                        if(q[0] != empty && q[0] >= startHere && q[1] != empty && q[1] >= startHere &&
+                           q[2] != empty && q[2] >= startHere)
+                            addQuad(mesh, q[0], q[1], id, q[2], inside);
+                    }
+                    if(i > 0 && k > 0 && inside != ((cubeindex & 8) != 0))
+                    {
+                        q[0] = below[j*cellsWide+k-1];
+                        q[1] = layer[j*cellsWide+k-1];
+                        q[2] = below[j*cellsWide+k];
+                        if(q[0] != empty && q[0] >= startBelow && q[0] < startHere && q[1] != empty && q[1] >= startHere &&
+                           q[2] != empty && q[2] >= startBelow && q[2] < startHere)
+                            addQuad(mesh, q[0], q[1], id, q[2], !inside);
+                    }
+                    if(i > 0 && j > 0 && inside != ((cubeindex & 16) != 0))
+                    {
+                        q[0] = below[(j-1)*cellsWide+k];
+                        q[1] = layer[(j-1)*cellsWide+k];
+                        q[2] = below[j*cellsWide+k];
+                        if(q[0] != empty && q[0] >= startBelow && q[0] < startHere && q[1] != empty && q[1] >= startHere &&
+                           q[2] != empty && q[2] >= startBelow && q[2] < startHere)
+                            addQuad(mesh, q[0], q[1], id, q[2], inside);
+                    }
+                }
+            }
+        }
+    }
+    m_cellsVisited += visited;
 }
 
-void MachingCube::generateVolume()
+/*-------------------------------------------------------------------------
+   The position of each cube corner inside its cell, one step along the
+   depth, height and width, as laid out by fillVoxel.
+*/
+static const unsigned int cornerOffset[8][3] =
+{
+    {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0},
+    {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}
+};
+
+// the axis cube edge _e runs along
+static unsigned int edgeAxis(int _e)
+{
+    const unsigned int *a = cornerOffset[edgeCache[_e][0]];
+    const unsigned int *b = cornerOffset[edgeCache[_e][1]];
+    return a[0] != b[0] ? 0 : a[1] != b[1] ? 1 : 2;
+}
+
+/*-------------------------------------------------------------------------
+   Central difference gradient of the volume at a sample, one sided on the
+   border, for the extractions that don't sweep a window of slices.
+*/
+template <typename T>
+static ngl::Vec3 volumeGradient(const VolumeView<T> &_volume, const unsigned int _p[3])
 {
-    volume_width = 100;
-    volume_height = 100;
-    volume_depth = 100;
-    unsigned int volume_size = volume_width*volume_height*volume_depth;
-    unsigned int i,j,k;
-    float val1, val2;
-    ngl::Vec3 point1(0.1, 0.5, 0.5);
-    ngl::Vec3 point2(0.9, 0.5, 0.5);
-    ngl::Vec3 node;
+    const unsigned int size[3] = {_volume.getDepth(), _volume.getHeight(), _volume.getWidth()};
+    ngl::Vec3 g;
+    for(unsigned int a=0;a<3;a++)
+    {
+        unsigned int lo[3] = {_p[0], _p[1], _p[2]};
+        unsigned int hi[3] = {_p[0], _p[1], _p[2]};
+        if(_p[a] > 0)
+            --lo[a];
+        if(_p[a]+1 < size[a])
+            ++hi[a];
+        g[a] = hi[a] > lo[a] ? ((float)_volume(hi[0], hi[1], hi[2])-_volume(lo[0], lo[1], lo[2]))/(hi[a]-lo[a]) : 0.0f;
+    }
+    return g;
+}
 
-    volumeData = new float[volume_size];
-    for (i=0;i<volume_depth;i++)
+/*-------------------------------------------------------------------------
+   Fill a loop of vertices lying in the plane across _axis with triangles
+   running the same way round, cutting off ears while there are any. A loop
+   that folds over itself or has no area left is fanned from its first
+   vertex instead.
+*/
+static void fillLoop(IndexedMesh &io_mesh, std::vector<GLuint> &io_loop, unsigned int _axis)
+{
+    const std::vector<ngl::Vec3> &v = io_mesh.verts;
+    const unsigned int b = (_axis+1)%3;
+    const unsigned int c = (_axis+2)%3;
+    // twice the signed area of the triangle p q r in the plane
+    auto area = [&](GLuint _p, GLuint _q, GLuint _r)
+    {
+        return (v[_q][b]-v[_p][b])*(v[_r][c]-v[_p][c])-(v[_q][c]-v[_p][c])*(v[_r][b]-v[_p][b]);
+    };
+    float loopArea = 0.0f;
+    for(size_t i=1;i+1<io_loop.size();i++)
+    {
+        loopArea += area(io_loop[0], io_loop[i], io_loop[i+1]);
+    }
+    while(io_loop.size() > 3)
     {
-        for (j=0;j<volume_height;j++)
+        const size_t n = io_loop.size();
+        size_t ear = n;
+        for(size_t i=0;i<n && ear == n;i++)
         {
-            for (k=0;k<volume_width;k++)
+            const GLuint p = io_loop[(i+n-1)%n], q = io_loop[i], r = io_loop[(i+1)%n];
+            if(area(p, q, r)*loopArea <= 0.0f)
+                continue;
+            ear = i;
+            for(size_t j=0;j<n && ear == i;j++)
             {
-                node.m_x = (float)i/volume_depth;
-                node.m_y = (float)j/volume_height;
-                node.m_z = (float)k/volume_width;
-                val1 = metaballFunc(distFunc(node, point1));
-                val2 = metaballFunc(distFunc(node, point2));
-                volumeData[i*volume_width*volume_height + j*volume_width + k] = val1 + val2;
+                const GLuint x = io_loop[j];
+                if(x != p && x != q && x != r &&
+                   area(p, q, x)*loopArea > 0.0f && area(q, r, x)*loopArea > 0.0f && area(r, p, x)*loopArea > 0.0f)
+                    ear = n;
             }
         }
+        if(ear == n)
+            break;
+        const GLuint tri[3] = {io_loop[(ear+n-1)%n], io_loop[ear], io_loop[(ear+1)%n]};
+        io_mesh.indices.insert(io_mesh.indices.end(), tri, tri+3);
+        io_loop.erase(io_loop.begin()+ear);
     }
-    isolevel = 1;
+    for(size_t i=1;i+1<io_loop.size();i++)
+    {
+        const GLuint tri[3] = {io_loop[0], io_loop[i], io_loop[i+1]};
+        io_mesh.indices.insert(io_mesh.indices.end(), tri, tri+3);
+    }
+}
 
+/*-------------------------------------------------------------------------
+   Close the crack in one coarse cell face. _segments are the face segments
+   of the coarse cell and of the fine cells on the other side, a segment
+   both sides have (running opposite ways) is already closed. The patch has
+   to run the other way round the rest of them, which join up into loops.
+*/
+static void closeCrack(const std::vector<std::pair<uint64_t, uint64_t> > &_segments,
+                       const std::unordered_map<uint64_t, GLuint> &_ids, unsigned int _axis, IndexedMesh &io_mesh)
+{
+    std::vector<std::pair<GLuint, GLuint> > open;
+    for(size_t s=0;s<_segments.size();s++)
+    {
+        std::unordered_map<uint64_t, GLuint>::const_iterator from = _ids.find(_segments[s].first);
+        std::unordered_map<uint64_t, GLuint>::const_iterator to = _ids.find(_segments[s].second);
+        if(from == _ids.end() || to == _ids.end())
+            return;
+        std::vector<std::pair<GLuint, GLuint> >::iterator twin =
+                std::find(open.begin(), open.end(), std::make_pair(to->second, from->second));
+        if(twin != open.end())
+            open.erase(twin);
+        else
+            open.push_back(std::make_pair(from->second, to->second));
+    }
+    std::vector<GLuint> loop;
+    while(!open.empty())
+    {
+        loop.assign(1, open.back().second);
+        GLuint next = open.back().first;
+        open.pop_back();
+        while(next != loop[0])
+        {
+            std::vector<std::pair<GLuint, GLuint> >::iterator s = open.begin();
+            while(s != open.end() && s->second != next)
+                ++s;
+            if(s == open.end())
+                break;
+            loop.push_back(next);
+            next = s->first;
+            open.erase(s);
+        }
+        if(next == loop[0] && loop.size() >= 3)
+            fillLoop(io_mesh, loop, _axis);
+    }
 }
 
-void MachingCube::createVAO()
+void MachingCube::extractAdaptive(std::vector<std::vector<IndexedMesh> > &_levelMeshes)
 {
-    // if we have already created a VBO just return.
-    if(m_vao == true)
+    switch(voxelType())
     {
-        std::cout<<"VAO exist so returning\n";
-        return;
+        case VoxelType::UINT8 : sweepAdaptive<unsigned char>(_levelMeshes); break;
+        case VoxelType::UINT16 : sweepAdaptive<unsigned short>(_levelMeshes); break;
+        case VoxelType::FLOAT : sweepAdaptive<float>(_levelMeshes); break;
     }
+}
 
-    // now we are going to process and pack the mesh into an ngl::VertexArrayObject
-    std::vector <VertData> vboMesh;
-    VertData    d;
-    Voxel       grid;
-    std::vector<Triangle> allTriangles;
-    unsigned int    i,j,k, n;
+template <typename T>
+void MachingCube::sweepAdaptive(std::vector<std::vector<IndexedMesh> > &_levelMeshes)
+{
+    // the leaves are shared out between the threads in order, the keys of the vertices then join the parts up
+    const size_t nLeaves = m_octree.getLeaves().size();
+    const unsigned int nLevels = m_sweepLevels.size();
+    const size_t nParts = std::max<size_t>(1, std::min<size_t>(m_numThreads, nLeaves));
+    std::vector<std::vector<IndexedMesh> > parts(nParts);
+    std::vector<std::vector<std::vector<uint64_t> > > keys(nParts);
+    if(nParts == 1)
+    {
+        sweepLeaves<T>(0, nLeaves, parts[0], keys[0]);
+    }
+    else
+    {
+        std::vector<std::thread> workers;
+        for(size_t i=0;i<nParts;i++)
+        {
+            workers.push_back(std::thread(&MachingCube::sweepLeaves<T>, this, nLeaves*i/nParts, nLeaves*(i+1)/nParts,
+                                          std::ref(parts[i]), std::ref(keys[i])));
+        }
+        for(size_t i=0;i<nParts;i++)
+        {
+            workers[i].join();
+        }
+    }
+    _levelMeshes.assign(1, std::vector<IndexedMesh>(nLevels));
+    std::vector<GLuint> remap;
+    for(unsigned int l=0;l<nLevels;l++)
+    {
+        IndexedMesh &mesh = _levelMeshes[0][l];
+        std::unordered_map<uint64_t, GLuint> ids;
+        for(size_t p=0;p<nParts;p++)
+        {
+            IndexedMesh &part = parts[p][l];
+            const std::vector<uint64_t> &partKeys = keys[p][l];
+            remap.resize(part.verts.size());
+            for(size_t v=0;v<part.verts.size();v++)
+            {
+                std::pair<std::unordered_map<uint64_t, GLuint>::iterator, bool> id =
+                        ids.insert(std::make_pair(partKeys[v], (GLuint)mesh.verts.size()));
+                if(id.second)
+                {
+                    mesh.verts.push_back(part.verts[v]);
+                    if(m_smoothNormals)
+                        mesh.normals.push_back(part.normals[v]);
+                }
+                remap[v] = id.first->second;
+            }
+            for(size_t i=0;i<part.indices.size();i++)
+            {
+                mesh.indices.push_back(remap[part.indices[i]]);
+            }
+            part = IndexedMesh();
+        }
+        patchCracks<T>(m_sweepLevels[l], ids, mesh);
+    }
+}
 
-    m_nVerts = 0;
+template <typename T>
+void MachingCube::sweepLeaves(size_t _begin, size_t _end, std::vector<IndexedMesh> &_meshes,
+                              std::vector<std::vector<uint64_t> > &_keys)
+{
+    const unsigned int n = AdaptiveOctree::LeafCells+1;
+    const unsigned int size[3] = {volume_depth, volume_height, volume_width};
+    const unsigned int nLevels = m_sweepLevels.size();
+    const VolumeView<T> volume = volumeView<T>();
+    const std::vector<AdaptiveOctree::Leaf> &leaves = m_octree.getLeaves();
+    std::vector<std::unordered_map<uint64_t, GLuint> > ids(nLevels);
+    std::vector<float> values(n*n*n);
+    unsigned int pos[3][AdaptiveOctree::LeafCells+1], cells[3], p[3], q[3], c, e, i, j, k, l;
+    unsigned long long visited = 0;
+    Voxel grid;
+    GLuint vertlist[12];
+    _meshes.resize(nLevels);
+    _keys.resize(nLevels);
+    for(size_t x=_begin;x<_end;x++)
+    {
+        const AdaptiveOctree::Leaf &leaf = leaves[x];
+        const unsigned int step = 1u<<leaf.level;
+        for(unsigned int a=0;a<3;a++)
+        {
+            cells[a] = 0;
+            for(c=0;c<n;c++)
+            {
+                pos[a][c] = std::min(leaf.origin[a]+c*step, size[a]-1);
+                if(c+1 < n && pos[a][c] < size[a]-1)
+                    cells[a] = c+1;
+            }
+        }
+        // the samples on the faces of the leaf may be shared with a coarser leaf, the ones inside are the voxels
+        float lo = FLT_MAX, hi = -FLT_MAX;
+        for(i=0;i<=cells[0];i++)
+        {
+            for(j=0;j<=cells[1];j++)
+            {
+                for(k=0;k<=cells[2];k++)
+                {
+                    p[0] = pos[0][i];
+                    p[1] = pos[1][j];
+                    p[2] = pos[2][k];
+                    const bool face = i == 0 || j == 0 || k == 0 || i == cells[0] || j == cells[1] || k == cells[2];
+                    const float v = face ? m_octree.value(volume, p) : (float)volume(p[0], p[1], p[2]);
+                    values[(i*n + j)*n + k] = v;
+                    lo = std::min(lo, v);
+                    hi = std::max(hi, v);
+                }
+            }
+        }
+        visited += (unsigned long long)cells[0]*cells[1]*cells[2];
+        for(l=0;l<nLevels;l++)
+        {
+            const float iso = m_sweepLevels[l];
+            if(!(lo < iso && hi >= iso))
+                continue;
+            IndexedMesh &mesh = _meshes[l];
+            for(i=0;i<cells[0];i++)
+            {
+                for(j=0;j<cells[1];j++)
+                {
+                    for(k=0;k<cells[2];k++)
+                    {
+                        for(c=0;c<8;c++)
+                        {
+                            const unsigned int ci = i+cornerOffset[c][0], cj = j+cornerOffset[c][1], ck = k+cornerOffset[c][2];
+                            grid.p[c].m_x = pos[0][ci];
+                            grid.p[c].m_y = pos[1][cj];
+                            grid.p[c].m_z = pos[2][ck];
+                            grid.val[c] = values[(ci*n + cj)*n + ck];
+                        }
+                        const int cubeindex = computeCubeIndex(grid, iso);
+                        if(edgeTable[cubeindex] == 0)
+                            continue;
+                        for(e=0;e<12;e++)
+                        {
+                            if(!(edgeTable[cubeindex] & (1<<e)))
+                                continue;
+                            const int c0 = edgeCache[e][0], c1 = edgeCache[e][1];
+                            const unsigned int axis = edgeAxis(e);
+                            p[0] = (unsigned int)grid.p[c0].m_x;
+                            p[1] = (unsigned int)grid.p[c0].m_y;
+                            p[2] = (unsigned int)grid.p[c0].m_z;
+                            unsigned int level = leaf.level;
+                            const uint64_t key = m_octree.edgeKey(p, axis, level);
+                            std::unordered_map<uint64_t, GLuint>::const_iterator found = ids[l].find(key);
+                            if(found != ids[l].end())
+                            {
+                                vertlist[e] = found->second;
+                                continue;
+                            }
+                            // an edge along an edge of a coarser leaf is cut where the coarse leaf cuts it
+                            std::copy(p, p+3, q);
+                            q[axis] = m_octree.cellEnd(p[axis], axis, level);
+                            const ngl::Vec3 a(p[0], p[1], p[2]), b(q[0], q[1], q[2]);
+                            const float va = level == leaf.level ? grid.val[c0] : m_octree.value(volume, p);
+                            const float vb = level == leaf.level ? grid.val[c1] : m_octree.value(volume, q);
+                            vertlist[e] = mesh.verts.size();
+                            ids[l].insert(std::make_pair(key, vertlist[e]));
+                            _keys[l].push_back(key);
+                            mesh.verts.push_back(VertexInterp(iso, a, b, va, vb));
+                            if(m_smoothNormals)
+                            {
+                                // the gradients of the two ends interpolated the same way as the position
+                                const float mu = (mesh.verts.back()[axis]-a[axis])/(b[axis]-a[axis]);
+                                ngl::Vec3 g = volumeGradient(volume, p);
+                                g += (volumeGradient(volume, q)-g)*mu;
+                                if(g.length()>0.0)
+                                    g.normalize();
+                                mesh.normals.push_back(-g);
+                            }
+                        }
+                        for(e=0;triTable[cubeindex][e]!=-1;e++)
+                        {
+                            mesh.indices.push_back(vertlist[triTable[cubeindex][e]]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    m_cellsVisited += visited;
+}
 
-    for (i=0;i<volume_depth-1;i++)
+template <typename T>
+void MachingCube::patchCracks(float _iso, const std::unordered_map<uint64_t, GLuint> &_ids, IndexedMesh &io_mesh) const
+{
+    const unsigned int size[3] = {volume_depth, volume_height, volume_width};
+    const VolumeView<T> volume = volumeView<T>();
+    const std::vector<AdaptiveOctree::Leaf> &leaves = m_octree.getLeaves();
+    std::vector<std::pair<uint64_t, uint64_t> > segments;
+    unsigned int coarse[3], fine[3], node[3];
+    for(size_t x=0;x<leaves.size();x++)
     {
-        for (j=0;j<volume_height-1;j++)
+        const AdaptiveOctree::Leaf &leaf = leaves[x];
+        if(leaf.level == 0)
+            continue;
+        const unsigned int step = 1u<<leaf.level;
+        const unsigned int half = step/2;
+        for(unsigned int axis=0;axis<3;axis++)
         {
-            for (k=0;k<volume_width-1;k++)
+            for(unsigned int side=0;side<2;side++)
             {
-                grid.p[0].m_x = i;
-                grid.p[0].m_y = j;
-                grid.p[0].m_z = k;
-                grid.val[0] = volumeData[i*volume_width*volume_height + j*volume_width + k];
-                grid.p[1].m_x = i+1;
-                grid.p[1].m_y = j;
-                grid.p[1].m_z = k;
-                grid.val[1] = volumeData[(i+1)*volume_width*volume_height + j*volume_width + k];
-                grid.p[2].m_x = i+1;
-                grid.p[2].m_y = j+1;
-                grid.p[2].m_z = k;
-                grid.val[2] = volumeData[(i+1)*volume_width*volume_height + (j+1)*volume_width + k];
-                grid.p[3].m_x = i;
-                grid.p[3].m_y = j+1;
-                grid.p[3].m_z = k;
-                grid.val[3] = volumeData[i*volume_width*volume_height + (j+1)*volume_width + k];
-                grid.p[4].m_x = i;
-                grid.p[4].m_y = j;
-                grid.p[4].m_z = k+1;
-                grid.val[4] = volumeData[i*volume_width*volume_height + j*volume_width + k+1];
-                grid.p[5].m_x = i+1;
-                grid.p[5].m_y = j;
-                grid.p[5].m_z = k+1;
-                grid.val[5] = volumeData[(i+1)*volume_width*volume_height + j*volume_width + k+1];
-                grid.p[6].m_x = i+1;
-                grid.p[6].m_y = j+1;
-                grid.p[6].m_z = k+1;
-                grid.val[6] = volumeData[(i+1)*volume_width*volume_height + (j+1)*volume_width + k+1];
-                grid.p[7].m_x = i;
-                grid.p[7].m_y = j+1;
-                grid.p[7].m_z = k+1;
-                grid.val[7] = volumeData[i*volume_width*volume_height + (j+1)*volume_width + k+1];
-                n = MachingTriangles(grid, isolevel, allTriangles);
-                m_nVerts += n*3;
+                // the faces on the border of the volume have no neighbour, the others are patched from the coarse side
+                const unsigned int face = side ? leaf.origin[axis]+AdaptiveOctree::LeafCells*step : leaf.origin[axis];
+                if(face == 0 || face >= size[axis]-1)
+                    continue;
+                for(unsigned int a=0;a<3;a++)
+                {
+                    node[a] = leaf.origin[a]/AdaptiveOctree::LeafCells;
+                }
+                node[axis] = face/AdaptiveOctree::LeafCells-(side ? 0 : 1);
+                if(m_octree.leafLevel(node[0], node[1], node[2]) >= leaf.level)
+                    continue;
+                const unsigned int b = (axis+1)%3;
+                const unsigned int c = (axis+2)%3;
+                const unsigned int endB = std::min(leaf.origin[b]+AdaptiveOctree::LeafCells*step, size[b]-1);
+                const unsigned int endC = std::min(leaf.origin[c]+AdaptiveOctree::LeafCells*step, size[c]-1);
+                coarse[axis] = side ? face-step : face;
+                fine[axis] = side ? face : face-half;
+                for(coarse[b]=leaf.origin[b];coarse[b]<endB;coarse[b]+=step)
+                {
+                    for(coarse[c]=leaf.origin[c];coarse[c]<endC;coarse[c]+=step)
+                    {
+                        // the fine samples on the face are interpolated from the coarse ones so the surface
+                        // can only cross the fine cells there if it crosses the coarse one
+                        segments.clear();
+                        if(!faceSegments(volume, leaf.level, coarse, axis, side, _iso, segments))
+                            continue;
+                        for(fine[b]=coarse[b];fine[b]<m_octree.cellEnd(coarse[b], b, leaf.level);fine[b]+=half)
+                        {
+                            for(fine[c]=coarse[c];fine[c]<m_octree.cellEnd(coarse[c], c, leaf.level);fine[c]+=half)
+                            {
+                                faceSegments(volume, leaf.level-1, fine, axis, 1-side, _iso, segments);
+                            }
+                        }
+                        closeCrack(segments, _ids, axis, io_mesh);
+                    }
+                }
             }
         }
     }
+}
 
-    std::vector<Triangle>::iterator itr;
-    ngl::Vec3 triNormal;
-    for(itr=allTriangles.begin();itr!=allTriangles.end();++itr)
+template <typename T>
+bool MachingCube::faceSegments(const VolumeView<T> &_volume, unsigned int _level, const unsigned int _start[3],
+                               unsigned int _axis, unsigned int _side, float _iso,
+                               std::vector<std::pair<uint64_t, uint64_t> > &io_segments) const
+{
+    Voxel grid;
+    unsigned int p[8][3];
+    bool below = false, above = false;
+    // the corners on the face first, there is nothing more to do unless they straddle the isolevel
+    for(int pass=0;pass<2;pass++)
+    {
+        for(unsigned int c=0;c<8;c++)
+        {
+            if((cornerOffset[c][_axis] == _side) != (pass == 0))
+                continue;
+            for(unsigned int a=0;a<3;a++)
+            {
+                p[c][a] = cornerOffset[c][a] ? m_octree.cellEnd(_start[a], a, _level) : _start[a];
+            }
+            grid.p[c] = ngl::Vec3(p[c][0], p[c][1], p[c][2]);
+            grid.val[c] = m_octree.value(_volume, p[c]);
+            below = below || grid.val[c] < _iso;
+            above = above || grid.val[c] >= _iso;
+        }
+        if(pass == 0 && !(below && above))
+            return false;
+    }
+    const int cubeindex = computeCubeIndex(grid, _iso);
+    uint64_t keys[12];
+    bool onFace[12];
+    for(int e=0;e<12;e++)
+    {
+        const int c0 = edgeCache[e][0], c1 = edgeCache[e][1];
+        onFace[e] = cornerOffset[c0][_axis] == _side && cornerOffset[c1][_axis] == _side;
+        if(onFace[e] && (edgeTable[cubeindex] & (1<<e)))
+        {
+            unsigned int start[3] = {p[c0][0], p[c0][1], p[c0][2]};
+            unsigned int level = _level;
+            keys[e] = m_octree.edgeKey(start, edgeAxis(e), level);
+        }
+    }
+    for(int t=0;triTable[cubeindex][t]!=-1;t+=3)
     {
-        // two ways to compute the normal, 1. one normal per triangle; 2. each vertex got seperate normal
-        triNormal = computeTriangleNormal(*itr);
-        for(i=0;i<3;i++)
+        for(int v=0;v<3;v++)
         {
-            // pack in the vertex data first
-            d.x=itr->p[i].m_x/volume_depth*2.0-1.0;
-            d.y=itr->p[i].m_y/volume_height*2.0-1.0;
-            d.z=itr->p[i].m_z/volume_width*2.0-1.0;
-            // one normal for all three vertices in the triangle
-            d.nx = triNormal.m_x;
-            d.ny = triNormal.m_y;
-            d.nz = triNormal.m_z;
-            vboMesh.push_back(d);
+            const int e0 = triTable[cubeindex][t+v], e1 = triTable[cubeindex][t+(v+1)%3];
+            if(onFace[e0] && onFace[e1])
+                io_segments.push_back(std::make_pair(keys[e0], keys[e1]));
         }
     }
+    return true;
+}
 
+template <typename T>
+ngl::Vec3 MachingCube::gradient(const SliceWindow<T> &_w, unsigned int _i, unsigned int _j, unsigned int _k) const
+{
+    const unsigned int slot = _i-_w.first;
+    const unsigned int row = _j*volume_width + _k;
+    const T *v = &_w.slice[slot][row];
+    ngl::Vec3 g;
+    // central differences inside the volume, one sided differences on the border
+    if(_i == 0)                     g.m_x = (float)_w.slice[slot+1][row]-v[0];
+    else if(_i == volume_depth-1)   g.m_x = (float)v[0]-_w.slice[slot-1][row];
+    else                            g.m_x = ((float)_w.slice[slot+1][row]-_w.slice[slot-1][row])*0.5;
+    if(_j == 0)                     g.m_y = (float)v[volume_width]-v[0];
+    else if(_j == volume_height-1)  g.m_y = (float)v[0]-v[-(int)volume_width];
+    else                            g.m_y = ((float)v[volume_width]-v[-(int)volume_width])*0.5;
+    if(_k == 0)                     g.m_z = (float)v[1]-v[0];
+    else if(_k == volume_width-1)   g.m_z = (float)v[0]-v[-1];
+    else                            g.m_z = ((float)v[1]-v[-1])*0.5;
+    return g;
+}
 
-    // first we grab an instance of our VOA
-    m_vaoMesh= ngl::VertexArrayObject::createVOA(GL_TRIANGLES);
-    // next we bind it so it's active for setting data
-    m_vaoMesh->bind();
-    unsigned int m_meshSize=vboMesh.size();
-
-    // now we have our data add it to the VAO, we need to tell the VAO the following
-    // how much (in bytes) data we are copying
-    // a pointer to the first element of data (in this case the address of the first element of the
-    // std::vector
-    m_vaoMesh->setData(m_meshSize*sizeof(VertData),vboMesh[0].nx);
-    // in this case we have packed our data in interleaved format as follows
-    // nx,ny,nz,x,y,z
-    // If you look at the shader we have the following attributes being used
-    // attribute vec3 inVert; attribute 0
-    // attribute vec3 inNormal; attribure 1
-    // so we need to set the vertexAttributePointer so the correct size and type as follows
-    // vertex is attribute 0 with x,y,z(3) parts of type GL_FLOAT, our complete packed data is
-    // sizeof(vertData) and the offset into the data structure for the first x component is 3 (nx,ny,nz)..x
-    m_vaoMesh->setVertexAttributePointer(0,3,GL_FLOAT,sizeof(VertData),3);
-    // normal same as vertex only starts at position 2 (u,v)-> nx
-    m_vaoMesh->setVertexAttributePointer(1,3,GL_FLOAT,sizeof(VertData),0);
-
-
-    // now we have set the vertex attributes we tell the VAO class how many indices to draw when
-    // glDrawArrays is called, in this case we use buffSize (but if we wished less of the sphere to be drawn we could
-    // specify less (in steps of 3))
-    m_vaoMesh->setNumIndices(m_meshSize);
-    // finally we have finished for now so time to unbind the VAO
-    m_vaoMesh->unbind();
+template <typename T>
+ngl::Vec3 MachingCube::surfaceNormal(const SliceWindow<T> &_w, const ngl::Vec3 &_p) const
+{
+    // the point is on a voxel edge so at most one of the coordinates has a fractional part,
+    // interpolating between the gradients at the two ends of that edge
+    unsigned int i = std::min((unsigned int)_p.m_x, volume_depth-1);
+    unsigned int j = std::min((unsigned int)_p.m_y, volume_height-1);
+    unsigned int k = std::min((unsigned int)_p.m_z, volume_width-1);
+    ngl::Vec3 g = gradient(_w, i, j, k);
+    float mu;
+    if((mu = _p.m_x-i) > 0.0 && i+1 < volume_depth)
+        g += (gradient(_w, i+1, j, k)-g)*mu;
+    else if((mu = _p.m_y-j) > 0.0 && j+1 < volume_height)
+        g += (gradient(_w, i, j+1, k)-g)*mu;
+    else if((mu = _p.m_z-k) > 0.0 && k+1 < volume_width)
+        g += (gradient(_w, i, j, k+1)-g)*mu;
+    // the inside of the surface has the lower values so the normal points down the gradient
+    if(g.length()>0.0)
+        g.normalize();
+    return -g;
+}
 
-    // indicate we have a vao now
-    m_vao=true;
+void MachingCube::countSlab(unsigned int _begin, unsigned int _end, std::vector<size_t> &_counts)
+{
+    switch(voxelType())
+    {
+        case VoxelType::UINT8 : sweepCount<unsigned char>(slabBox(_begin, _end), _counts); break;
+        case VoxelType::UINT16 : sweepCount<unsigned short>(slabBox(_begin, _end), _counts); break;
+        case VoxelType::FLOAT : sweepCount<float>(slabBox(_begin, _end), _counts); break;
+    }
+}
+
+void MachingCube::extractSlab(unsigned int _begin, unsigned int _end, std::vector<VertData *> &_outs)
+{
+    switch(voxelType())
+    {
+        case VoxelType::UINT8 : sweepSlab<unsigned char>(slabBox(_begin, _end), _outs); break;
+        case VoxelType::UINT16 : sweepSlab<unsigned short>(slabBox(_begin, _end), _outs); break;
+        case VoxelType::FLOAT : sweepSlab<float>(slabBox(_begin, _end), _outs); break;
+    }
+}
+
+void MachingCube::extractSlab(unsigned int _begin, unsigned int _end, std::vector<PackedVertData *> &_outs)
+{
+    switch(voxelType())
+    {
+        case VoxelType::UINT8 : sweepSlab<unsigned char>(slabBox(_begin, _end), _outs); break;
+        case VoxelType::UINT16 : sweepSlab<unsigned short>(slabBox(_begin, _end), _outs); break;
+        case VoxelType::FLOAT : sweepSlab<float>(slabBox(_begin, _end), _outs); break;
+    }
+}
 
-    allTriangles.erase(allTriangles.begin(), allTriangles.end());
+void MachingCube::extractSlabIndexed(unsigned int _begin, unsigned int _end, std::vector<IndexedMesh> &_meshes)
+{
+    if(m_mesher == Mesher::SURFACE_NETS)
+    {
+        switch(voxelType())
+        {
+            case VoxelType::UINT8 : sweepSlabNets<unsigned char>(_begin, _end, _meshes); break;
+            case VoxelType::UINT16 : sweepSlabNets<unsigned short>(_begin, _end, _meshes); break;
+            case VoxelType::FLOAT : sweepSlabNets<float>(_begin, _end, _meshes); break;
+        }
+        return;
+    }
+    switch(voxelType())
+    {
+        case VoxelType::UINT8 : sweepSlabIndexed<unsigned char>(_begin, _end, _meshes); break;
+        case VoxelType::UINT16 : sweepSlabIndexed<unsigned short>(_begin, _end, _meshes); break;
+        case VoxelType::FLOAT : sweepSlabIndexed<float>(_begin, _end, _meshes); break;
+    }
 }
 
-ngl::Vec3 MachingCube::computeTriangleNormal(Triangle &itr)
+ngl::Vec3 MachingCube::computeTriangleNormal(const Triangle &itr) const
 {
     ngl::Vec3 norm, vec1, vec2;
     vec1 = itr.p[1]-itr.p[0];
@@ -256,12 +3138,49 @@ ngl::Vec3 MachingCube::computeTriangleNormal(Triangle &itr)
 //----------------------------------------------------------------------------------------------------------------------
 void MachingCube::draw() const
 {
-    if(m_vao == true)
+    if(currentLod() > 0 && m_lods[m_lod])
+    {
+        m_lods[m_lod]->draw();
+    }
+    else
+    {
+        for(size_t l=0;l<m_meshes.size();l++)
+        {
+            drawGpuMesh(m_meshes[l]);
+        }
+    }
+}
+
+void MachingCube::draw(unsigned int _level) const
+{
+    if(currentLod() > 0 && m_lods[m_lod])
+    {
+        m_lods[m_lod]->draw(_level);
+    }
+    else if(_level < m_meshes.size())
+    {
+        drawGpuMesh(m_meshes[_level]);
+    }
+}
+
+void MachingCube::drawGpuMesh(const GpuMesh &_mesh) const
+{
+    // the buffers are ours rather than the VAO's so we issue the draw ourselves
+    _mesh.vao->bind();
+    if(indexedOutput())
+        glDrawElements(GL_TRIANGLES, _mesh.numIndices, GL_UNSIGNED_INT, 0);
+    else if(!_mesh.chunkFirst.empty())
+        glMultiDrawArrays(GL_TRIANGLES, &_mesh.chunkFirst[0], &_mesh.chunkCount[0], _mesh.chunkFirst.size());
+    else if(_mesh.drawIndirect)
     {
-        m_vaoMesh->bind();
-        m_vaoMesh->draw();
-        m_vaoMesh->unbind();
+        // the vertex count is the one the compute shaders wrote, it never has to come back to us for drawing
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _mesh.indirect);
+        glDrawArraysIndirect(GL_TRIANGLES, 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
     }
+    else
+        glDrawArrays(GL_TRIANGLES, 0, _mesh.numIndices);
+    _mesh.vao->unbind();
 }
 
 // Modified from the code at http://paulbourke.net/geometry/polygonise/
@@ -274,370 +3193,14 @@ void MachingCube::draw() const
    0 will be returned if the grid cell is either totally above
    of totally below the isolevel.
 */
-unsigned int MachingCube::MachingTriangles(Voxel g, float iso, std::vector<Triangle> &triList)
-{
-    /*
-       int edgeTable[256].  It corresponds to the 2^8 possible combinations of
-       of the eight (n) vertices either existing inside or outside (2^n) of the
-       surface.  A vertex is inside of a surface if the value at that vertex is
-       less than that of the surface you are scanning for.  The table index is
-       constructed bitwise with bit 0 corresponding to vertex 0, bit 1 to vert
-       1.. bit 7 to vert 7.  The value in the table tells you which edges of
-       the table are intersected by the surface.  Once again bit 0 corresponds
-       to edge 0 and so on, up to edge 12.
-       Constructing the table simply consisted of having a program run thru
-       the 256 cases and setting the edge bit if the vertices at either end of
-       the edge had different values (one is inside while the other is out).
-       The purpose of the table is to speed up the scanning process.  Only the
-       edges whose bit's are set contain vertices of the surface.
-       Vertex 0 is on the bottom face, back edge, left side.
-       The progression of vertices is clockwise around the bottom face
-       and then clockwise around the top face of the cube.  Edge 0 goes from
-       vertex 0 to vertex 1, Edge 1 is from 2->3 and so on around clockwise to
-       vertex 0 again. Then Edge 4 to 7 make up the top face, 4->5, 5->6, 6->7
-       and 7->4.  Edge 8 thru 11 are the vertical edges from vert 0->4, 1->5,
-       2->6, and 3->7.
-           4--------5     *---4----*
-          /|       /|    /|       /|
-         / |      / |   7 |      5 |
-        /  |     /  |  /  8     /  9
-       7--------6   | *----6---*   |
-       |   |    |   | |   |    |   |
-       |   0----|---1 |   *---0|---*
-       |  /     |  /  11 /     10 /
-       | /      | /   | 3      | 1
-       |/       |/    |/       |/
-       3--------2     *---2----*
-    */
-    static int edgeTable[256]={
-    0x0  , 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c,
-    0x80c, 0x905, 0xa0f, 0xb06, 0xc0a, 0xd03, 0xe09, 0xf00,
-    0x190, 0x99 , 0x393, 0x29a, 0x596, 0x49f, 0x795, 0x69c,
-    0x99c, 0x895, 0xb9f, 0xa96, 0xd9a, 0xc93, 0xf99, 0xe90,
-    0x230, 0x339, 0x33 , 0x13a, 0x636, 0x73f, 0x435, 0x53c,
-    0xa3c, 0xb35, 0x83f, 0x936, 0xe3a, 0xf33, 0xc39, 0xd30,
-    0x3a0, 0x2a9, 0x1a3, 0xaa , 0x7a6, 0x6af, 0x5a5, 0x4ac,
-    0xbac, 0xaa5, 0x9af, 0x8a6, 0xfaa, 0xea3, 0xda9, 0xca0,
-    0x460, 0x569, 0x663, 0x76a, 0x66 , 0x16f, 0x265, 0x36c,
-    0xc6c, 0xd65, 0xe6f, 0xf66, 0x86a, 0x963, 0xa69, 0xb60,
-    0x5f0, 0x4f9, 0x7f3, 0x6fa, 0x1f6, 0xff , 0x3f5, 0x2fc,
-    0xdfc, 0xcf5, 0xfff, 0xef6, 0x9fa, 0x8f3, 0xbf9, 0xaf0,
-    0x650, 0x759, 0x453, 0x55a, 0x256, 0x35f, 0x55 , 0x15c,
-    0xe5c, 0xf55, 0xc5f, 0xd56, 0xa5a, 0xb53, 0x859, 0x950,
-    0x7c0, 0x6c9, 0x5c3, 0x4ca, 0x3c6, 0x2cf, 0x1c5, 0xcc ,
-    0xfcc, 0xec5, 0xdcf, 0xcc6, 0xbca, 0xac3, 0x9c9, 0x8c0,
-    0x8c0, 0x9c9, 0xac3, 0xbca, 0xcc6, 0xdcf, 0xec5, 0xfcc,
-    0xcc , 0x1c5, 0x2cf, 0x3c6, 0x4ca, 0x5c3, 0x6c9, 0x7c0,
-    0x950, 0x859, 0xb53, 0xa5a, 0xd56, 0xc5f, 0xf55, 0xe5c,
-    0x15c, 0x55 , 0x35f, 0x256, 0x55a, 0x453, 0x759, 0x650,
-    0xaf0, 0xbf9, 0x8f3, 0x9fa, 0xef6, 0xfff, 0xcf5, 0xdfc,
-    0x2fc, 0x3f5, 0xff , 0x1f6, 0x6fa, 0x7f3, 0x4f9, 0x5f0,
-    0xb60, 0xa69, 0x963, 0x86a, 0xf66, 0xe6f, 0xd65, 0xc6c,
-    0x36c, 0x265, 0x16f, 0x66 , 0x76a, 0x663, 0x569, 0x460,
-    0xca0, 0xda9, 0xea3, 0xfaa, 0x8a6, 0x9af, 0xaa5, 0xbac,
-    0x4ac, 0x5a5, 0x6af, 0x7a6, 0xaa , 0x1a3, 0x2a9, 0x3a0,
-    0xd30, 0xc39, 0xf33, 0xe3a, 0x936, 0x83f, 0xb35, 0xa3c,
-    0x53c, 0x435, 0x73f, 0x636, 0x13a, 0x33 , 0x339, 0x230,
-    0xe90, 0xf99, 0xc93, 0xd9a, 0xa96, 0xb9f, 0x895, 0x99c,
-    0x69c, 0x795, 0x49f, 0x596, 0x29a, 0x393, 0x99 , 0x190,
-    0xf00, 0xe09, 0xd03, 0xc0a, 0xb06, 0xa0f, 0x905, 0x80c,
-    0x70c, 0x605, 0x50f, 0x406, 0x30a, 0x203, 0x109, 0x0   };
-
-    /*
-       int triTable[256][16] also corresponds to the 256 possible combinations
-       of vertices.
-       The [16] dimension of the table is again the list of edges of the cube
-       which are intersected by the surface.  This time however, the edges are
-       enumerated in the order of the vertices making up the triangle mesh of
-       the surface.  Each edge contains one vertex that is on the surface.
-       Each triple of edges listed in the table contains the vertices of one
-       triangle on the mesh.  The are 16 entries because it has been shown that
-       there are at most 5 triangles in a cube and each "edge triple" list is
-       terminated with the value -1.
-       For example triTable[3] contains
-       {1, 8, 3, 9, 8, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}
-       This corresponds to the case of a cube whose vertex 0 and 1 are inside
-       of the surface and the rest of the verts are outside (00000001 bitwise
-       OR'ed with 00000010 makes 00000011 == 3).  Therefore, this cube is
-       intersected by the surface roughly in the form of a plane which cuts
-       edges 8,9,1 and 3.  This quadrilateral can be constructed from two
-       triangles: one which is made of the intersection vertices found on edges
-       1,8, and 3; the other is formed from the vertices on edges 9,8, and 1.
-       Remember, each intersected edge contains only one surface vertex.  The
-       vertex triples are listed in counter clockwise order for proper facing.
-    */
-    static int triTable[256][16] =
-    {{-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {0, 1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {1, 8, 3, 9, 8, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {0, 8, 3, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {9, 2, 10, 0, 2, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {2, 8, 3, 2, 10, 8, 10, 9, 8, -1, -1, -1, -1, -1, -1, -1},
-    {3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {0, 11, 2, 8, 11, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {1, 9, 0, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {1, 11, 2, 1, 9, 11, 9, 8, 11, -1, -1, -1, -1, -1, -1, -1},
-    {3, 10, 1, 11, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {0, 10, 1, 0, 8, 10, 8, 11, 10, -1, -1, -1, -1, -1, -1, -1},
-    {3, 9, 0, 3, 11, 9, 11, 10, 9, -1, -1, -1, -1, -1, -1, -1},
-    {9, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {4, 3, 0, 7, 3, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {0, 1, 9, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {4, 1, 9, 4, 7, 1, 7, 3, 1, -1, -1, -1, -1, -1, -1, -1},
-    {1, 2, 10, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {3, 4, 7, 3, 0, 4, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1},
-    {9, 2, 10, 9, 0, 2, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1},
-    {2, 10, 9, 2, 9, 7, 2, 7, 3, 7, 9, 4, -1, -1, -1, -1},
-    {8, 4, 7, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {11, 4, 7, 11, 2, 4, 2, 0, 4, -1, -1, -1, -1, -1, -1, -1},
-    {9, 0, 1, 8, 4, 7, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1},
-    {4, 7, 11, 9, 4, 11, 9, 11, 2, 9, 2, 1, -1, -1, -1, -1},
-    {3, 10, 1, 3, 11, 10, 7, 8, 4, -1, -1, -1, -1, -1, -1, -1},
-    {1, 11, 10, 1, 4, 11, 1, 0, 4, 7, 11, 4, -1, -1, -1, -1},
-    {4, 7, 8, 9, 0, 11, 9, 11, 10, 11, 0, 3, -1, -1, -1, -1},
-    {4, 7, 11, 4, 11, 9, 9, 11, 10, -1, -1, -1, -1, -1, -1, -1},
-    {9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {9, 5, 4, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {0, 5, 4, 1, 5, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {8, 5, 4, 8, 3, 5, 3, 1, 5, -1, -1, -1, -1, -1, -1, -1},
-    {1, 2, 10, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {3, 0, 8, 1, 2, 10, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1},
-    {5, 2, 10, 5, 4, 2, 4, 0, 2, -1, -1, -1, -1, -1, -1, -1},
-    {2, 10, 5, 3, 2, 5, 3, 5, 4, 3, 4, 8, -1, -1, -1, -1},
-    {9, 5, 4, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {0, 11, 2, 0, 8, 11, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1},
-    {0, 5, 4, 0, 1, 5, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1},
-    {2, 1, 5, 2, 5, 8, 2, 8, 11, 4, 8, 5, -1, -1, -1, -1},
-    {10, 3, 11, 10, 1, 3, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1},
-    {4, 9, 5, 0, 8, 1, 8, 10, 1, 8, 11, 10, -1, -1, -1, -1},
-    {5, 4, 0, 5, 0, 11, 5, 11, 10, 11, 0, 3, -1, -1, -1, -1},
-    {5, 4, 8, 5, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1},
-    {9, 7, 8, 5, 7, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {9, 3, 0, 9, 5, 3, 5, 7, 3, -1, -1, -1, -1, -1, -1, -1},
-    {0, 7, 8, 0, 1, 7, 1, 5, 7, -1, -1, -1, -1, -1, -1, -1},
-    {1, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {9, 7, 8, 9, 5, 7, 10, 1, 2, -1, -1, -1, -1, -1, -1, -1},
-    {10, 1, 2, 9, 5, 0, 5, 3, 0, 5, 7, 3, -1, -1, -1, -1},
-    {8, 0, 2, 8, 2, 5, 8, 5, 7, 10, 5, 2, -1, -1, -1, -1},
-    {2, 10, 5, 2, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1},
-    {7, 9, 5, 7, 8, 9, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1},
-    {9, 5, 7, 9, 7, 2, 9, 2, 0, 2, 7, 11, -1, -1, -1, -1},
-    {2, 3, 11, 0, 1, 8, 1, 7, 8, 1, 5, 7, -1, -1, -1, -1},
-    {11, 2, 1, 11, 1, 7, 7, 1, 5, -1, -1, -1, -1, -1, -1, -1},
-    {9, 5, 8, 8, 5, 7, 10, 1, 3, 10, 3, 11, -1, -1, -1, -1},
-    {5, 7, 0, 5, 0, 9, 7, 11, 0, 1, 0, 10, 11, 10, 0, -1},
-    {11, 10, 0, 11, 0, 3, 10, 5, 0, 8, 0, 7, 5, 7, 0, -1},
-    {11, 10, 5, 7, 11, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {0, 8, 3, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {9, 0, 1, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {1, 8, 3, 1, 9, 8, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1},
-    {1, 6, 5, 2, 6, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {1, 6, 5, 1, 2, 6, 3, 0, 8, -1, -1, -1, -1, -1, -1, -1},
-    {9, 6, 5, 9, 0, 6, 0, 2, 6, -1, -1, -1, -1, -1, -1, -1},
-    {5, 9, 8, 5, 8, 2, 5, 2, 6, 3, 2, 8, -1, -1, -1, -1},
-    {2, 3, 11, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {11, 0, 8, 11, 2, 0, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1},
-    {0, 1, 9, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1},
-    {5, 10, 6, 1, 9, 2, 9, 11, 2, 9, 8, 11, -1, -1, -1, -1},
-    {6, 3, 11, 6, 5, 3, 5, 1, 3, -1, -1, -1, -1, -1, -1, -1},
-    {0, 8, 11, 0, 11, 5, 0, 5, 1, 5, 11, 6, -1, -1, -1, -1},
-    {3, 11, 6, 0, 3, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1},
-    {6, 5, 9, 6, 9, 11, 11, 9, 8, -1, -1, -1, -1, -1, -1, -1},
-    {5, 10, 6, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {4, 3, 0, 4, 7, 3, 6, 5, 10, -1, -1, -1, -1, -1, -1, -1},
-    {1, 9, 0, 5, 10, 6, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1},
-    {10, 6, 5, 1, 9, 7, 1, 7, 3, 7, 9, 4, -1, -1, -1, -1},
-    {6, 1, 2, 6, 5, 1, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1},
-    {1, 2, 5, 5, 2, 6, 3, 0, 4, 3, 4, 7, -1, -1, -1, -1},
-    {8, 4, 7, 9, 0, 5, 0, 6, 5, 0, 2, 6, -1, -1, -1, -1},
-    {7, 3, 9, 7, 9, 4, 3, 2, 9, 5, 9, 6, 2, 6, 9, -1},
-    {3, 11, 2, 7, 8, 4, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1},
-    {5, 10, 6, 4, 7, 2, 4, 2, 0, 2, 7, 11, -1, -1, -1, -1},
-    {0, 1, 9, 4, 7, 8, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1},
-    {9, 2, 1, 9, 11, 2, 9, 4, 11, 7, 11, 4, 5, 10, 6, -1},
-    {8, 4, 7, 3, 11, 5, 3, 5, 1, 5, 11, 6, -1, -1, -1, -1},
-    {5, 1, 11, 5, 11, 6, 1, 0, 11, 7, 11, 4, 0, 4, 11, -1},
-    {0, 5, 9, 0, 6, 5, 0, 3, 6, 11, 6, 3, 8, 4, 7, -1},
-    {6, 5, 9, 6, 9, 11, 4, 7, 9, 7, 11, 9, -1, -1, -1, -1},
-    {10, 4, 9, 6, 4, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {4, 10, 6, 4, 9, 10, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1},
-    {10, 0, 1, 10, 6, 0, 6, 4, 0, -1, -1, -1, -1, -1, -1, -1},
-    {8, 3, 1, 8, 1, 6, 8, 6, 4, 6, 1, 10, -1, -1, -1, -1},
-    {1, 4, 9, 1, 2, 4, 2, 6, 4, -1, -1, -1, -1, -1, -1, -1},
-    {3, 0, 8, 1, 2, 9, 2, 4, 9, 2, 6, 4, -1, -1, -1, -1},
-    {0, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {8, 3, 2, 8, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1},
-    {10, 4, 9, 10, 6, 4, 11, 2, 3, -1, -1, -1, -1, -1, -1, -1},
-    {0, 8, 2, 2, 8, 11, 4, 9, 10, 4, 10, 6, -1, -1, -1, -1},
-    {3, 11, 2, 0, 1, 6, 0, 6, 4, 6, 1, 10, -1, -1, -1, -1},
-    {6, 4, 1, 6, 1, 10, 4, 8, 1, 2, 1, 11, 8, 11, 1, -1},
-    {9, 6, 4, 9, 3, 6, 9, 1, 3, 11, 6, 3, -1, -1, -1, -1},
-    {8, 11, 1, 8, 1, 0, 11, 6, 1, 9, 1, 4, 6, 4, 1, -1},
-    {3, 11, 6, 3, 6, 0, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1},
-    {6, 4, 8, 11, 6, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {7, 10, 6, 7, 8, 10, 8, 9, 10, -1, -1, -1, -1, -1, -1, -1},
-    {0, 7, 3, 0, 10, 7, 0, 9, 10, 6, 7, 10, -1, -1, -1, -1},
-    {10, 6, 7, 1, 10, 7, 1, 7, 8, 1, 8, 0, -1, -1, -1, -1},
-    {10, 6, 7, 10, 7, 1, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1},
-    {1, 2, 6, 1, 6, 8, 1, 8, 9, 8, 6, 7, -1, -1, -1, -1},
-    {2, 6, 9, 2, 9, 1, 6, 7, 9, 0, 9, 3, 7, 3, 9, -1},
-    {7, 8, 0, 7, 0, 6, 6, 0, 2, -1, -1, -1, -1, -1, -1, -1},
-    {7, 3, 2, 6, 7, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {2, 3, 11, 10, 6, 8, 10, 8, 9, 8, 6, 7, -1, -1, -1, -1},
-    {2, 0, 7, 2, 7, 11, 0, 9, 7, 6, 7, 10, 9, 10, 7, -1},
-    {1, 8, 0, 1, 7, 8, 1, 10, 7, 6, 7, 10, 2, 3, 11, -1},
-    {11, 2, 1, 11, 1, 7, 10, 6, 1, 6, 7, 1, -1, -1, -1, -1},
-    {8, 9, 6, 8, 6, 7, 9, 1, 6, 11, 6, 3, 1, 3, 6, -1},
-    {0, 9, 1, 11, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {7, 8, 0, 7, 0, 6, 3, 11, 0, 11, 6, 0, -1, -1, -1, -1},
-    {7, 11, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {3, 0, 8, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {0, 1, 9, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {8, 1, 9, 8, 3, 1, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1},
-    {10, 1, 2, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {1, 2, 10, 3, 0, 8, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1},
-    {2, 9, 0, 2, 10, 9, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1},
-    {6, 11, 7, 2, 10, 3, 10, 8, 3, 10, 9, 8, -1, -1, -1, -1},
-    {7, 2, 3, 6, 2, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {7, 0, 8, 7, 6, 0, 6, 2, 0, -1, -1, -1, -1, -1, -1, -1},
-    {2, 7, 6, 2, 3, 7, 0, 1, 9, -1, -1, -1, -1, -1, -1, -1},
-    {1, 6, 2, 1, 8, 6, 1, 9, 8, 8, 7, 6, -1, -1, -1, -1},
-    {10, 7, 6, 10, 1, 7, 1, 3, 7, -1, -1, -1, -1, -1, -1, -1},
-    {10, 7, 6, 1, 7, 10, 1, 8, 7, 1, 0, 8, -1, -1, -1, -1},
-    {0, 3, 7, 0, 7, 10, 0, 10, 9, 6, 10, 7, -1, -1, -1, -1},
-    {7, 6, 10, 7, 10, 8, 8, 10, 9, -1, -1, -1, -1, -1, -1, -1},
-    {6, 8, 4, 11, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {3, 6, 11, 3, 0, 6, 0, 4, 6, -1, -1, -1, -1, -1, -1, -1},
-    {8, 6, 11, 8, 4, 6, 9, 0, 1, -1, -1, -1, -1, -1, -1, -1},
-    {9, 4, 6, 9, 6, 3, 9, 3, 1, 11, 3, 6, -1, -1, -1, -1},
-    {6, 8, 4, 6, 11, 8, 2, 10, 1, -1, -1, -1, -1, -1, -1, -1},
-    {1, 2, 10, 3, 0, 11, 0, 6, 11, 0, 4, 6, -1, -1, -1, -1},
-    {4, 11, 8, 4, 6, 11, 0, 2, 9, 2, 10, 9, -1, -1, -1, -1},
-    {10, 9, 3, 10, 3, 2, 9, 4, 3, 11, 3, 6, 4, 6, 3, -1},
-    {8, 2, 3, 8, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1},
-    {0, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {1, 9, 0, 2, 3, 4, 2, 4, 6, 4, 3, 8, -1, -1, -1, -1},
-    {1, 9, 4, 1, 4, 2, 2, 4, 6, -1, -1, -1, -1, -1, -1, -1},
-    {8, 1, 3, 8, 6, 1, 8, 4, 6, 6, 10, 1, -1, -1, -1, -1},
-    {10, 1, 0, 10, 0, 6, 6, 0, 4, -1, -1, -1, -1, -1, -1, -1},
-    {4, 6, 3, 4, 3, 8, 6, 10, 3, 0, 3, 9, 10, 9, 3, -1},
-    {10, 9, 4, 6, 10, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {4, 9, 5, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {0, 8, 3, 4, 9, 5, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1},
-    {5, 0, 1, 5, 4, 0, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1},
-    {11, 7, 6, 8, 3, 4, 3, 5, 4, 3, 1, 5, -1, -1, -1, -1},
-    {9, 5, 4, 10, 1, 2, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1},
-    {6, 11, 7, 1, 2, 10, 0, 8, 3, 4, 9, 5, -1, -1, -1, -1},
-    {7, 6, 11, 5, 4, 10, 4, 2, 10, 4, 0, 2, -1, -1, -1, -1},
-    {3, 4, 8, 3, 5, 4, 3, 2, 5, 10, 5, 2, 11, 7, 6, -1},
-    {7, 2, 3, 7, 6, 2, 5, 4, 9, -1, -1, -1, -1, -1, -1, -1},
-    {9, 5, 4, 0, 8, 6, 0, 6, 2, 6, 8, 7, -1, -1, -1, -1},
-    {3, 6, 2, 3, 7, 6, 1, 5, 0, 5, 4, 0, -1, -1, -1, -1},
-    {6, 2, 8, 6, 8, 7, 2, 1, 8, 4, 8, 5, 1, 5, 8, -1},
-    {9, 5, 4, 10, 1, 6, 1, 7, 6, 1, 3, 7, -1, -1, -1, -1},
-    {1, 6, 10, 1, 7, 6, 1, 0, 7, 8, 7, 0, 9, 5, 4, -1},
-    {4, 0, 10, 4, 10, 5, 0, 3, 10, 6, 10, 7, 3, 7, 10, -1},
-    {7, 6, 10, 7, 10, 8, 5, 4, 10, 4, 8, 10, -1, -1, -1, -1},
-    {6, 9, 5, 6, 11, 9, 11, 8, 9, -1, -1, -1, -1, -1, -1, -1},
-    {3, 6, 11, 0, 6, 3, 0, 5, 6, 0, 9, 5, -1, -1, -1, -1},
-    {0, 11, 8, 0, 5, 11, 0, 1, 5, 5, 6, 11, -1, -1, -1, -1},
-    {6, 11, 3, 6, 3, 5, 5, 3, 1, -1, -1, -1, -1, -1, -1, -1},
-    {1, 2, 10, 9, 5, 11, 9, 11, 8, 11, 5, 6, -1, -1, -1, -1},
-    {0, 11, 3, 0, 6, 11, 0, 9, 6, 5, 6, 9, 1, 2, 10, -1},
-    {11, 8, 5, 11, 5, 6, 8, 0, 5, 10, 5, 2, 0, 2, 5, -1},
-    {6, 11, 3, 6, 3, 5, 2, 10, 3, 10, 5, 3, -1, -1, -1, -1},
-    {5, 8, 9, 5, 2, 8, 5, 6, 2, 3, 8, 2, -1, -1, -1, -1},
-    {9, 5, 6, 9, 6, 0, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1},
-    {1, 5, 8, 1, 8, 0, 5, 6, 8, 3, 8, 2, 6, 2, 8, -1},
-    {1, 5, 6, 2, 1, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {1, 3, 6, 1, 6, 10, 3, 8, 6, 5, 6, 9, 8, 9, 6, -1},
-    {10, 1, 0, 10, 0, 6, 9, 5, 0, 5, 6, 0, -1, -1, -1, -1},
-    {0, 3, 8, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {10, 5, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {11, 5, 10, 7, 5, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {11, 5, 10, 11, 7, 5, 8, 3, 0, -1, -1, -1, -1, -1, -1, -1},
-    {5, 11, 7, 5, 10, 11, 1, 9, 0, -1, -1, -1, -1, -1, -1, -1},
-    {10, 7, 5, 10, 11, 7, 9, 8, 1, 8, 3, 1, -1, -1, -1, -1},
-    {11, 1, 2, 11, 7, 1, 7, 5, 1, -1, -1, -1, -1, -1, -1, -1},
-    {0, 8, 3, 1, 2, 7, 1, 7, 5, 7, 2, 11, -1, -1, -1, -1},
-    {9, 7, 5, 9, 2, 7, 9, 0, 2, 2, 11, 7, -1, -1, -1, -1},
-    {7, 5, 2, 7, 2, 11, 5, 9, 2, 3, 2, 8, 9, 8, 2, -1},
-    {2, 5, 10, 2, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1},
-    {8, 2, 0, 8, 5, 2, 8, 7, 5, 10, 2, 5, -1, -1, -1, -1},
-    {9, 0, 1, 5, 10, 3, 5, 3, 7, 3, 10, 2, -1, -1, -1, -1},
-    {9, 8, 2, 9, 2, 1, 8, 7, 2, 10, 2, 5, 7, 5, 2, -1},
-    {1, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {0, 8, 7, 0, 7, 1, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1},
-    {9, 0, 3, 9, 3, 5, 5, 3, 7, -1, -1, -1, -1, -1, -1, -1},
-    {9, 8, 7, 5, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {5, 8, 4, 5, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1},
-    {5, 0, 4, 5, 11, 0, 5, 10, 11, 11, 3, 0, -1, -1, -1, -1},
-    {0, 1, 9, 8, 4, 10, 8, 10, 11, 10, 4, 5, -1, -1, -1, -1},
-    {10, 11, 4, 10, 4, 5, 11, 3, 4, 9, 4, 1, 3, 1, 4, -1},
-    {2, 5, 1, 2, 8, 5, 2, 11, 8, 4, 5, 8, -1, -1, -1, -1},
-    {0, 4, 11, 0, 11, 3, 4, 5, 11, 2, 11, 1, 5, 1, 11, -1},
-    {0, 2, 5, 0, 5, 9, 2, 11, 5, 4, 5, 8, 11, 8, 5, -1},
-    {9, 4, 5, 2, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {2, 5, 10, 3, 5, 2, 3, 4, 5, 3, 8, 4, -1, -1, -1, -1},
-    {5, 10, 2, 5, 2, 4, 4, 2, 0, -1, -1, -1, -1, -1, -1, -1},
-    {3, 10, 2, 3, 5, 10, 3, 8, 5, 4, 5, 8, 0, 1, 9, -1},
-    {5, 10, 2, 5, 2, 4, 1, 9, 2, 9, 4, 2, -1, -1, -1, -1},
-    {8, 4, 5, 8, 5, 3, 3, 5, 1, -1, -1, -1, -1, -1, -1, -1},
-    {0, 4, 5, 1, 0, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {8, 4, 5, 8, 5, 3, 9, 0, 5, 0, 3, 5, -1, -1, -1, -1},
-    {9, 4, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {4, 11, 7, 4, 9, 11, 9, 10, 11, -1, -1, -1, -1, -1, -1, -1},
-    {0, 8, 3, 4, 9, 7, 9, 11, 7, 9, 10, 11, -1, -1, -1, -1},
-    {1, 10, 11, 1, 11, 4, 1, 4, 0, 7, 4, 11, -1, -1, -1, -1},
-    {3, 1, 4, 3, 4, 8, 1, 10, 4, 7, 4, 11, 10, 11, 4, -1},
-    {4, 11, 7, 9, 11, 4, 9, 2, 11, 9, 1, 2, -1, -1, -1, -1},
-    {9, 7, 4, 9, 11, 7, 9, 1, 11, 2, 11, 1, 0, 8, 3, -1},
-    {11, 7, 4, 11, 4, 2, 2, 4, 0, -1, -1, -1, -1, -1, -1, -1},
-    {11, 7, 4, 11, 4, 2, 8, 3, 4, 3, 2, 4, -1, -1, -1, -1},
-    {2, 9, 10, 2, 7, 9, 2, 3, 7, 7, 4, 9, -1, -1, -1, -1},
-    {9, 10, 7, 9, 7, 4, 10, 2, 7, 8, 7, 0, 2, 0, 7, -1},
-    {3, 7, 10, 3, 10, 2, 7, 4, 10, 1, 10, 0, 4, 0, 10, -1},
-    {1, 10, 2, 8, 7, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {4, 9, 1, 4, 1, 7, 7, 1, 3, -1, -1, -1, -1, -1, -1, -1},
-    {4, 9, 1, 4, 1, 7, 0, 8, 1, 8, 7, 1, -1, -1, -1, -1},
-    {4, 0, 3, 7, 4, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {4, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {9, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {3, 0, 9, 3, 9, 11, 11, 9, 10, -1, -1, -1, -1, -1, -1, -1},
-    {0, 1, 10, 0, 10, 8, 8, 10, 11, -1, -1, -1, -1, -1, -1, -1},
-    {3, 1, 10, 11, 3, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {1, 2, 11, 1, 11, 9, 9, 11, 8, -1, -1, -1, -1, -1, -1, -1},
-    {3, 0, 9, 3, 9, 11, 1, 2, 9, 2, 11, 9, -1, -1, -1, -1},
-    {0, 2, 11, 8, 0, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {3, 2, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {2, 3, 8, 2, 8, 10, 10, 8, 9, -1, -1, -1, -1, -1, -1, -1},
-    {9, 10, 2, 0, 9, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {2, 3, 8, 2, 8, 10, 0, 1, 8, 1, 10, 8, -1, -1, -1, -1},
-    {1, 10, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {1, 3, 8, 9, 1, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {0, 9, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {0, 3, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
-    {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}};
-
+unsigned int MachingCube::MachingTriangles(const Voxel &g, float iso, Triangle *triangles) const
+{
     int i,ntri = 0;
     int cubeindex;
     ngl::Vec3 vertlist[12];
     // Determine the index into the edge table which tells us which vertices are inside of the surface
 
-    cubeindex = 0;
-    if (g.val[0] < iso) cubeindex |= 1;
-    if (g.val[1] < iso) cubeindex |= 2;
-    if (g.val[2] < iso) cubeindex |= 4;
-    if (g.val[3] < iso) cubeindex |= 8;
-    if (g.val[4] < iso) cubeindex |= 16;
-    if (g.val[5] < iso) cubeindex |= 32;
-    if (g.val[6] < iso) cubeindex |= 64;
-    if (g.val[7] < iso) cubeindex |= 128;
+    cubeindex = computeCubeIndex(g, iso);
 
    /* Cube is entirely in/out of the surface */
     if (edgeTable[cubeindex] == 0)
@@ -681,25 +3244,29 @@ unsigned int MachingCube::MachingTriangles(Voxel g, float iso, std::vector<Trian
       vertlist[11] = VertexInterp(iso,g.p[3],g.p[7],g.val[3],g.val[7]);
    }
 
-    Triangle tri;
     /* Create the triangles */
     for (i=0;triTable[cubeindex][i]!=-1;i+=3)
     {
+        Triangle &tri = triangles[ntri];
         tri.p[0] = vertlist[triTable[cubeindex][i  ]];
         tri.p[1] = vertlist[triTable[cubeindex][i+1]];
         tri.p[2] = vertlist[triTable[cubeindex][i+2]];
-        triList.push_back(tri);
         ntri++;
     }
 
     return(ntri);
 }
 
+unsigned int MachingCube::triangleCount(int _cubeindex)
+{
+    return s_triangleCount.count[_cubeindex];
+}
+
 /*-------------------------------------------------------------------------
    Return the point between two points in the same ratio as
    isolevel is between valp1 and valp2
 */
-ngl::Vec3 MachingCube::VertexInterp(float isolevel, ngl::Vec3 p1, ngl::Vec3 p2, float valp1, float valp2)
+ngl::Vec3 MachingCube::VertexInterp(float isolevel, const ngl::Vec3 &p1, const ngl::Vec3 &p2, float valp1, float valp2) const
 {
     float       mu;
     ngl::Vec3   p;
@@ -0,0 +1,135 @@
+#include "MeshCache.h"
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#ifndef WIN32
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file MeshCache.cpp
+/// @brief binary cache file of an extracted mesh
+//----------------------------------------------------------------------------------------------------------------------
+
+// bump the version whenever the vertex layout or the output of the extraction changes
+static const char s_magic[8] = {'M','C','M','E','S','H','0','2'};
+
+MeshCache::MeshCache()
+{
+    m_data = 0;
+    m_size = 0;
+    m_vertBytes = 0;
+    m_indexBytes = 0;
+}
+
+MeshCache::~MeshCache()
+{
+    close();
+}
+
+uint64_t MeshCache::hash(const void *_data, size_t _size, uint64_t _hash)
+{
+    const unsigned char *p = static_cast<const unsigned char *>(_data);
+    for(size_t i=0;i<_size;i++)
+    {
+        _hash = (_hash ^ p[i])*1099511628211ull;
+    }
+    return _hash;
+}
+
+std::string MeshCache::fileName(const std::string &_volume, const MeshCacheKey &_key)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), ".%016llx.mesh", (unsigned long long)hash(&_key, sizeof(MeshCacheKey)));
+    return _volume.substr(0, _volume.find_last_of('.'))+name;
+}
+
+bool MeshCache::write(const std::string &_file, const MeshCacheKey &_key, const void *_verts, size_t _vertBytes,
+                      const void *_indices, size_t _indexBytes)
+{
+    unsigned char header[HeaderSize];
+    std::memset(header, 0, HeaderSize);
+    uint64_t sizes[2] = {_vertBytes, _indexBytes};
+    std::memcpy(header, s_magic, sizeof(s_magic));
+    std::memcpy(header+sizeof(s_magic), &_key, sizeof(MeshCacheKey));
+    std::memcpy(header+sizeof(s_magic)+sizeof(MeshCacheKey), sizes, sizeof(sizes));
+
+    std::string temp = _file+".tmp";
+    std::ofstream out(temp.c_str(), std::ofstream::binary);
+    out.write(reinterpret_cast<const char *>(header), HeaderSize);
+    out.write(static_cast<const char *>(_verts), _vertBytes);
+    out.write(static_cast<const char *>(_indices), _indexBytes);
+    out.close();
+    if(!out.good() || std::rename(temp.c_str(), _file.c_str()) != 0)
+    {
+        std::cout<<"can't write the mesh cache "<<_file<<"\n";
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool MeshCache::open(const std::string &_file, const MeshCacheKey &_key)
+{
+    close();
+#ifndef WIN32
+    int fd = ::open(_file.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    fstat(fd, &st);
+    size_t size = st.st_size;
+    void *map = size >= HeaderSize ? mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    // the mapping keeps the file open for us
+    ::close(fd);
+    if(map == MAP_FAILED)
+        return false;
+    m_data = static_cast<const unsigned char *>(map);
+#else
+    std::ifstream in(_file.c_str(), std::ifstream::binary);
+    if (in.is_open() != true)
+        return false;
+    m_buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    size_t size = m_buffer.size();
+    if(size < HeaderSize)
+    {
+        m_buffer.clear();
+        return false;
+    }
+    m_data = &m_buffer[0];
+#endif
+    m_size = size;
+
+    uint64_t sizes[2];
+    std::memcpy(sizes, m_data+sizeof(s_magic)+sizeof(MeshCacheKey), sizeof(sizes));
+    if(std::memcmp(m_data, s_magic, sizeof(s_magic)) != 0 ||
+       std::memcmp(m_data+sizeof(s_magic), &_key, sizeof(MeshCacheKey)) != 0 ||
+       HeaderSize+sizes[0]+sizes[1] != m_size)
+    {
+        std::cout<<"mesh cache "<<_file<<" doesn't match, ignoring it\n";
+        close();
+        return false;
+    }
+    m_vertBytes = sizes[0];
+    m_indexBytes = sizes[1];
+    return true;
+}
+
+void MeshCache::close()
+{
+#ifndef WIN32
+    if(m_data != 0)
+        munmap(const_cast<unsigned char *>(m_data), m_size);
+#endif
+    std::vector<unsigned char>().swap(m_buffer);
+    m_data = 0;
+    m_size = 0;
+    m_vertBytes = 0;
+    m_indexBytes = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
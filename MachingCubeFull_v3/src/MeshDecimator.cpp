@@ -0,0 +1,594 @@
+#include "MeshDecimator.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file MeshDecimator.cpp
+/// @brief vertex welding and quadric error decimation of the indexed mesh
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace
+{
+struct Vec3d
+{
+    double x, y, z;
+};
+
+Vec3d operator-(const Vec3d &_a, const Vec3d &_b)
+{
+    Vec3d r = {_a.x-_b.x, _a.y-_b.y, _a.z-_b.z};
+    return r;
+}
+
+Vec3d cross(const Vec3d &_a, const Vec3d &_b)
+{
+    Vec3d r = {_a.y*_b.z-_a.z*_b.y, _a.z*_b.x-_a.x*_b.z, _a.x*_b.y-_a.y*_b.x};
+    return r;
+}
+
+double dot(const Vec3d &_a, const Vec3d &_b)
+{
+    return _a.x*_b.x+_a.y*_b.y+_a.z*_b.z;
+}
+
+// the symmetric 4x4 matrix summing the squared distances to a set of planes, stored as its upper triangle
+struct Quadric
+{
+    double q[10];   // aa ab ac ad bb bc bd cc cd dd
+
+    Quadric() {std::fill(q, q+10, 0.0);}
+    void addPlane(double _a, double _b, double _c, double _d)
+    {
+        q[0]+=_a*_a; q[1]+=_a*_b; q[2]+=_a*_c; q[3]+=_a*_d;
+        q[4]+=_b*_b; q[5]+=_b*_c; q[6]+=_b*_d;
+        q[7]+=_c*_c; q[8]+=_c*_d;
+        q[9]+=_d*_d;
+    }
+    Quadric operator+(const Quadric &_o) const
+    {
+        Quadric r;
+        for(int i=0;i<10;i++)
+            r.q[i] = q[i]+_o.q[i];
+        return r;
+    }
+    double error(const Vec3d &_p) const
+    {
+        const double e = q[0]*_p.x*_p.x + 2.0*q[1]*_p.x*_p.y + 2.0*q[2]*_p.x*_p.z + 2.0*q[3]*_p.x
+                       + q[4]*_p.y*_p.y + 2.0*q[5]*_p.y*_p.z + 2.0*q[6]*_p.y
+                       + q[7]*_p.z*_p.z + 2.0*q[8]*_p.z
+                       + q[9];
+        // rounding can take a perfect fit just below zero
+        return std::max(0.0, e);
+    }
+    // the point of least error, false if the planes don't pin one down (flat or creased areas)
+    bool optimum(Vec3d &_p) const
+    {
+        const double a = q[0], b = q[1], c = q[2], d = q[4], e = q[5], f = q[7];
+        const double c0 = d*f-e*e, c1 = c*e-b*f, c2 = b*e-c*d;
+        const double det = a*c0+b*c1+c*c2;
+        const double trace = a+d+f;
+        if(std::fabs(det) <= 1e-6*trace*trace*trace)
+            return false;
+        // A p = -(ad, bd, cd) by Cramer's rule, A being symmetric its cofactors are its adjugate
+        const double rx = -q[3], ry = -q[6], rz = -q[8];
+        _p.x = (c0*rx + c1*ry + c2*rz)/det;
+        _p.y = (c1*rx + (a*f-c*c)*ry + (b*c-a*e)*rz)/det;
+        _p.z = (c2*rx + (b*c-a*e)*ry + (a*d-b*b)*rz)/det;
+        return true;
+    }
+};
+
+// a possible collapse of drop into keep, out of date once either end has changed since it was made
+struct Collapse
+{
+    double   cost;
+    GLuint   keep;
+    GLuint   drop;
+    unsigned keepStamp;
+    unsigned dropStamp;
+
+    bool operator>(const Collapse &_o) const {return cost > _o.cost;}
+};
+
+// welding key, the exact bits of the position
+struct PositionKey
+{
+    uint32_t bits[3];
+
+    bool operator==(const PositionKey &_o) const
+    {
+        return bits[0] == _o.bits[0] && bits[1] == _o.bits[1] && bits[2] == _o.bits[2];
+    }
+};
+
+struct PositionHash
+{
+    size_t operator()(const PositionKey &_k) const
+    {
+        uint64_t h = _k.bits[0]*0x9e3779b97f4a7c15ull;
+        h = (h ^ _k.bits[1])*0x9e3779b97f4a7c15ull;
+        h = (h ^ _k.bits[2])*0x9e3779b97f4a7c15ull;
+        return h ^ (h >> 29);
+    }
+};
+}
+
+MeshDecimator::Stats MeshDecimator::process(std::vector<IndexedMesh> &io_parts, IndexedMesh &_out, size_t _targetTriangles) const
+{
+    Stats stats;
+    stats.vertsIn = 0;
+    for(size_t p=0;p<io_parts.size();p++)
+    {
+        stats.vertsIn += io_parts[p].verts.size();
+    }
+    stats.maxError = 0.0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    weld(io_parts, _out);
+    std::chrono::steady_clock::time_point welded = std::chrono::steady_clock::now();
+    stats.weldTime = std::chrono::duration<double, std::milli>(welded-start).count();
+    stats.vertsWelded = _out.verts.size();
+    // the triangles welding collapses aren't the decimation's
+    stats.trisIn = _out.indices.size()/3;
+
+    const size_t nFaces = _out.indices.size()/3;
+    if(_targetTriangles > 0 && _targetTriangles < nFaces)
+    {
+        // share the triangles out by the depth of their centre, as the slabs of the extraction are
+        float lo = std::numeric_limits<float>::max(), hi = -lo;
+        for(size_t v=0;v<_out.verts.size();v++)
+        {
+            lo = std::min(lo, _out.verts[v].m_x);
+            hi = std::max(hi, _out.verts[v].m_x);
+        }
+        // at least a block per thread, and small enough blocks that the decimation of one stays in the cache as
+        // the collapses jump all over the block
+        const unsigned int nBlocks = (unsigned int)std::max<size_t>(std::max<size_t>(1, std::min<size_t>(m_numThreads, nFaces/1024)),
+                                                                    nFaces/BlockFaces);
+        const float scale = hi > lo ? nBlocks/(hi-lo) : 0.0f;
+        std::vector<std::vector<GLuint> > blockFaces(nBlocks);
+        for(size_t f=0;f<nFaces;f++)
+        {
+            const GLuint *t = &_out.indices[3*f];
+            const float x = (_out.verts[t[0]].m_x+_out.verts[t[1]].m_x+_out.verts[t[2]].m_x)/3.0f;
+            const unsigned int b = std::min(nBlocks-1, (unsigned int)std::max(0.0f, (x-lo)*scale));
+            blockFaces[b].push_back(f);
+        }
+
+        std::vector<std::vector<GLuint> > blockIndices(nBlocks);
+        std::vector<double> blockErrors(nBlocks, 0.0);
+        std::vector<size_t> targets(nBlocks);
+        for(unsigned int b=0;b<nBlocks;b++)
+        {
+            targets[b] = (size_t)((double)blockFaces[b].size()*_targetTriangles/nFaces+0.5);
+        }
+        std::vector<GLuint> indices;
+        if(nBlocks == 1)
+        {
+            decimateBlock(&_out, &blockFaces[0], targets[0], false, &indices, &stats.maxError);
+        }
+        else
+        {
+            // the blocks leave the triangles along their seams alone, a last pass over the whole mesh
+            // (much smaller by then) takes those down to the target too
+            const unsigned int nWorkers = std::min(m_numThreads, nBlocks);
+            auto work = [&](unsigned int _first)
+            {
+                for(unsigned int b=_first;b<nBlocks;b+=nWorkers)
+                {
+                    decimateBlock(&_out, &blockFaces[b], targets[b], true, &blockIndices[b], &blockErrors[b]);
+                }
+            };
+            std::vector<std::thread> workers;
+            for(unsigned int w=1;w<nWorkers;w++)
+            {
+                workers.push_back(std::thread(work, w));
+            }
+            work(0);
+            for(size_t w=0;w<workers.size();w++)
+            {
+                workers[w].join();
+            }
+            _out.indices.clear();
+            for(unsigned int b=0;b<nBlocks;b++)
+            {
+                _out.indices.insert(_out.indices.end(), blockIndices[b].begin(), blockIndices[b].end());
+                stats.maxError = std::max(stats.maxError, blockErrors[b]);
+            }
+            std::vector<GLuint> faces(_out.indices.size()/3);
+            for(size_t f=0;f<faces.size();f++)
+            {
+                faces[f] = f;
+            }
+            double seamError = 0.0;
+            decimateBlock(&_out, &faces, _targetTriangles, false, &indices, &seamError);
+            stats.maxError = std::max(stats.maxError, seamError);
+        }
+
+        // the collapses leave vertices none of the triangles use
+        _out.indices.swap(indices);
+        dropUnusedVertices(_out);
+    }
+    stats.vertsOut = _out.verts.size();
+    stats.trisOut = _out.indices.size()/3;
+    stats.maxError = std::sqrt(stats.maxError);
+    stats.decimateTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-welded).count();
+    return stats;
+}
+
+void MeshDecimator::weld(std::vector<IndexedMesh> &io_parts, IndexedMesh &_out)
+{
+    size_t nVerts = 0, nIndices = 0;
+    bool normals = !io_parts.empty();
+    for(size_t p=0;p<io_parts.size();p++)
+    {
+        nVerts += io_parts[p].verts.size();
+        nIndices += io_parts[p].indices.size();
+        normals = normals && io_parts[p].normals.size() == io_parts[p].verts.size();
+    }
+    _out = IndexedMesh();
+    _out.verts.reserve(nVerts);
+    _out.indices.reserve(nIndices);
+    if(normals)
+        _out.normals.reserve(nVerts);
+
+    // vertices are only duplicated across the slab boundaries but the parts don't say where those are
+    // so every vertex goes through the table
+    std::unordered_map<PositionKey, GLuint, PositionHash> table;
+    table.reserve(nVerts);
+    std::vector<GLuint> remap;
+    bool dropped = false;
+    for(size_t p=0;p<io_parts.size();p++)
+    {
+        IndexedMesh &part = io_parts[p];
+        remap.resize(part.verts.size());
+        for(size_t v=0;v<part.verts.size();v++)
+        {
+            PositionKey key;
+            // +0.0 so -0 and 0 weld
+            const float c[3] = {part.verts[v].m_x+0.0f, part.verts[v].m_y+0.0f, part.verts[v].m_z+0.0f};
+            std::memcpy(key.bits, c, sizeof(key.bits));
+            std::pair<std::unordered_map<PositionKey, GLuint, PositionHash>::iterator, bool> slot =
+                table.insert(std::make_pair(key, (GLuint)_out.verts.size()));
+            if(slot.second)
+            {
+                _out.verts.push_back(part.verts[v]);
+                if(normals)
+                    _out.normals.push_back(part.normals[v]);
+            }
+            remap[v] = slot.first->second;
+        }
+        // a vertex can sit on a corner of the grid when the isolevel equals a sample, the triangles it
+        // collapses to lines or points are dropped
+        for(size_t i=0;i+2<part.indices.size();i+=3)
+        {
+            const GLuint a = remap[part.indices[i]], b = remap[part.indices[i+1]], c = remap[part.indices[i+2]];
+            if(a == b || b == c || a == c)
+            {
+                dropped = true;
+                continue;
+            }
+            _out.indices.push_back(a);
+            _out.indices.push_back(b);
+            _out.indices.push_back(c);
+        }
+        part = IndexedMesh();
+    }
+    // a vertex only those triangles used would still be uploaded
+    if(dropped)
+        dropUnusedVertices(_out);
+}
+
+void MeshDecimator::dropUnusedVertices(IndexedMesh &io_mesh)
+{
+    // keeping the order of the rest
+    const GLuint unused = std::numeric_limits<GLuint>::max();
+    std::vector<GLuint> remap(io_mesh.verts.size(), unused);
+    for(size_t i=0;i<io_mesh.indices.size();i++)
+    {
+        remap[io_mesh.indices[i]] = 0;
+    }
+    GLuint nVerts = 0;
+    const bool normals = !io_mesh.normals.empty();
+    for(size_t v=0;v<remap.size();v++)
+    {
+        if(remap[v] == unused)
+            continue;
+        remap[v] = nVerts;
+        io_mesh.verts[nVerts] = io_mesh.verts[v];
+        if(normals)
+            io_mesh.normals[nVerts] = io_mesh.normals[v];
+        nVerts++;
+    }
+    io_mesh.verts.resize(nVerts);
+    if(normals)
+        io_mesh.normals.resize(nVerts);
+    for(size_t i=0;i<io_mesh.indices.size();i++)
+    {
+        io_mesh.indices[i] = remap[io_mesh.indices[i]];
+    }
+}
+
+void MeshDecimator::decimateBlock(IndexedMesh *io_mesh, const std::vector<GLuint> *_faces, size_t _target,
+                                  bool _spareLocked, std::vector<GLuint> *_indices, double *_maxError)
+{
+    const std::vector<GLuint> &faces = *_faces;
+    const size_t nFaces = faces.size();
+    *_maxError = 0.0;
+
+    // the block gets its own numbering of the vertices it uses
+    std::unordered_map<GLuint, GLuint> local;
+    local.reserve(nFaces);
+    std::vector<GLuint> global;
+    std::vector<GLuint> tris(3*nFaces);
+    for(size_t f=0;f<nFaces;f++)
+    {
+        for(int c=0;c<3;c++)
+        {
+            const GLuint g = io_mesh->indices[3*faces[f]+c];
+            std::pair<std::unordered_map<GLuint, GLuint>::iterator, bool> slot =
+                local.insert(std::make_pair(g, (GLuint)global.size()));
+            if(slot.second)
+                global.push_back(g);
+            tris[3*f+c] = slot.first->second;
+        }
+    }
+    const size_t nVerts = global.size();
+    std::vector<Vec3d> pos(nVerts);
+    for(size_t v=0;v<nVerts;v++)
+    {
+        const ngl::Vec3 &p = io_mesh->verts[global[v]];
+        pos[v].x = p.m_x;
+        pos[v].y = p.m_y;
+        pos[v].z = p.m_z;
+    }
+
+    // each vertex starts with the planes of the triangles around it, unweighted so the error reads as
+    // squared distances in voxels
+    std::vector<Quadric> quadrics(nVerts);
+    std::vector<std::vector<GLuint> > vertFaces(nVerts);
+    for(size_t f=0;f<nFaces;f++)
+    {
+        const GLuint *t = &tris[3*f];
+        Vec3d n = cross(pos[t[1]]-pos[t[0]], pos[t[2]]-pos[t[0]]);
+        const double len = std::sqrt(dot(n, n));
+        if(len > 0.0)
+        {
+            n.x /= len; n.y /= len; n.z /= len;
+            const double d = -dot(n, pos[t[0]]);
+            for(int c=0;c<3;c++)
+                quadrics[t[c]].addPlane(n.x, n.y, n.z, d);
+        }
+        for(int c=0;c<3;c++)
+            vertFaces[t[c]].push_back(f);
+    }
+
+    // an edge that isn't shared by exactly two triangles of the block is on the border of the surface, on the
+    // border with another block or non-manifold, its ends are locked
+    std::vector<uint64_t> edges;
+    edges.reserve(3*nFaces);
+    for(size_t f=0;f<nFaces;f++)
+    {
+        for(int c=0;c<3;c++)
+        {
+            const uint64_t a = tris[3*f+c], b = tris[3*f+(c+1)%3];
+            edges.push_back(a < b ? a<<32 | b : b<<32 | a);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    std::vector<char> locked(nVerts, 0);
+    size_t nEdges = 0;
+    for(size_t e=0;e<edges.size();)
+    {
+        size_t n = e+1;
+        while(n < edges.size() && edges[n] == edges[e])
+            n++;
+        if(n-e != 2)
+        {
+            locked[edges[e]>>32] = 1;
+            locked[edges[e]&0xffffffffu] = 1;
+        }
+        edges[nEdges++] = edges[e];
+        e = n;
+    }
+    edges.resize(nEdges);
+    if(_spareLocked)
+    {
+        // the triangles touching a locked vertex can't all go so they don't count towards the target,
+        // otherwise the block would carve into its inside to make up for them
+        for(size_t f=0;f<nFaces;f++)
+        {
+            const GLuint *t = &tris[3*f];
+            if(locked[t[0]] || locked[t[1]] || locked[t[2]])
+                _target++;
+        }
+    }
+
+    std::vector<unsigned> stamps(nVerts, 0);
+    std::vector<char> deadVert(nVerts, 0);
+    std::vector<char> deadFace(nFaces, 0);
+
+    // where the collapse of drop into keep puts the vertex and the error of that, the target isn't queued
+    // with the collapse to keep the heap small, it is worked out again for the few collapses that happen
+    auto place = [&](GLuint _keep, GLuint _drop, Vec3d &_target)
+    {
+        const Quadric q = quadrics[_keep]+quadrics[_drop];
+        if(locked[_keep])
+            return q.error(_target = pos[_keep]);
+        const Vec3d mid = {(pos[_keep].x+pos[_drop].x)*0.5, (pos[_keep].y+pos[_drop].y)*0.5, (pos[_keep].z+pos[_drop].z)*0.5};
+        const Vec3d edge = pos[_drop]-pos[_keep];
+        // the optimum can fly off on nearly flat areas, keep it near the edge
+        if(q.optimum(_target) && dot(_target-mid, _target-mid) <= dot(edge, edge))
+            return q.error(_target);
+        const Vec3d *candidates[2] = {&pos[_keep], &pos[_drop]};
+        _target = mid;
+        double bestError = q.error(mid);
+        for(int i=0;i<2;i++)
+        {
+            const double e = q.error(*candidates[i]);
+            if(e < bestError)
+            {
+                bestError = e;
+                _target = *candidates[i];
+            }
+        }
+        return bestError;
+    };
+    // the collapse of the edge a-b, into the locked end if there is one
+    auto collapse = [&](GLuint _a, GLuint _b, Collapse &_c)
+    {
+        if(locked[_b])
+            std::swap(_a, _b);
+        _c.keep = _a;
+        _c.drop = _b;
+        _c.keepStamp = stamps[_a];
+        _c.dropStamp = stamps[_b];
+        Vec3d target;
+        _c.cost = place(_a, _b, target);
+    };
+    std::vector<Collapse> initial;
+    initial.reserve(nEdges);
+    for(size_t e=0;e<nEdges;e++)
+    {
+        const GLuint a = edges[e]>>32, b = edges[e]&0xffffffffu;
+        if(locked[a] && locked[b])
+            continue;
+        initial.push_back(Collapse());
+        collapse(a, b, initial.back());
+    }
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse> > heap(std::greater<Collapse>(), std::move(initial));
+    std::vector<uint64_t>().swap(edges);
+
+    std::vector<GLuint> ringKeep, ringDrop, ringCommon, common;
+    // the vertices around _v, sorted
+    auto ring = [&](GLuint _v, std::vector<GLuint> &_ring)
+    {
+        _ring.clear();
+        for(size_t i=0;i<vertFaces[_v].size();i++)
+        {
+            const GLuint *t = &tris[3*vertFaces[_v][i]];
+            for(int c=0;c<3;c++)
+                if(t[c] != _v)
+                    _ring.push_back(t[c]);
+        }
+        std::sort(_ring.begin(), _ring.end());
+        _ring.erase(std::unique(_ring.begin(), _ring.end()), _ring.end());
+    };
+    // false if moving the triangles of _v that don't use _other to _target would turn one of them over or flatten it
+    auto keepsShape = [&](GLuint _v, GLuint _other, const Vec3d &_target)
+    {
+        for(size_t i=0;i<vertFaces[_v].size();i++)
+        {
+            const GLuint *t = &tris[3*vertFaces[_v][i]];
+            if(t[0] == _other || t[1] == _other || t[2] == _other)
+                continue;
+            const Vec3d p[3] = {t[0] == _v ? _target : pos[t[0]], t[1] == _v ? _target : pos[t[1]],
+                                t[2] == _v ? _target : pos[t[2]]};
+            const Vec3d before = cross(pos[t[1]]-pos[t[0]], pos[t[2]]-pos[t[0]]);
+            const Vec3d after = cross(p[1]-p[0], p[2]-p[0]);
+            const double d = dot(before, after);
+            if(d <= 0.0 || d*d < 0.25*dot(before, before)*dot(after, after))
+                return false;
+        }
+        return true;
+    };
+
+    size_t alive = nFaces;
+    while(alive > _target && !heap.empty())
+    {
+        const Collapse c = heap.top();
+        heap.pop();
+        if(deadVert[c.keep] || deadVert[c.drop] || stamps[c.keep] != c.keepStamp || stamps[c.drop] != c.dropStamp)
+            continue;
+        // the ends must share exactly the two vertices across the edge, otherwise the collapse pinches the surface
+        ring(c.keep, ringKeep);
+        ring(c.drop, ringDrop);
+        common.clear();
+        std::set_intersection(ringKeep.begin(), ringKeep.end(), ringDrop.begin(), ringDrop.end(), std::back_inserter(common));
+        if(common.size() != 2)
+            continue;
+        // and no vertex may be left with fewer than three neighbours, which would fold a small closed piece flat
+        if(ringKeep.size()+ringDrop.size() < 7)
+            continue;
+        ring(common[0], ringCommon);
+        if(ringCommon.size() <= 3)
+            continue;
+        ring(common[1], ringCommon);
+        if(ringCommon.size() <= 3)
+            continue;
+        Vec3d target;
+        place(c.keep, c.drop, target);
+        if(!keepsShape(c.keep, c.drop, target) || !keepsShape(c.drop, c.keep, target))
+            continue;
+
+        // the two triangles on the edge go, the rest of the drop's move over to keep
+        for(size_t i=0;i<vertFaces[c.drop].size();i++)
+        {
+            const GLuint f = vertFaces[c.drop][i];
+            GLuint *t = &tris[3*f];
+            if(t[0] == c.keep || t[1] == c.keep || t[2] == c.keep)
+            {
+                deadFace[f] = 1;
+                alive--;
+                continue;
+            }
+            for(int v=0;v<3;v++)
+                if(t[v] == c.drop)
+                    t[v] = c.keep;
+            vertFaces[c.keep].push_back(f);
+        }
+        std::vector<GLuint> &keepFaces = vertFaces[c.keep];
+        keepFaces.erase(std::remove_if(keepFaces.begin(), keepFaces.end(),
+                                       [&](GLuint _f){return deadFace[_f] != 0;}), keepFaces.end());
+        std::vector<GLuint>().swap(vertFaces[c.drop]);
+        for(size_t i=0;i<common.size();i++)
+        {
+            std::vector<GLuint> &other = vertFaces[common[i]];
+            other.erase(std::remove_if(other.begin(), other.end(),
+                                       [&](GLuint _f){return deadFace[_f] != 0;}), other.end());
+        }
+        quadrics[c.keep] = quadrics[c.keep]+quadrics[c.drop];
+        pos[c.keep] = target;
+        // a locked vertex can be shared with another block so its normal stays as it is
+        if(!io_mesh->normals.empty() && !locked[c.keep])
+            io_mesh->normals[global[c.keep]] += io_mesh->normals[global[c.drop]];
+        deadVert[c.drop] = 1;
+        stamps[c.keep]++;
+        *_maxError = std::max(*_maxError, c.cost);
+
+        ring(c.keep, ringKeep);
+        for(size_t i=0;i<ringKeep.size();i++)
+        {
+            if(locked[c.keep] && locked[ringKeep[i]])
+                continue;
+            Collapse next;
+            collapse(c.keep, ringKeep[i], next);
+            heap.push(next);
+        }
+    }
+
+    // locked vertices never move so only the ones that belong to this block alone are written back
+    for(size_t v=0;v<nVerts;v++)
+    {
+        if(locked[v] || deadVert[v])
+            continue;
+        io_mesh->verts[global[v]].set(pos[v].x, pos[v].y, pos[v].z);
+    }
+    _indices->clear();
+    _indices->reserve(3*alive);
+    for(size_t f=0;f<nFaces;f++)
+    {
+        if(deadFace[f])
+            continue;
+        for(int c=0;c<3;c++)
+            _indices->push_back(global[tris[3*f+c]]);
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
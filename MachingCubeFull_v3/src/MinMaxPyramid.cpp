@@ -0,0 +1,134 @@
+#include "MinMaxPyramid.h"
+#include <cfloat>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file MinMaxPyramid.cpp
+/// @brief min/max pyramid over blocks of voxels used to skip empty space
+//----------------------------------------------------------------------------------------------------------------------
+
+void MinMaxPyramid::allocate(unsigned int _depth, unsigned int _height, unsigned int _width)
+{
+    m_levels.clear();
+    Level level;
+    // the blocks cover the cells, there is one cell less than samples along each axis
+    level.depth = std::max(1u, (_depth-1+BlockSize-1)/BlockSize);
+    level.height = std::max(1u, (_height-1+BlockSize-1)/BlockSize);
+    level.width = std::max(1u, (_width-1+BlockSize-1)/BlockSize);
+    level.minValue.assign((size_t)level.depth*level.height*level.width, FLT_MAX);
+    level.maxValue.assign((size_t)level.depth*level.height*level.width, -FLT_MAX);
+    m_levels.push_back(level);
+}
+
+void MinMaxPyramid::buildCoarseLevels()
+{
+    while(m_levels.back().depth > 1 || m_levels.back().height > 1 || m_levels.back().width > 1)
+    {
+        const Level &fine = m_levels.back();
+        Level coarse;
+        coarse.depth = (fine.depth+1)/2;
+        coarse.height = (fine.height+1)/2;
+        coarse.width = (fine.width+1)/2;
+        coarse.minValue.assign((size_t)coarse.depth*coarse.height*coarse.width, FLT_MAX);
+        coarse.maxValue.assign((size_t)coarse.depth*coarse.height*coarse.width, -FLT_MAX);
+        for(unsigned int bi=0; bi<fine.depth; bi++)
+        {
+            for(unsigned int bj=0; bj<fine.height; bj++)
+            {
+                for(unsigned int bk=0; bk<fine.width; bk++)
+                {
+                    size_t from = fine.index(bi, bj, bk);
+                    size_t to = coarse.index(bi/2, bj/2, bk/2);
+                    coarse.minValue[to] = std::min(coarse.minValue[to], fine.minValue[from]);
+                    coarse.maxValue[to] = std::max(coarse.maxValue[to], fine.maxValue[from]);
+                }
+            }
+        }
+        m_levels.push_back(coarse);
+    }
+}
+
+void MinMaxPyramid::updateCoarseLevels(const unsigned int _begin[3], const unsigned int _end[3])
+{
+    unsigned int b0[3] = {_begin[0], _begin[1], _begin[2]};
+    unsigned int b1[3] = {_end[0], _end[1], _end[2]};
+    for(size_t l=1; l<m_levels.size(); l++)
+    {
+        const Level &fine = m_levels[l-1];
+        Level &coarse = m_levels[l];
+        for(int a=0; a<3; a++)
+        {
+            b0[a] /= 2;
+            b1[a] = (b1[a]+1)/2;
+        }
+        for(unsigned int bi=b0[0]; bi<b1[0]; bi++)
+        {
+            for(unsigned int bj=b0[1]; bj<b1[1]; bj++)
+            {
+                for(unsigned int bk=b0[2]; bk<b1[2]; bk++)
+                {
+                    float lo = FLT_MAX, hi = -FLT_MAX;
+                    for(unsigned int i=bi*2; i<std::min(bi*2+2, fine.depth); i++)
+                    {
+                        for(unsigned int j=bj*2; j<std::min(bj*2+2, fine.height); j++)
+                        {
+                            for(unsigned int k=bk*2; k<std::min(bk*2+2, fine.width); k++)
+                            {
+                                lo = std::min(lo, fine.minValue[fine.index(i, j, k)]);
+                                hi = std::max(hi, fine.maxValue[fine.index(i, j, k)]);
+                            }
+                        }
+                    }
+                    coarse.minValue[coarse.index(bi, bj, bk)] = lo;
+                    coarse.maxValue[coarse.index(bi, bj, bk)] = hi;
+                }
+            }
+        }
+    }
+}
+
+size_t MinMaxPyramid::countActive(float _isoA, float _isoB) const
+{
+    if(m_levels.empty())
+        return 0;
+    size_t count = 0;
+    for(size_t b=0; b<m_levels[0].minValue.size(); b++)
+    {
+        if(isActive(0, b, _isoA) || isActive(0, b, _isoB))
+            ++count;
+    }
+    return count;
+}
+
+void MinMaxPyramid::activeBlocks(unsigned int _bi, float _iso, std::vector<std::pair<unsigned int, unsigned int> > &_blocks) const
+{
+    _blocks.clear();
+    if(m_levels.empty())
+        return;
+    // the top level is a single block so we start from there and only go down the branches
+    // of layer _bi which straddle the isolevel
+    unsigned int top = m_levels.size()-1;
+    descend(top, 0, 0, _bi, _iso, _blocks);
+    // the recursion visits the blocks in quadtree order, the slab sweep wants them row by row
+    std::sort(_blocks.begin(), _blocks.end());
+}
+
+void MinMaxPyramid::descend(unsigned int _level, unsigned int _bj, unsigned int _bk, unsigned int _layer, float _iso,
+                            std::vector<std::pair<unsigned int, unsigned int> > &_blocks) const
+{
+    // on each level the block layer we are after is inside layer _layer>>_level
+    const Level &level = m_levels[_level];
+    if(_bj >= level.height || _bk >= level.width || !isActive(_level, level.index(_layer>>_level, _bj, _bk), _iso))
+        return;
+    if(_level == 0)
+    {
+        _blocks.push_back(std::make_pair(_bj, _bk));
+        return;
+    }
+    for(unsigned int j=0; j<2; j++)
+    {
+        for(unsigned int k=0; k<2; k++)
+        {
+            descend(_level-1, _bj*2+j, _bk*2+k, _layer, _iso, _blocks);
+        }
+    }
+}
@@ -18,11 +18,37 @@ const static float INCREMENT=0.01;
 /// @brief the increment for the wheel zoom
 //----------------------------------------------------------------------------------------------------------------------
 const static float ZOOM=0.1;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the isolevel step for the up/down keys and per pixel of middle mouse drag
+//----------------------------------------------------------------------------------------------------------------------
+const static float ISOSTEP=0.01;
+const static float ISODRAG=0.002;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the distances from the camera past which the next coarser level of detail is used
+//----------------------------------------------------------------------------------------------------------------------
+const static float LODDISTANCE[MachingCube::NumLods-1]={6.0, 9.0, 14.0};
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the error the adaptive mesh is allowed in each of the same distance bands
+//----------------------------------------------------------------------------------------------------------------------
+const static float ADAPTIVEERROR[MachingCube::NumLods]={0.005, 0.01, 0.02, 0.05};
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the triangle count the mesh is decimated to when decimation is switched on
+//----------------------------------------------------------------------------------------------------------------------
+const static size_t DECIMATETARGET=100000;
 
 NGLScene::NGLScene()
 {
   // re-size the widget to that of the parent (in this case the GLFrame passed in on construction)
   m_rotate=false;
+  m_translate=false;
+  m_scrubIso=false;
+  m_autoLod=true;
+  m_adaptive=false;
+  m_surfaceNets=false;
+  m_decimate=false;
+  m_packedVertices=false;
+  m_gpuExtraction=true;
+  m_canExtractOnGpu=false;
   // mouse rotation values set to 0
   m_spinXFace=0;
   m_spinYFace=0;
@@ -118,9 +144,18 @@ void NGLScene::initializeGL()
   glViewport(0,0,width(),height());
 
   mc = new MachingCube();
+  mc->setSmoothNormals(true);
+  // the first mesh of each isolevel is kept next to the volume so the next start only has to load it
+  mc->setMeshCache(true);
   mc->LoadVolumeFromFile(std::string("mri.raw"));
   //mc->generateVolume();
+  // the compute shaders make the unindexed mesh and the CPU the indexed one, G switches between the two
+  m_canExtractOnGpu=mc->canExtractOnGpu();
+  m_gpuExtraction=m_canExtractOnGpu;
+  mc->setIndexed(!m_gpuExtraction);
+  mc->setGpuExtraction(m_gpuExtraction);
   mc->createVAO();
+  m_isolevel=mc->getIsolevel();
 }
 
 
@@ -165,6 +200,35 @@ void NGLScene::paintGL()
   m_mouseGlobalTX.m_m[3][1] = m_modelPos.m_y;
   m_mouseGlobalTX.m_m[3][2] = m_modelPos.m_z;
 
+  // the level of detail follows the distance of the model from the camera, each
+  // level is only extracted the first time it is needed
+  unsigned int lod=0;
+  if(m_autoLod)
+  {
+    ngl::Vec3 eye(m_cam->getEye().m_x,m_cam->getEye().m_y,m_cam->getEye().m_z);
+    float distance=(eye-m_modelPos).length();
+    while(lod<MachingCube::NumLods-1 && distance>LODDISTANCE[lod])
+    {
+      ++lod;
+    }
+  }
+  // the adaptive mesh keeps the full resolution where the surface is curved and trades
+  // the rest for the distance through the error it is allowed
+  mc->setAdaptive(m_adaptive);
+  mc->setAdaptiveError(ADAPTIVEERROR[lod]);
+  mc->setLod(m_adaptive ? 0 : lod);
+  mc->setMesher(m_surfaceNets ? MachingCube::Mesher::SURFACE_NETS : MachingCube::Mesher::MARCHING_CUBES);
+  mc->setDecimationTarget(m_decimate ? DECIMATETARGET : 0);
+  mc->setVertexFormat(m_packedVertices ? MachingCube::VertexFormat::PACKED : MachingCube::VertexFormat::FLOAT);
+  mc->setIndexed(!m_gpuExtraction);
+  mc->setGpuExtraction(m_gpuExtraction);
+  // the packed vertices carry octahedral normals the shader has to unfold
+  shader->setShaderParam1i("OctahedralNormals",m_packedVertices);
+  // re-extract if the isolevel has been changed since the last frame
+  mc->setIsolevel(m_isolevel);
+  // the vertex counts of the GPU extractions that are done by now
+  mc->pollGpuExtraction();
+
   // draw
   loadMatricesToShader();
   // draw the isosurface
@@ -200,6 +264,14 @@ void NGLScene::mouseMoveEvent (QMouseEvent * _event)
     update();
 
    }
+  // middle mouse drag up / down moves the isolevel
+  else if(m_scrubIso && _event->buttons() == Qt::MidButton)
+  {
+    int diffY = (int)(_event->y() - m_origYIso);
+    m_origYIso=_event->y();
+    m_isolevel -= ISODRAG * diffY;
+    update();
+  }
 }
 
 
@@ -221,6 +293,12 @@ void NGLScene::mousePressEvent ( QMouseEvent * _event)
     m_origYPos = _event->y();
     m_translate=true;
   }
+  // middle mouse isolevel mode
+  else if(_event->button() == Qt::MidButton)
+  {
+    m_origYIso = _event->y();
+    m_scrubIso=true;
+  }
 
 }
 
@@ -238,6 +316,10 @@ void NGLScene::mouseReleaseEvent ( QMouseEvent * _event )
   {
     m_translate=false;
   }
+  if (_event->button() == Qt::MidButton)
+  {
+    m_scrubIso=false;
+  }
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -273,6 +355,21 @@ void NGLScene::keyPressEvent(QKeyEvent *_event)
   case Qt::Key_F : showFullScreen(); break;
   // show windowed
   case Qt::Key_N : showNormal(); break;
+  // move the isolevel up and down
+  case Qt::Key_Up : m_isolevel+=ISOSTEP; break;
+  case Qt::Key_Down : m_isolevel-=ISOSTEP; break;
+  // switch the distance based level of detail on and off
+  case Qt::Key_L : m_autoLod^=true; break;
+  // switch between the levels of detail and the adaptive mesh
+  case Qt::Key_O : m_adaptive^=true; break;
+  // switch between the marching cubes and the surface nets mesh
+  case Qt::Key_M : m_surfaceNets^=true; break;
+  // switch the decimation of the mesh on and off
+  case Qt::Key_D : m_decimate^=true; break;
+  // switch between the float and the packed vertex format
+  case Qt::Key_V : m_packedVertices^=true; break;
+  // switch between extracting on the GPU and on the CPU
+  case Qt::Key_G : m_gpuExtraction=!m_gpuExtraction && m_canExtractOnGpu; break;
   default : break;
   }
   // finally update the GLWindow and re-draw
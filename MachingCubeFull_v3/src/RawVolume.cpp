@@ -0,0 +1,176 @@
+#include "RawVolume.h"
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#ifndef WIN32
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file RawVolume.cpp
+/// @brief memory mapped raw volume file
+//----------------------------------------------------------------------------------------------------------------------
+
+RawVolume::RawVolume()
+{
+    m_width = m_height = m_depth = 0;
+    m_type = VoxelType::UINT8;
+    m_bytesPerVoxel = 1;
+    m_sliceBytes = 0;
+    m_data = 0;
+    m_size = 0;
+}
+
+RawVolume::~RawVolume()
+{
+    close();
+}
+
+bool RawVolume::readInfo(const std::string &_file)
+{
+    // the legacy layout of mri.raw which has been hard coded until now
+    m_width = 200;
+    m_height = 160;
+    m_depth = 160;
+    m_bytesPerVoxel = 1;
+
+    std::string info = _file.substr(0, _file.find_last_of('.'))+".info";
+    std::ifstream in(info.c_str());
+    if (in.is_open() != true)
+    {
+        std::cout<<"no volume info "<<info<<" assuming 200x160x160 1 byte per voxel\n";
+    }
+    else
+    {
+        std::string line;
+        bool dims = false;
+        while(std::getline(in, line))
+        {
+            if(std::sscanf(line.c_str(), " Volume is %u x %u x %u", &m_width, &m_height, &m_depth) == 3)
+                dims = true;
+            else
+                std::sscanf(line.c_str(), " %u byte", &m_bytesPerVoxel);
+        }
+        if(!dims)
+        {
+            std::cout<<"can't read the volume size from "<<info<<"\n";
+            return false;
+        }
+    }
+    switch(m_bytesPerVoxel)
+    {
+        case 1 : m_type = VoxelType::UINT8; break;
+        case 2 : m_type = VoxelType::UINT16; break;
+        case 4 : m_type = VoxelType::FLOAT; break;
+        default :
+            std::cout<<m_bytesPerVoxel<<" bytes per voxel is not supported\n";
+            return false;
+    }
+    m_sliceBytes = (size_t)m_width*m_height*m_bytesPerVoxel;
+    return true;
+}
+
+bool RawVolume::open(const std::string &_file)
+{
+    close();
+    if(!readInfo(_file))
+        return false;
+    size_t expected = m_sliceBytes*m_depth;
+
+#ifndef WIN32
+    int fd = ::open(_file.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cout<<"FILE NOT FOUND !!!! "<<_file<<"\n";
+        return false;
+    }
+    struct stat st;
+    fstat(fd, &st);
+    if((size_t)st.st_size < expected)
+    {
+        std::cout<<_file<<" is "<<st.st_size<<" bytes, expected "<<expected<<"\n";
+        ::close(fd);
+        return false;
+    }
+    void *map = mmap(0, expected, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps the file open for us
+    ::close(fd);
+    if(map == MAP_FAILED)
+    {
+        std::cout<<"failed to map "<<_file<<"\n";
+        return false;
+    }
+    // we always sweep the volume slice after slice
+    madvise(map, expected, MADV_SEQUENTIAL);
+    m_data = static_cast<const unsigned char *>(map);
+#else
+    std::ifstream in(_file.c_str(), std::ifstream::binary);
+    if (in.is_open() != true)
+    {
+        std::cout<<"FILE NOT FOUND !!!! "<<_file<<"\n";
+        return false;
+    }
+    m_buffer.resize(expected);
+    in.read(reinterpret_cast<char *>(&m_buffer[0]), expected);
+    if((size_t)in.gcount() < expected)
+    {
+        std::cout<<_file<<" is "<<in.gcount()<<" bytes, expected "<<expected<<"\n";
+        m_buffer.clear();
+        return false;
+    }
+    m_data = &m_buffer[0];
+#endif
+    m_size = expected;
+    return true;
+}
+
+void RawVolume::create(unsigned int _width, unsigned int _height, unsigned int _depth, VoxelType _type)
+{
+    close();
+    m_width = _width;
+    m_height = _height;
+    m_depth = _depth;
+    m_type = _type;
+    switch(_type)
+    {
+        case VoxelType::UINT8 : m_bytesPerVoxel = 1; break;
+        case VoxelType::UINT16 : m_bytesPerVoxel = 2; break;
+        case VoxelType::FLOAT : m_bytesPerVoxel = 4; break;
+    }
+    m_sliceBytes = (size_t)m_width*m_height*m_bytesPerVoxel;
+    m_size = m_sliceBytes*m_depth;
+    m_buffer.assign(m_size, 0);
+    m_data = m_buffer.empty() ? 0 : &m_buffer[0];
+}
+
+void RawVolume::close()
+{
+#ifndef WIN32
+    if(m_data != 0 && m_buffer.empty())
+        munmap(const_cast<unsigned char *>(m_data), m_size);
+#endif
+    std::vector<unsigned char>().swap(m_buffer);
+    m_data = 0;
+    m_size = 0;
+}
+
+void RawVolume::releaseSlices(unsigned int _begin, unsigned int _end) const
+{
+#ifndef WIN32
+    // dropping the pages of our own memory would zero them
+    if(m_data == 0 || _begin >= _end || !m_buffer.empty())
+        return;
+    // madvise wants page aligned addresses, dropping a bit of a neighbouring slice
+    // is harmless as it is just paged back in from the file
+    static const size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t begin = (size_t)_begin*m_sliceBytes;
+    size_t end = std::min((size_t)_end*m_sliceBytes, m_size);
+    begin -= begin % pageSize;
+    madvise(const_cast<unsigned char *>(m_data)+begin, end-begin, MADV_DONTNEED);
+#endif
+}
@@ -0,0 +1,286 @@
+#include "RowClassifier.h"
+#include <cstring>
+#include <cmath>
+#if defined(__AVX2__)
+  #include <immintrin.h>
+#elif defined(__SSE2__)
+  #include <emmintrin.h>
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file RowClassifier.cpp
+/// @brief computes the marching cubes index of a whole row of cells at once
+//----------------------------------------------------------------------------------------------------------------------
+
+#if defined(__SSE2__)
+/*-------------------------------------------------------------------------
+   The samples of each of the four rows that are below the isolevel come out
+   of the compares as bit masks. Bit n of row r is spread into byte n with
+   weight 1 (row j slice i), 2 (row j slice i+1), 4 (row j+1 slice i+1) or
+   8 (row j+1 slice i) giving corners 0-3 of the cell starting at that
+   sample, corners 4-7 are the same bits of the next sample shifted up by 4.
+*/
+struct SpreadTable
+{
+    SpreadTable()
+    {
+        for(unsigned int m=0; m<256; m++)
+        {
+            bytes[m] = 0;
+            for(unsigned int b=0; b<8; b++)
+            {
+                if(m & (1<<b))
+                    bytes[m] |= 1ull<<(b*8);
+            }
+        }
+    }
+    uint64_t bytes[256];
+};
+static const SpreadTable s_spread;
+
+/*-------------------------------------------------------------------------
+   An integer sample is below the isolevel iff it is at most ceil(iso)-1,
+   returns -1 if no sample can be below it, 1 if all of them are and 0
+   with the largest inside value in _u otherwise.
+*/
+static int integerThreshold(float _iso, int _max, int &_u)
+{
+    double t = std::ceil((double)_iso);
+    if(!(t > 0.0))
+        return -1;
+    if(t > _max)
+        return 1;
+    _u = (int)t-1;
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief compares 16 samples of type T against the isolevel, bit n of the mask is set if sample n is below it
+//----------------------------------------------------------------------------------------------------------------------
+template <typename T>
+struct Below;
+
+template <>
+struct Below<float>
+{
+    explicit Below(float _iso) : uniform(0)
+    {
+#if defined(__AVX2__)
+        iso = _mm256_set1_ps(_iso);
+#else
+        iso = _mm_set1_ps(_iso);
+#endif
+    }
+    uint32_t mask16(const float *_p) const
+    {
+#if defined(__AVX2__)
+        return _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(_p), iso, _CMP_LT_OQ)) |
+               _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(_p+8), iso, _CMP_LT_OQ))<<8;
+#else
+        return _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(_p), iso)) |
+               _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(_p+4), iso))<<4 |
+               _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(_p+8), iso))<<8 |
+               _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(_p+12), iso))<<12;
+#endif
+    }
+    int uniform;
+#if defined(__AVX2__)
+    __m256 iso;
+#else
+    __m128 iso;
+#endif
+};
+
+template <>
+struct Below<unsigned char>
+{
+    explicit Below(float _iso)
+    {
+        int u = 0;
+        uniform = integerThreshold(_iso, 255, u);
+        inside = _mm_set1_epi8((char)u);
+    }
+    uint32_t mask16(const unsigned char *_p) const
+    {
+        // v <= u iff min(v,u) == v
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(_p));
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, inside), v));
+    }
+    int uniform;
+    __m128i inside;
+};
+
+template <>
+struct Below<unsigned short>
+{
+    explicit Below(float _iso)
+    {
+        int u = 0;
+        uniform = integerThreshold(_iso, 65535, u);
+#if defined(__AVX2__)
+        inside = _mm256_set1_epi16((short)u);
+#else
+        // SSE2 only has signed 16 bit compares so both sides are offset by 0x8000
+        inside = _mm_set1_epi16((short)(u^0x8000));
+#endif
+    }
+    uint32_t mask16(const unsigned short *_p) const
+    {
+#if defined(__AVX2__)
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_p));
+        __m256i eq = _mm256_cmpeq_epi16(_mm256_min_epu16(v, inside), v);
+        // packing works within each 128 bit lane so gather the two halves into the low lane
+        __m256i bytes = _mm256_permute4x64_epi64(_mm256_packs_epi16(eq, eq), 0x08);
+        return _mm256_movemask_epi8(bytes) & 0xffff;
+#else
+        const __m128i sign = _mm_set1_epi16((short)0x8000);
+        __m128i gt0 = _mm_cmpgt_epi16(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(_p)), sign), inside);
+        __m128i gt1 = _mm_cmpgt_epi16(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(_p+8)), sign), inside);
+        return ~_mm_movemask_epi8(_mm_packs_epi16(gt0, gt1)) & 0xffff;
+#endif
+    }
+    int uniform;
+#if defined(__AVX2__)
+    __m256i inside;
+#else
+    __m128i inside;
+#endif
+};
+#endif
+
+RowClassifier::RowClassifier()
+{
+    m_path = Path::SIMD;
+    reserve(0);
+}
+
+const char *RowClassifier::instructionSet()
+{
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE2__)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+void RowClassifier::reserve(unsigned int _cells)
+{
+    // the 8 byte loads and stores of combine may run up to 8 bytes past the row
+    if(m_cubes.size() < _cells+8)
+    {
+        m_nibbles.resize(_cells+16, 0);
+        m_cubes.resize(_cells+8, 0);
+        m_active.resize(_cells+1);
+    }
+}
+
+unsigned int RowClassifier::classify(const unsigned char *_s0j, const unsigned char *_s0j1, const unsigned char *_s1j,
+                                     const unsigned char *_s1j1, unsigned int _cells, float _iso)
+{
+    const unsigned char *rows[4] = {_s0j, _s0j1, _s1j, _s1j1};
+    return m_path == Path::SIMD ? classifySIMD(rows, _cells, _iso) : classifyScalar(rows, _cells, _iso);
+}
+
+unsigned int RowClassifier::classify(const unsigned short *_s0j, const unsigned short *_s0j1, const unsigned short *_s1j,
+                                     const unsigned short *_s1j1, unsigned int _cells, float _iso)
+{
+    const unsigned short *rows[4] = {_s0j, _s0j1, _s1j, _s1j1};
+    return m_path == Path::SIMD ? classifySIMD(rows, _cells, _iso) : classifyScalar(rows, _cells, _iso);
+}
+
+unsigned int RowClassifier::classify(const float *_s0j, const float *_s0j1, const float *_s1j,
+                                     const float *_s1j1, unsigned int _cells, float _iso)
+{
+    const float *rows[4] = {_s0j, _s0j1, _s1j, _s1j1};
+    return m_path == Path::SIMD ? classifySIMD(rows, _cells, _iso) : classifyScalar(rows, _cells, _iso);
+}
+
+template <typename T>
+unsigned int RowClassifier::classifyScalar(const T *_rows[4], unsigned int _cells, float _iso)
+{
+    reserve(_cells);
+    const T *s0j = _rows[0];
+    const T *s0j1 = _rows[1];
+    const T *s1j = _rows[2];
+    const T *s1j1 = _rows[3];
+    unsigned int n = 0;
+    for(unsigned int k=0; k<_cells; k++)
+    {
+        int cubeindex = 0;
+        if (s0j[k] < _iso) cubeindex |= 1;
+        if (s1j[k] < _iso) cubeindex |= 2;
+        if (s1j1[k] < _iso) cubeindex |= 4;
+        if (s0j1[k] < _iso) cubeindex |= 8;
+        if (s0j[k+1] < _iso) cubeindex |= 16;
+        if (s1j[k+1] < _iso) cubeindex |= 32;
+        if (s1j1[k+1] < _iso) cubeindex |= 64;
+        if (s0j1[k+1] < _iso) cubeindex |= 128;
+        m_cubes[k] = cubeindex;
+        if(cubeindex != 0 && cubeindex != 255)
+            m_active[n++] = k;
+    }
+    return n;
+}
+
+template <typename T>
+unsigned int RowClassifier::classifySIMD(const T *_rows[4], unsigned int _cells, float _iso)
+{
+#if defined(__SSE2__)
+    reserve(_cells);
+    const Below<T> below(_iso);
+    if(below.uniform != 0)
+    {
+        // every sample is on the same side so the whole row is empty
+        std::memset(&m_cubes[0], below.uniform > 0 ? 255 : 0, _cells);
+        return 0;
+    }
+    const uint64_t *spread = s_spread.bytes;
+    const unsigned int samples = _cells+1;
+    unsigned int k = 0;
+    for(; k+16<=samples; k+=16)
+    {
+        uint32_t m0 = below.mask16(_rows[0]+k);
+        uint32_t m1 = below.mask16(_rows[1]+k);
+        uint32_t m2 = below.mask16(_rows[2]+k);
+        uint32_t m3 = below.mask16(_rows[3]+k);
+        uint64_t lo = spread[m0&0xff] | spread[m2&0xff]<<1 | spread[m3&0xff]<<2 | spread[m1&0xff]<<3;
+        uint64_t hi = spread[m0>>8] | spread[m2>>8]<<1 | spread[m3>>8]<<2 | spread[m1>>8]<<3;
+        std::memcpy(&m_nibbles[k], &lo, 8);
+        std::memcpy(&m_nibbles[k+8], &hi, 8);
+    }
+    for(; k<samples; k++)
+    {
+        m_nibbles[k] = (_rows[0][k] < _iso) | (_rows[2][k] < _iso)<<1 | (_rows[3][k] < _iso)<<2 | (_rows[1][k] < _iso)<<3;
+    }
+    return combine(_cells);
+#else
+    return classifyScalar(_rows, _cells, _iso);
+#endif
+}
+
+unsigned int RowClassifier::combine(unsigned int _cells)
+{
+    unsigned int n = 0;
+    for(unsigned int c=0; c<_cells; c+=8)
+    {
+        // every byte is below 16 so shifting the whole word can't carry into the next cell
+        uint64_t low, high;
+        std::memcpy(&low, &m_nibbles[c], 8);
+        std::memcpy(&high, &m_nibbles[c+1], 8);
+        uint64_t cubes = low | high<<4;
+        std::memcpy(&m_cubes[c], &cubes, 8);
+        // eight empty (or full) cells in a row is by far the most common case
+        if(c+8 <= _cells && (cubes == 0 || cubes == ~0ull))
+            continue;
+        unsigned int end = c+8 < _cells ? c+8 : _cells;
+        for(unsigned int k=c; k<end; k++)
+        {
+            if(m_cubes[k] != 0 && m_cubes[k] != 255)
+                m_active[n++] = k;
+        }
+    }
+    return n;
+}
+//----------------------------------------------------------------------------------------------------------------------
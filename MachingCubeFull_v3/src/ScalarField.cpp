@@ -0,0 +1,127 @@
+#include "ScalarField.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file ScalarField.cpp
+/// @brief analytic scalar field made of metaballs, sampled into a volume
+//----------------------------------------------------------------------------------------------------------------------
+
+void ScalarField::addMetaball(float _x, float _y, float _z, float _radius, float _strength)
+{
+    m_x.push_back(_x);
+    m_y.push_back(_y);
+    m_z.push_back(_z);
+    m_radius.push_back(_radius);
+    m_strength.push_back(_strength);
+}
+
+void ScalarField::clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_z.clear();
+    m_radius.clear();
+    m_strength.clear();
+}
+
+void ScalarField::sample(float *_out, unsigned int _width, unsigned int _height, unsigned int _depth, unsigned int _numThreads) const
+{
+    // every slice is written by exactly one thread so they need no locking
+    unsigned int nSlabs = std::max(1u, std::min(_numThreads, _depth));
+    if(nSlabs == 1)
+    {
+        sampleSlices(_out, _width, _height, _depth, 0, _depth);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for(unsigned int i=0;i<nSlabs;i++)
+    {
+        workers.push_back(std::thread(&ScalarField::sampleSlices, this, _out, _width, _height, _depth,
+                                      _depth*i/nSlabs, _depth*(i+1)/nSlabs));
+    }
+    for(unsigned int i=0;i<nSlabs;i++)
+    {
+        workers[i].join();
+    }
+}
+
+void ScalarField::sampleSlices(float *_out, unsigned int _width, unsigned int _height, unsigned int _depth,
+                               unsigned int _begin, unsigned int _end) const
+{
+    const size_t nBalls = m_radius.size();
+    const size_t sliceSize = (size_t)_width*_height;
+    // the balls reaching the current slice with what is left of their squared radius there, then the same for the row
+    std::vector<unsigned int> sliceBalls, rowBalls;
+    std::vector<float> sliceRest, rowRest;
+    sliceBalls.reserve(nBalls);
+    rowBalls.reserve(nBalls);
+    sliceRest.reserve(nBalls);
+    rowRest.reserve(nBalls);
+
+    for(unsigned int i=_begin;i<_end;i++)
+    {
+        float *slice = _out + i*sliceSize;
+        std::fill(slice, slice+sliceSize, 0.0f);
+        const float x = (float)i/_depth;
+        sliceBalls.clear();
+        sliceRest.clear();
+        for(size_t b=0;b<nBalls;b++)
+        {
+            const float dx = x-m_x[b];
+            const float rest = m_radius[b]*m_radius[b]-dx*dx;
+            if(rest > 0.0f)
+            {
+                sliceBalls.push_back(b);
+                sliceRest.push_back(rest);
+            }
+        }
+        if(sliceBalls.empty())
+            continue;
+        for(unsigned int j=0;j<_height;j++)
+        {
+            float *row = slice + (size_t)j*_width;
+            const float y = (float)j/_height;
+            rowBalls.clear();
+            rowRest.clear();
+            for(size_t s=0;s<sliceBalls.size();s++)
+            {
+                const float dy = y-m_y[sliceBalls[s]];
+                const float rest = sliceRest[s]-dy*dy;
+                if(rest > 0.0f)
+                {
+                    rowBalls.push_back(sliceBalls[s]);
+                    rowRest.push_back(rest);
+                }
+            }
+            for(size_t s=0;s<rowBalls.size();s++)
+            {
+                const unsigned int b = rowBalls[s];
+                const float z = m_z[b];
+                const float radius = m_radius[b];
+                const float strength = m_strength[b];
+                const float invRadius = 1.0f/radius;
+                const float invRadius2 = invRadius*invRadius;
+                const float offRow = radius*radius-rowRest[s];
+                // the samples of the row inside the ball, widened by one each side against rounding as
+                // the falloff is exactly zero from the radius on
+                const float reach = std::sqrt(rowRest[s]);
+                const int k0 = std::max(0, (int)std::floor((z-reach)*_width)-1);
+                const int k1 = std::min((int)_width-1, (int)std::ceil((z+reach)*_width)+1);
+                // same falloff as MachingCube::metaballFunc, written without branches so it vectorises
+                for(int k=k0;k<=k1;k++)
+                {
+                    const float dz = (float)k/_width-z;
+                    const float r2 = offRow+dz*dz;
+                    const float r = std::sqrt(r2);
+                    const float t = std::max(0.0f, 1.0f-r*invRadius);
+                    const float inner = strength*(1.0f-3.0f*r2*invRadius2);
+                    const float outer = 1.5f*strength*t*t;
+                    row[k] += r*3.0f <= radius ? inner : outer;
+                }
+            }
+        }
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------